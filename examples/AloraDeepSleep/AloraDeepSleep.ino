@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include <AloraSensorKit.h>
+
+// RTC GPIO wired to the DS3231 INT/SQW output, -1 to wake by the ESP32 timer,
+// which drifts by a few percent
+#define RTC_INT_PIN 33
+
+// keep the sensors powered during sleep: wake-ups skip the power-up delay and
+// CCS811 stays warm, at the cost of the sensor idle current
+#define KEEP_POWERED false
+
+// Use 13 for Alora board v2.2
+#define ENABLE_PIN 16
+
+// Use LOW for Alora board v2.2
+#define ENABLE_PIN_ACTIVE_LOGIC HIGH
+
+AloraSensorKit sensorKit(ENABLE_PIN, ENABLE_PIN_ACTIVE_LOGIC);
+AloraSleepScheduler scheduler;
+
+int8_t environmentTask;
+int8_t reportTask;
+
+void setup() {
+    Serial.begin(9600);
+
+    // read the environment every 5 minutes, report every hour 30 seconds after it
+    environmentTask = scheduler.addTask(300);
+    reportTask = scheduler.addTask(3600, 30);
+
+    // every wake-up starts here, begin() turns the rail back on and
+    // initializes only the BME280 (and the RTC), the rest waits for the report
+    sensorKit.setActiveSensors(ALORA_DEVICE_BME280);
+    sensorKit.begin();
+
+    uint32_t now = sensorKit.getTimestamp() / 1000000;
+
+    if (scheduler.isDue(environmentTask, now)) {
+        sensorKit.run();
+
+        SensorValues sensorData = sensorKit.getLastSensorData();
+        Serial.print("[ENV] T: ");
+        Serial.print(sensorData.T1);
+        Serial.print(" H: ");
+        Serial.println(sensorData.H1);
+    }
+
+    if (scheduler.isDue(reportTask, now)) {
+        // initialize the other sensors now, IMU and CCS811 take a moment to power up
+        sensorKit.setActiveSensors(ALORA_DEVICE_ALL);
+        while (!sensorKit.pollBegin()) {
+            delay(1);
+        }
+
+        sensorKit.run();
+
+        Serial.println("[REPORT] hourly report");
+        sensorKit.printSensingTo(Serial);
+    }
+
+    Serial.flush();
+
+    // does not return unless the clock is not set or the deadline is too close
+    if (!sensorKit.deepSleepUntil(scheduler.getNextDeadline(now), RTC_INT_PIN, KEEP_POWERED)) {
+        Serial.println("[SLEEP] Staying awake");
+    }
+}
+
+void loop() {
+    // deep sleep restarts through setup(), check again once in a while when staying awake
+    delay(1000);
+
+    uint32_t now = sensorKit.getTimestamp() / 1000000;
+    sensorKit.deepSleepUntil(scheduler.getNextDeadline(now), RTC_INT_PIN, KEEP_POWERED);
+}
@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include <AloraFFT.h>
+#include <AloraVibrationAnalyzer.h>
+
+// number of transforms for every measured size
+#define ITERATIONS 50
+
+int16_t real[ALORA_FFT_MAX_SIZE];
+int16_t imag[ALORA_FFT_MAX_SIZE];
+int16_t batch[3 * 32];
+AloraVibrationAnalyzer analyzer;
+
+// CPU cycle counter, estimated from micros() where no counter register is available
+uint32_t cycles() {
+#if defined(ESP32)
+    return ESP.getCycleCount();
+#else
+    return micros() * (F_CPU / 1000000);
+#endif
+}
+
+void fillTone(uint16_t size) {
+    for (uint16_t n = 0; n < size; n++) {
+        real[n] = (int16_t)(12000 * sinf(2.0f * PI * 37.0f * n / size));
+        imag[n] = 0;
+    }
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    for (uint16_t size = 256; size <= ALORA_FFT_MAX_SIZE; size *= 2) {
+        uint32_t windowCycles = 0;
+        uint32_t transformCycles = 0;
+
+        for (int i = 0; i < ITERATIONS; i++) {
+            fillTone(size);
+
+            uint32_t start = cycles();
+            AloraFFT::window(real, size);
+            windowCycles += cycles() - start;
+
+            start = cycles();
+            AloraFFT::transform(real, imag, size);
+            transformCycles += cycles() - start;
+        }
+
+        Serial.printf("%4u points: window %7lu cycles, transform %8lu cycles\n", size,
+            (unsigned long)(windowCycles / ITERATIONS), (unsigned long)(transformCycles / ITERATIONS));
+    }
+
+    // 120 Hz line of 0.05 g on X and 1 g gravity on Z at the default 2 g full scale
+    uint32_t analyzeCycles = 0;
+    uint16_t spectra = 0;
+    uint32_t n = 0;
+
+    while (spectra < 4) {
+        for (int i = 0; i < 32; i++, n++) {
+            batch[3 * i] = (int16_t)(0.05f * 16384 * sinf(2.0f * PI * 120.0f * n / (float) ALORA_VIBRATION_RATE_HZ));
+            batch[3 * i + 1] = 0;
+            batch[3 * i + 2] = 16384;
+        }
+
+        uint32_t start = cycles();
+        if (analyzer.addSamples(batch, 32)) {
+            analyzeCycles += cycles() - start;
+            spectra++;
+        }
+    }
+
+    const AloraVibrationFeatures& features = analyzer.getFeatures();
+    Serial.printf("%u-point 3-axis spectrum: %lu cycles\n", ALORA_VIBRATION_FFT_SIZE, (unsigned long)(analyzeCycles / spectra));
+    Serial.printf("rms %.4f g, peak %.2f Hz, amplitude %.4f g\n", features.rms, features.peakFrequency, features.peakAmplitude);
+
+    for (uint8_t band = 0; band < ALORA_VIBRATION_BANDS; band++) {
+        Serial.printf("band from %6.1f Hz: %.3e g^2\n", analyzer.getBandStart(band), features.bandEnergy[band]);
+    }
+}
+
+void loop() {
+}
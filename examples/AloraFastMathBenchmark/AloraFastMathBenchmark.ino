@@ -0,0 +1,90 @@
+#include <Arduino.h>
+#include <AloraFastMath.h>
+
+// number of calls for every measured function
+#define ITERATIONS 20000
+
+float inputsX[64];
+float inputsY[64];
+volatile float floatSink;
+volatile int32_t intSink;
+
+// print average nanoseconds per call
+void printResult(const char* name, uint32_t elapsedMicros) {
+    Serial.printf("%-24s %8.1f ns/call\n", name, (elapsedMicros * 1000.0) / ITERATIONS);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    for (int i = 0; i < 64; i++) {
+        inputsX[i] = cosf(i * 0.1f) * (i + 1);
+        inputsY[i] = sinf(i * 0.37f) * (i + 3);
+    }
+
+    uint32_t start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = atan2f(inputsY[i & 63], inputsX[i & 63]);
+    }
+    printResult("libm atan2f", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = AloraFastMath::atan2(inputsY[i & 63], inputsX[i & 63]);
+    }
+    printResult("AloraFastMath::atan2", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        intSink = AloraFastMath::atan2Q15((int16_t)(inputsY[i & 63] * 256), (int16_t)(inputsX[i & 63] * 256));
+    }
+    printResult("AloraFastMath::atan2Q15", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = 1.0f / sqrtf(inputsX[i & 63] * inputsX[i & 63] + 1.0f);
+    }
+    printResult("libm 1 / sqrtf", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = AloraFastMath::invSqrt(inputsX[i & 63] * inputsX[i & 63] + 1.0f);
+    }
+    printResult("AloraFastMath::invSqrt", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = sqrtf(inputsX[i & 63] * inputsX[i & 63] + 1.0f);
+    }
+    printResult("libm sqrtf", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        floatSink = AloraFastMath::sqrt(inputsX[i & 63] * inputsX[i & 63] + 1.0f);
+    }
+    printResult("AloraFastMath::sqrt", micros() - start);
+
+    start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        intSink = AloraFastMath::magnitude((int16_t)(inputsX[i & 63] * 256), (int16_t)(inputsY[i & 63] * 256), 16384);
+    }
+    printResult("AloraFastMath::magnitude", micros() - start);
+
+    // maximum error of the float kernels against libm
+    float atanError = 0.0f;
+    float invSqrtError = 0.0f;
+    for (int i = 0; i < 64; i++) {
+        float error = fabsf(AloraFastMath::atan2(inputsY[i], inputsX[i]) - atan2f(inputsY[i], inputsX[i]));
+        atanError = error > atanError ? error : atanError;
+
+        float value = inputsX[i] * inputsX[i] + 1.0f;
+        error = fabsf(AloraFastMath::invSqrt(value) * sqrtf(value) - 1.0f);
+        invSqrtError = error > invSqrtError ? error : invSqrtError;
+    }
+
+    Serial.printf("atan2 max error: %.2e rad\n", atanError);
+    Serial.printf("invSqrt max relative error: %.2e\n", invSqrtError);
+}
+
+void loop() {
+}
@@ -34,6 +34,11 @@ void setup() {
 
     sensorKit.begin();
     sensorKit.initGPS(&gpsSerial);
+
+    // keep only GGA and RMC, switch the receiver and the UART to 115200 baud
+    if (!sensorKit.configureGPS(&gpsSerial)) {
+        Serial.println("[GPS] Receiver did not answer at the new baud rate, staying at 9600");
+    }
 }
 
 void loop() {
@@ -105,6 +105,15 @@ boolean Adafruit_TSL2591::begin(void)
   return true;
 }
 
+// Take over a sensor that stayed powered, with the integration time and gain
+// it was set to, without the register writes of begin()
+void Adafruit_TSL2591::resume(tsl2591IntegrationTime_t integration, tsl2591Gain_t gain)
+{
+  _integration = integration;
+  _gain        = gain;
+  _initialized = true;
+}
+
 void Adafruit_TSL2591::enable(void)
 {
   if (!_initialized)
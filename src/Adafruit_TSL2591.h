@@ -123,6 +123,7 @@ class Adafruit_TSL2591 : public Adafruit_Sensor
   Adafruit_TSL2591(int32_t sensorID = -1);
   
   boolean   begin   ( void );
+  void      resume  ( tsl2591IntegrationTime_t integration, tsl2591Gain_t gain );
   void      enable  ( void );
   void      disable ( void );
   void      write8  ( uint8_t r, uint8_t v );
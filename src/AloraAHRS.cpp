@@ -0,0 +1,489 @@
+/** @file */
+
+#include "AloraAHRS.h"
+#include "AloraFastMath.h"
+
+/** Degrees to radians conversion factor */
+#define ALORA_AHRS_DEG_TO_RAD 0.0174532925f
+
+/** Radians to degrees conversion factor */
+#define ALORA_AHRS_RAD_TO_DEG 57.2957795f
+
+/**
+ * @brief Instantiate orientation filter
+ *
+ * @param algorithm either ALORA_AHRS_MADGWICK or ALORA_AHRS_MAHONY
+ */
+AloraAHRS::AloraAHRS(uint8_t algorithm):
+ algorithm(algorithm),
+ beta(ALORA_AHRS_MADGWICK_BETA),
+ kp(ALORA_AHRS_MAHONY_KP),
+ ki(ALORA_AHRS_MAHONY_KI),
+ updateMicros(0) {
+    reset();
+}
+
+/**
+ * @brief Reset orientation to identity and clear the integral feedback
+ *
+ */
+void AloraAHRS::reset() {
+    q0 = 1.0f;
+    q1 = 0.0f;
+    q2 = 0.0f;
+    q3 = 0.0f;
+    initialized = false;
+    integralX = 0.0f;
+    integralY = 0.0f;
+    integralZ = 0.0f;
+}
+
+/**
+ * @brief Select the filter algorithm
+ *
+ * @param algorithm either ALORA_AHRS_MADGWICK or ALORA_AHRS_MAHONY
+ */
+void AloraAHRS::setAlgorithm(uint8_t algorithm) {
+    this->algorithm = algorithm;
+}
+
+/**
+ * @brief Set Madgwick filter gain
+ *
+ * @param beta gradient descent step gain
+ */
+void AloraAHRS::setMadgwickGain(float beta) {
+    this->beta = beta;
+}
+
+/**
+ * @brief Set Mahony filter gains
+ *
+ * @param kp proportional gain
+ * @param ki integral gain
+ */
+void AloraAHRS::setMahonyGains(float kp, float ki) {
+    this->kp = kp;
+    this->ki = ki;
+}
+
+/**
+ * @brief Fuse one gyroscope, accelerometer and magnetometer sample.
+ * All vectors must be expressed in the same body frame.
+ *
+ * @param gx gyroscope X axis in degrees per second
+ * @param gy gyroscope Y axis in degrees per second
+ * @param gz gyroscope Z axis in degrees per second
+ * @param ax accelerometer X axis in any unit
+ * @param ay accelerometer Y axis in any unit
+ * @param az accelerometer Z axis in any unit
+ * @param mx magnetometer X axis in any unit
+ * @param my magnetometer Y axis in any unit
+ * @param mz magnetometer Z axis in any unit
+ * @param dt time elapsed since the previous sample in seconds
+ */
+void AloraAHRS::update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt) {
+    uint32_t startMicros = micros();
+
+    // start from the attitude measured by the first sample instead of converging from identity
+    if (!initialized) {
+        if ((ax != 0.0f) || (ay != 0.0f) || (az != 0.0f)) {
+            initFromVectors(ax, ay, az, mx, my, mz);
+        }
+
+        updateMicros = micros() - startMicros;
+        return;
+    }
+
+    gx *= ALORA_AHRS_DEG_TO_RAD;
+    gy *= ALORA_AHRS_DEG_TO_RAD;
+    gz *= ALORA_AHRS_DEG_TO_RAD;
+
+    // without a magnetic reference only roll and pitch can be corrected
+    if ((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f)) {
+        if (algorithm == ALORA_AHRS_MAHONY) {
+            mahonyUpdateIMU(gx, gy, gz, ax, ay, az, dt);
+        } else {
+            madgwickUpdateIMU(gx, gy, gz, ax, ay, az, dt);
+        }
+    } else {
+        if (algorithm == ALORA_AHRS_MAHONY) {
+            mahonyUpdate(gx, gy, gz, ax, ay, az, mx, my, mz, dt);
+        } else {
+            madgwickUpdate(gx, gy, gz, ax, ay, az, mx, my, mz, dt);
+        }
+    }
+
+    updateMicros = micros() - startMicros;
+}
+
+/**
+ * @brief Fuse one gyroscope and accelerometer sample. Heading is not corrected.
+ *
+ * @param gx gyroscope X axis in degrees per second
+ * @param gy gyroscope Y axis in degrees per second
+ * @param gz gyroscope Z axis in degrees per second
+ * @param ax accelerometer X axis in any unit
+ * @param ay accelerometer Y axis in any unit
+ * @param az accelerometer Z axis in any unit
+ * @param dt time elapsed since the previous sample in seconds
+ */
+void AloraAHRS::updateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    update(gx, gy, gz, ax, ay, az, 0.0f, 0.0f, 0.0f, dt);
+}
+
+void AloraAHRS::initFromVectors(float ax, float ay, float az, float mx, float my, float mz) {
+    float roll = AloraFastMath::atan2(ay, az);
+    float pitch = AloraFastMath::atan2(-ax, AloraFastMath::sqrt(ay * ay + az * az));
+    float yaw = 0.0f;
+
+    if ((mx != 0.0f) || (my != 0.0f) || (mz != 0.0f)) {
+        // rotate the magnetic field back to the horizontal plane
+        float bx = mx * cosf(pitch) + my * sinf(pitch) * sinf(roll) + mz * sinf(pitch) * cosf(roll);
+        float by = my * cosf(roll) - mz * sinf(roll);
+        yaw = AloraFastMath::atan2(-by, bx);
+    }
+
+    float cr = cosf(roll * 0.5f);
+    float sr = sinf(roll * 0.5f);
+    float cp = cosf(pitch * 0.5f);
+    float sp = sinf(pitch * 0.5f);
+    float cy = cosf(yaw * 0.5f);
+    float sy = sinf(yaw * 0.5f);
+
+    q0 = cr * cp * cy + sr * sp * sy;
+    q1 = sr * cp * cy - cr * sp * sy;
+    q2 = cr * sp * cy + sr * cp * sy;
+    q3 = cr * cp * sy - sr * sp * cy;
+    initialized = true;
+}
+
+void AloraAHRS::madgwickUpdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt) {
+    // rate of change of quaternion from gyroscope
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recipNorm = AloraFastMath::invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        recipNorm = AloraFastMath::invSqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        float _2q0mx = 2.0f * q0 * mx;
+        float _2q0my = 2.0f * q0 * my;
+        float _2q0mz = 2.0f * q0 * mz;
+        float _2q1mx = 2.0f * q1 * mx;
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _2q0q2 = 2.0f * q0 * q2;
+        float _2q2q3 = 2.0f * q2 * q3;
+        float q0q0 = q0 * q0;
+        float q0q1 = q0 * q1;
+        float q0q2 = q0 * q2;
+        float q0q3 = q0 * q3;
+        float q1q1 = q1 * q1;
+        float q1q2 = q1 * q2;
+        float q1q3 = q1 * q3;
+        float q2q2 = q2 * q2;
+        float q2q3 = q2 * q3;
+        float q3q3 = q3 * q3;
+
+        // reference direction of earth's magnetic field
+        float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+        float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+        float _2bx = AloraFastMath::sqrt(hx * hx + hy * hy);
+        float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+        float _4bx = 2.0f * _2bx;
+        float _4bz = 2.0f * _2bz;
+
+        // gradient descent corrective step
+        float fax = 2.0f * q1q3 - _2q0q2 - ax;
+        float fay = 2.0f * q0q1 + _2q2q3 - ay;
+        float faz = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+        float fmx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+        float fmy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+        float fmz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+        float s0 = -_2q2 * fax + _2q1 * fay - _2bz * q2 * fmx + (-_2bx * q3 + _2bz * q1) * fmy + _2bx * q2 * fmz;
+        float s1 = _2q3 * fax + _2q0 * fay - 4.0f * q1 * faz + _2bz * q3 * fmx + (_2bx * q2 + _2bz * q0) * fmy + (_2bx * q3 - _4bz * q1) * fmz;
+        float s2 = -_2q0 * fax + _2q3 * fay - 4.0f * q2 * faz + (-_4bx * q2 - _2bz * q0) * fmx + (_2bx * q1 + _2bz * q3) * fmy + (_2bx * q0 - _4bz * q2) * fmz;
+        float s3 = _2q1 * fax + _2q2 * fay + (-_4bx * q3 + _2bz * q1) * fmx + (-_2bx * q0 + _2bz * q2) * fmy + _2bx * q1 * fmz;
+
+        float normS = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (normS > 0.0f) {
+            recipNorm = AloraFastMath::invSqrt(normS);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    normalizeQuaternion();
+}
+
+void AloraAHRS::madgwickUpdateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recipNorm = AloraFastMath::invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0;
+        float _4q1 = 4.0f * q1;
+        float _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1;
+        float _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0;
+        float q1q1 = q1 * q1;
+        float q2q2 = q2 * q2;
+        float q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        float normS = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (normS > 0.0f) {
+            recipNorm = AloraFastMath::invSqrt(normS);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    normalizeQuaternion();
+}
+
+void AloraAHRS::mahonyUpdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt) {
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recipNorm = AloraFastMath::invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        recipNorm = AloraFastMath::invSqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        float q0q0 = q0 * q0;
+        float q0q1 = q0 * q1;
+        float q0q2 = q0 * q2;
+        float q0q3 = q0 * q3;
+        float q1q1 = q1 * q1;
+        float q1q2 = q1 * q2;
+        float q1q3 = q1 * q3;
+        float q2q2 = q2 * q2;
+        float q2q3 = q2 * q3;
+        float q3q3 = q3 * q3;
+
+        // reference direction of earth's magnetic field
+        float hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+        float hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+        float bx = AloraFastMath::sqrt(hx * hx + hy * hy);
+        float bz = 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+
+        // estimated direction of gravity and magnetic field
+        float halfvx = q1q3 - q0q2;
+        float halfvy = q0q1 + q2q3;
+        float halfvz = q0q0 - 0.5f + q3q3;
+        float halfwx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+        float halfwy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+        float halfwz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+
+        // error is the cross product between estimated and measured directions
+        float halfex = (ay * halfvz - az * halfvy) + (my * halfwz - mz * halfwy);
+        float halfey = (az * halfvx - ax * halfvz) + (mz * halfwx - mx * halfwz);
+        float halfez = (ax * halfvy - ay * halfvx) + (mx * halfwy - my * halfwx);
+
+        if (ki > 0.0f) {
+            integralX += 2.0f * ki * halfex * dt;
+            integralY += 2.0f * ki * halfey * dt;
+            integralZ += 2.0f * ki * halfez * dt;
+            gx += integralX;
+            gy += integralY;
+            gz += integralZ;
+        } else {
+            integralX = 0.0f;
+            integralY = 0.0f;
+            integralZ = 0.0f;
+        }
+
+        gx += 2.0f * kp * halfex;
+        gy += 2.0f * kp * halfey;
+        gz += 2.0f * kp * halfez;
+    }
+
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+
+    float qa = q0;
+    float qb = q1;
+    float qc = q2;
+    q0 += (-qb * gx - qc * gy - q3 * gz);
+    q1 += (qa * gx + qc * gz - q3 * gy);
+    q2 += (qa * gy - qb * gz + q3 * gx);
+    q3 += (qa * gz + qb * gy - qc * gx);
+
+    normalizeQuaternion();
+}
+
+void AloraAHRS::mahonyUpdateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recipNorm = AloraFastMath::invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        float halfvx = q1 * q3 - q0 * q2;
+        float halfvy = q0 * q1 + q2 * q3;
+        float halfvz = q0 * q0 - 0.5f + q3 * q3;
+
+        float halfex = (ay * halfvz - az * halfvy);
+        float halfey = (az * halfvx - ax * halfvz);
+        float halfez = (ax * halfvy - ay * halfvx);
+
+        if (ki > 0.0f) {
+            integralX += 2.0f * ki * halfex * dt;
+            integralY += 2.0f * ki * halfey * dt;
+            integralZ += 2.0f * ki * halfez * dt;
+            gx += integralX;
+            gy += integralY;
+            gz += integralZ;
+        } else {
+            integralX = 0.0f;
+            integralY = 0.0f;
+            integralZ = 0.0f;
+        }
+
+        gx += 2.0f * kp * halfex;
+        gy += 2.0f * kp * halfey;
+        gz += 2.0f * kp * halfez;
+    }
+
+    gx *= 0.5f * dt;
+    gy *= 0.5f * dt;
+    gz *= 0.5f * dt;
+
+    float qa = q0;
+    float qb = q1;
+    float qc = q2;
+    q0 += (-qb * gx - qc * gy - q3 * gz);
+    q1 += (qa * gx + qc * gz - q3 * gy);
+    q2 += (qa * gy - qb * gz + q3 * gx);
+    q3 += (qa * gz + qb * gy - qc * gx);
+
+    normalizeQuaternion();
+}
+
+void AloraAHRS::normalizeQuaternion() {
+    float recipNorm = AloraFastMath::invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q0 *= recipNorm;
+    q1 *= recipNorm;
+    q2 *= recipNorm;
+    q3 *= recipNorm;
+}
+
+/**
+ * @brief Get the orientation quaternion
+ *
+ * @param w scalar part will be stored in this variable
+ * @param x X component will be stored in this variable
+ * @param y Y component will be stored in this variable
+ * @param z Z component will be stored in this variable
+ */
+void AloraAHRS::getQuaternion(float& w, float& x, float& y, float& z) {
+    w = q0;
+    x = q1;
+    y = q2;
+    z = q3;
+}
+
+/**
+ * @brief Get roll angle
+ *
+ * @return float roll in degrees, -180 to 180
+ */
+float AloraAHRS::getRoll() {
+    return AloraFastMath::atan2(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * ALORA_AHRS_RAD_TO_DEG;
+}
+
+/**
+ * @brief Get pitch angle
+ *
+ * @return float pitch in degrees, -90 to 90
+ */
+float AloraAHRS::getPitch() {
+    float sinPitch = -2.0f * (q1 * q3 - q0 * q2);
+    if (sinPitch > 1.0f) {
+        sinPitch = 1.0f;
+    } else if (sinPitch < -1.0f) {
+        sinPitch = -1.0f;
+    }
+
+    return asinf(sinPitch) * ALORA_AHRS_RAD_TO_DEG;
+}
+
+/**
+ * @brief Get yaw angle, counter-clockwise from magnetic north
+ *
+ * @return float yaw in degrees, -180 to 180
+ */
+float AloraAHRS::getYaw() {
+    return AloraFastMath::atan2(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3) * ALORA_AHRS_RAD_TO_DEG;
+}
+
+/**
+ * @brief Get tilt-compensated compass heading, clockwise from magnetic north
+ *
+ * @return float heading in degrees, 0 to 360
+ */
+float AloraAHRS::getHeading() {
+    float heading = 360.0f - getYaw();
+    if (heading >= 360.0f) {
+        heading -= 360.0f;
+    }
+
+    return heading;
+}
+
+/**
+ * @brief Get the duration of the last filter update
+ *
+ * @return uint32_t update cost in microseconds
+ */
+uint32_t AloraAHRS::getUpdateMicros() {
+    return updateMicros;
+}
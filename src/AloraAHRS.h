@@ -0,0 +1,78 @@
+/** @file */
+
+#ifndef ALORA_AHRS_H
+#define ALORA_AHRS_H
+
+#include <Arduino.h>
+
+/** Madgwick gradient descent orientation filter */
+#define ALORA_AHRS_MADGWICK 0
+
+/** Mahony explicit complementary orientation filter */
+#define ALORA_AHRS_MAHONY 1
+
+/** Choose the orientation filter algorithm. Uses Madgwick by default */
+#if !defined(ALORA_AHRS_ALGORITHM)
+    #define ALORA_AHRS_ALGORITHM ALORA_AHRS_MADGWICK
+#endif
+
+/** Madgwick filter gain. Higher value converges faster but is noisier */
+#if !defined(ALORA_AHRS_MADGWICK_BETA)
+    #define ALORA_AHRS_MADGWICK_BETA 0.1f
+#endif
+
+/** Mahony filter proportional gain */
+#if !defined(ALORA_AHRS_MAHONY_KP)
+    #define ALORA_AHRS_MAHONY_KP 1.0f
+#endif
+
+/** Mahony filter integral gain. Set to 0 to disable gyro bias estimation */
+#if !defined(ALORA_AHRS_MAHONY_KI)
+    #define ALORA_AHRS_MAHONY_KI 0.0f
+#endif
+
+/**
+ * @brief Attitude and heading reference system.
+ *
+ * Fuses gyroscope, accelerometer and magnetometer samples into an orientation
+ * quaternion. Every update performs a fixed amount of work, and its cost is
+ * recorded so it can be checked against the IMU sample period.
+ */
+class AloraAHRS {
+public:
+    AloraAHRS(uint8_t algorithm = ALORA_AHRS_ALGORITHM);
+
+    void reset();
+    void setAlgorithm(uint8_t algorithm);
+    void setMadgwickGain(float beta);
+    void setMahonyGains(float kp, float ki);
+
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt);
+    void updateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+    void getQuaternion(float& w, float& x, float& y, float& z);
+    float getRoll();
+    float getPitch();
+    float getYaw();
+    float getHeading();
+    uint32_t getUpdateMicros();
+
+private:
+    uint8_t algorithm;                      /**< ALORA_AHRS_MADGWICK or ALORA_AHRS_MAHONY */
+    float q0, q1, q2, q3;                   /**< Orientation quaternion of the sensor frame relative to the earth frame */
+    bool initialized;                       /**< Whether the quaternion has been seeded from a measured attitude */
+    float beta;                             /**< Madgwick filter gain */
+    float kp;                               /**< Mahony proportional gain */
+    float ki;                               /**< Mahony integral gain */
+    float integralX, integralY, integralZ;  /**< Mahony integral feedback terms */
+    uint32_t updateMicros;                  /**< Duration of the last update in microseconds */
+
+    void madgwickUpdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt);
+    void madgwickUpdateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+    void mahonyUpdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt);
+    void mahonyUpdateIMU(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+    void initFromVectors(float ax, float ay, float az, float mx, float my, float mz);
+    void normalizeQuaternion();
+};
+
+#endif
@@ -0,0 +1,205 @@
+/** @file */
+
+#include "AloraClock.h"
+
+AloraClock::AloraClock() {
+    reset();
+}
+
+/**
+ * @brief Forget the time, the next reference sets the clock
+ */
+void AloraClock::reset() {
+    set = false;
+    origin = 0;
+    localOrigin = 0;
+    ratePpb = 0;
+    slewPpb = 0;
+    slewDuration = 0;
+    anchorReference = 0;
+    anchorLocal = 0;
+    anchored = false;
+    lastMicros = micros();
+    wraps = 0;
+    lastTime = 0;
+    accuracy = 0;
+    rateKnown = false;
+}
+
+/**
+ * @brief Check whether a reference set the clock
+ *
+ * @return true if now() returns UTC time
+ */
+bool AloraClock::isSet() {
+    return set;
+}
+
+/**
+ * @brief Get current time
+ *
+ * @return uint64_t UTC time in microseconds since 1970, 0 if the clock is not set
+ */
+uint64_t AloraClock::now() {
+    if (!set) {
+        extend(micros());
+        return 0;
+    }
+
+    uint64_t time = timeAt(extend(micros()));
+
+    // a step backwards holds the clock until it caught up
+    if (time < lastTime) {
+        return lastTime;
+    }
+
+    lastTime = time;
+
+    return time;
+}
+
+/**
+ * @brief Convert a recent micros() timestamp, for example of a sensor
+ * sample, to UTC time
+ *
+ * @param timestamp micros() at most one wrap, about 71 minutes, in the past
+ * @return uint64_t UTC time in microseconds since 1970, 0 if the clock is not set
+ */
+uint64_t AloraClock::toTime(uint32_t timestamp) {
+    uint64_t local = extend(micros());
+
+    if (!set) {
+        return 0;
+    }
+
+    return timeAt(local - (uint32_t) ((uint32_t) local - timestamp));
+}
+
+/**
+ * @brief Correct the clock with a reference time
+ *
+ * @param reference UTC time in microseconds since 1970
+ * @param timestamp micros() when the reference was valid, at most one wrap in the past
+ * @param tolerance resolution of the reference in microseconds, 0 for an exact reference that also trains the frequency
+ */
+void AloraClock::correct(uint64_t reference, uint32_t timestamp, uint32_t tolerance) {
+    uint64_t now = extend(micros());
+    uint64_t local = now - (uint32_t) ((uint32_t) now - timestamp);
+    uint64_t time = timeAt(local);
+    int64_t error = (int64_t) (reference - time);
+    uint32_t magnitude = (uint32_t) (error < 0 ? -error : error);
+
+    if (!set || error > ALORA_CLOCK_STEP_US + (int64_t) tolerance || error < -(ALORA_CLOCK_STEP_US + (int64_t) tolerance)) {
+        origin = reference;
+        localOrigin = local;
+        slewPpb = 0;
+        slewDuration = 0;
+        anchored = false;
+        set = true;
+        accuracy = tolerance;
+
+        if (tolerance == 0) {
+            anchorReference = reference;
+            anchorLocal = local;
+            anchored = true;
+        }
+
+        return;
+    }
+
+    // a coarse reference only tells the clock is outside its resolution
+    if (tolerance > 0) {
+        if (error <= (int64_t) tolerance && error >= -(int64_t) tolerance) {
+            return;
+        }
+
+        error += error > 0 ? -(int64_t) tolerance : (int64_t) tolerance;
+        accuracy = tolerance;
+    } else if (!anchored) {
+        anchorReference = reference;
+        anchorLocal = local;
+        anchored = true;
+    } else {
+        uint64_t baseline = local - anchorLocal;
+
+        if (baseline >= ALORA_CLOCK_MIN_BASELINE_S * 1000000ULL) {
+            int64_t drift = (int64_t) (reference - anchorReference) - (int64_t) baseline;
+            int64_t rate = drift * 1000000000LL / (int64_t) baseline;
+            const int64_t limit = ALORA_CLOCK_MAX_PPM * 1000LL;
+
+            ratePpb = (int32_t) (rate > limit ? limit : (rate < -limit ? -limit : rate));
+            rateKnown = true;
+
+            if (baseline >= ALORA_CLOCK_MAX_BASELINE_S * 1000000ULL) {
+                anchorReference = reference;
+                anchorLocal = local;
+            }
+        }
+    }
+
+    // exact references are as good as their scatter
+    if (tolerance == 0) {
+        accuracy = accuracy == 0 ? magnitude : (3 * accuracy + magnitude) / 4;
+    }
+
+    // continue from the current time and slew the error out
+    const int64_t duration = ALORA_CLOCK_SLEW_S * 1000000LL;
+    const int64_t limit = ALORA_CLOCK_MAX_PPM * 1000LL;
+    int64_t slew = error * 1000000000LL / duration;
+
+    origin = time;
+    localOrigin = local;
+    slewPpb = (int32_t) (slew > limit ? limit : (slew < -limit ? -limit : slew));
+    slewDuration = duration;
+}
+
+/**
+ * @brief Get the estimated frequency error of micros()
+ *
+ * @return int32_t correction in parts per billion, positive if micros() runs slow
+ */
+int32_t AloraClock::getRatePpb() {
+    return ratePpb;
+}
+
+/**
+ * @brief Estimate the clock error at a point in time, from the last
+ * reference and the drift since
+ *
+ * @param timestamp micros() at most one wrap in the past
+ * @return uint32_t error estimate in microseconds, UINT32_MAX if the clock is not set
+ */
+uint32_t AloraClock::getError(uint32_t timestamp) {
+    uint64_t now = extend(micros());
+
+    if (!set) {
+        return UINT32_MAX;
+    }
+
+    uint64_t local = now - (uint32_t) ((uint32_t) now - timestamp);
+    int64_t elapsed = (int64_t) (local - localOrigin);
+    uint64_t drift = (uint64_t) (elapsed < 0 ? -elapsed : elapsed) * (rateKnown ? ALORA_CLOCK_HOLDOVER_PPM : ALORA_CLOCK_DRIFT_PPM) / 1000000ULL;
+    uint64_t error = accuracy + drift;
+
+    return error > UINT32_MAX ? UINT32_MAX : (uint32_t) error;
+}
+
+/**
+ * @brief Extend a micros() value taken now to 64 bits
+ */
+uint64_t AloraClock::extend(uint32_t timestamp) {
+    if (timestamp < lastMicros) {
+        wraps++;
+    }
+
+    lastMicros = timestamp;
+
+    return ((uint64_t) wraps << 32) | timestamp;
+}
+
+uint64_t AloraClock::timeAt(uint64_t local) {
+    int64_t elapsed = (int64_t) (local - localOrigin);
+    int64_t slewed = elapsed < (int64_t) slewDuration ? elapsed : (int64_t) slewDuration;
+
+    return origin + elapsed + elapsed * ratePpb / 1000000000LL + slewed * slewPpb / 1000000000LL;
+}
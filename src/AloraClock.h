@@ -0,0 +1,91 @@
+/** @file */
+
+#ifndef ALORA_CLOCK_H
+#define ALORA_CLOCK_H
+
+#include <Arduino.h>
+
+/** Clock error in microseconds above which a correction steps the clock instead of slewing it */
+#if !defined(ALORA_CLOCK_STEP_US)
+    #define ALORA_CLOCK_STEP_US 500000
+#endif
+
+/** Time in seconds over which a clock error is slewed out */
+#if !defined(ALORA_CLOCK_SLEW_S)
+    #define ALORA_CLOCK_SLEW_S 10
+#endif
+
+/** Largest slew and frequency correction in parts per million */
+#if !defined(ALORA_CLOCK_MAX_PPM)
+    #define ALORA_CLOCK_MAX_PPM 500
+#endif
+
+/** Shortest time in seconds between two exact references before the frequency is estimated */
+#if !defined(ALORA_CLOCK_MIN_BASELINE_S)
+    #define ALORA_CLOCK_MIN_BASELINE_S 300
+#endif
+
+/** Longest time in seconds the frequency estimate averages over, follows temperature drift */
+#if !defined(ALORA_CLOCK_MAX_BASELINE_S)
+    #define ALORA_CLOCK_MAX_BASELINE_S 3600
+#endif
+
+/** Frequency error of micros() in parts per million before exact references estimated it */
+#if !defined(ALORA_CLOCK_DRIFT_PPM)
+    #define ALORA_CLOCK_DRIFT_PPM 50
+#endif
+
+/** Frequency stability of micros() in parts per million once the frequency error is estimated */
+#if !defined(ALORA_CLOCK_HOLDOVER_PPM)
+    #define ALORA_CLOCK_HOLDOVER_PPM 2
+#endif
+
+/**
+ * @brief Software UTC clock running on micros() and disciplined by external
+ * references.
+ *
+ * Reading it costs no bus transaction. micros() is extended to 64 bits, so
+ * now() must be called at least once per micros() wrap, about every 71
+ * minutes. The first reference sets the clock. Later references are slewed
+ * in over ALORA_CLOCK_SLEW_S, so the clock stays continuous and now() never
+ * goes backwards. Errors beyond ALORA_CLOCK_STEP_US step the clock.
+ *
+ * Exact references (GPS PPS) also estimate the frequency error of the CPU
+ * crystal over a baseline between ALORA_CLOCK_MIN_BASELINE_S and
+ * ALORA_CLOCK_MAX_BASELINE_S, so the clock holds its rate between them.
+ * Coarse references (RTC seconds, NMEA time) only correct errors beyond
+ * their resolution.
+ */
+class AloraClock {
+public:
+    AloraClock();
+
+    void reset();
+    bool isSet();
+    uint64_t now();
+    uint64_t toTime(uint32_t timestamp);
+    void correct(uint64_t reference, uint32_t timestamp, uint32_t tolerance = 0);
+    int32_t getRatePpb();
+    uint32_t getError(uint32_t timestamp);
+
+private:
+    bool set;                               /**< Whether a reference set the clock */
+    uint64_t origin;                        /**< Clock time at localOrigin in us since 1970 */
+    uint64_t localOrigin;                   /**< Extended micros() of the last correction */
+    int32_t ratePpb;                        /**< Frequency correction in parts per billion */
+    int32_t slewPpb;                        /**< Additional rate slewing out the last error */
+    uint32_t slewDuration;                  /**< Time in us the slew applies after localOrigin */
+    uint64_t anchorReference;               /**< Exact reference starting the frequency baseline */
+    uint64_t anchorLocal;                   /**< Extended micros() of anchorReference */
+    bool anchored;                          /**< Whether the frequency baseline started */
+    uint32_t lastMicros;                    /**< micros() at the last extension */
+    uint32_t wraps;                         /**< Number of micros() wraps */
+    uint64_t lastTime;                      /**< Last value returned by now() */
+    uint32_t accuracy;                      /**< Error estimate in us at localOrigin */
+    bool rateKnown;                         /**< Whether ratePpb was estimated */
+
+    uint64_t extend(uint32_t timestamp);
+    uint64_t timeAt(uint64_t local);
+};
+
+#endif
@@ -0,0 +1,136 @@
+/** @file */
+
+#include "AloraDecimator.h"
+#include <math.h>
+
+AloraDecimator::AloraDecimator():
+ head(0),
+ factor(1),
+ phase(0) {
+    reset();
+}
+
+/**
+ * @brief Design the anti-alias filter for a decimation factor and clear the
+ * filter state
+ *
+ * @param factor number of input samples per output sample, 1 to ALORA_DECIMATOR_MAX_FACTOR
+ * @return true if the factor is supported
+ */
+bool AloraDecimator::setFactor(uint8_t factor) {
+    if (factor == 0 || factor > ALORA_DECIMATOR_MAX_FACTOR) {
+        return false;
+    }
+
+    this->factor = factor;
+    reset();
+
+    if (factor == 1) {
+        return true;
+    }
+
+    uint16_t taps = factor * ALORA_DECIMATOR_PHASE_TAPS;
+    float center = (taps - 1) * 0.5f;
+    float cutoff = 0.5f / factor;
+    float design[ALORA_DECIMATOR_MAX_FACTOR * ALORA_DECIMATOR_PHASE_TAPS];
+    float sum = 0.0f;
+
+    for (uint16_t k = 0; k < taps; k++) {
+        float t = k - center;
+        float sinc = t == 0.0f ? 1.0f : sinf(2.0f * (float) M_PI * cutoff * t) / (2.0f * (float) M_PI * cutoff * t);
+        float window = 0.54f - 0.46f * cosf(2.0f * (float) M_PI * k / (taps - 1));
+
+        design[k] = sinc * window;
+        sum += design[k];
+    }
+
+    // quantize for unity DC gain, the rounding error goes to the middle tap
+    int32_t total = 0;
+    for (uint16_t k = 0; k < taps; k++) {
+        coefficients[k] = (int16_t) lroundf(design[k] / sum * 32768.0f);
+        total += coefficients[k];
+    }
+
+    coefficients[taps / 2] += 32768 - total;
+
+    return true;
+}
+
+/**
+ * @brief Get decimation factor
+ *
+ * @return uint8_t number of input samples per output sample
+ */
+uint8_t AloraDecimator::getFactor() {
+    return factor;
+}
+
+/**
+ * @brief Clear the filter state, the next input starts a new output period
+ */
+void AloraDecimator::reset() {
+    for (uint8_t j = 0; j < ALORA_DECIMATOR_PHASE_TAPS; j++) {
+        sums[j][0] = 0;
+        sums[j][1] = 0;
+        sums[j][2] = 0;
+    }
+
+    head = 0;
+    phase = 0;
+}
+
+/**
+ * @brief Filter and decimate a batch in place
+ *
+ * @param raw interleaved raw triples, 3 * count values. The output triples are written to the start
+ * @param count number of input triples
+ * @return uint16_t number of output triples
+ */
+uint16_t AloraDecimator::process(int16_t* raw, uint16_t count) {
+    if (factor == 1) {
+        return count;
+    }
+
+    uint16_t outputs = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t x = raw[3 * i];
+        int32_t y = raw[3 * i + 1];
+        int32_t z = raw[3 * i + 2];
+
+        // lag behind the end of the current output period selects the tap of every branch
+        const int16_t* tap = &coefficients[factor - 1 - phase];
+        uint8_t slot = head;
+
+        for (uint8_t j = 0; j < ALORA_DECIMATOR_PHASE_TAPS; j++) {
+            int32_t c = *tap;
+            sums[slot][0] += c * x;
+            sums[slot][1] += c * y;
+            sums[slot][2] += c * z;
+
+            tap += factor;
+            if (++slot == ALORA_DECIMATOR_PHASE_TAPS) {
+                slot = 0;
+            }
+        }
+
+        if (++phase < factor) {
+            continue;
+        }
+
+        phase = 0;
+
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            int32_t value = (sums[head][axis] + 0x4000) >> 15;
+            raw[3 * outputs + axis] = value > 32767 ? 32767 : (value < -32768 ? -32768 : value);
+            sums[head][axis] = 0;
+        }
+
+        outputs++;
+        if (++head == ALORA_DECIMATOR_PHASE_TAPS) {
+            head = 0;
+        }
+    }
+
+    return outputs;
+}
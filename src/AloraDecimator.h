@@ -0,0 +1,55 @@
+/** @file */
+
+#ifndef ALORA_DECIMATOR_H
+#define ALORA_DECIMATOR_H
+
+#include <stdint.h>
+
+/** Largest decimation factor, sets the size of the coefficient table */
+#if !defined(ALORA_DECIMATOR_MAX_FACTOR)
+    #define ALORA_DECIMATOR_MAX_FACTOR 32
+#endif
+
+/** Filter taps per polyphase branch. The filter has factor * ALORA_DECIMATOR_PHASE_TAPS taps and every input sample costs ALORA_DECIMATOR_PHASE_TAPS multiply-accumulates per axis */
+#if !defined(ALORA_DECIMATOR_PHASE_TAPS)
+    #define ALORA_DECIMATOR_PHASE_TAPS 8
+#endif
+
+/**
+ * @brief Polyphase FIR decimator for one stream of raw IMU triples.
+ *
+ * The low-pass is a Hamming windowed sinc with its cutoff at the output
+ * Nyquist frequency and unity DC gain. With the default 8 taps per branch the
+ * passband is flat within 0.1 dB up to 0.3 times the output rate. Input that
+ * would alias into it is attenuated by about 46.7 dB at factor 19 (952 Hz to
+ * 50 Hz), at least 45 dB from factor 8 up, but only 39.5 dB at factor 2 and
+ * 42.9 dB at factor 4. 12 taps per branch give at least 52 dB at any factor.
+ *
+ * Input and output are interleaved raw triples (x0, y0, z0, x1, ...), the
+ * layout of a LSM9DS1 FIFO batch. The filter is evaluated in transposed form:
+ * each input sample is multiplied by one coefficient of every polyphase
+ * branch and added to the partial sums of the outputs it belongs to, so the
+ * cost per input sample is constant instead of one full convolution every
+ * factor samples. Coefficients are Q15, partial sums 32 bit.
+ *
+ * Use one decimator per sensor stream; streams with the same factor that
+ * start together stay sample aligned.
+ */
+class AloraDecimator {
+public:
+    AloraDecimator();
+
+    bool setFactor(uint8_t factor);
+    uint8_t getFactor();
+    void reset();
+    uint16_t process(int16_t* raw, uint16_t count);
+
+private:
+    int16_t coefficients[ALORA_DECIMATOR_MAX_FACTOR * ALORA_DECIMATOR_PHASE_TAPS]; /**< Filter taps, Q15 */
+    int32_t sums[ALORA_DECIMATOR_PHASE_TAPS][3]; /**< Partial sums of the pending outputs, ring indexed from head */
+    uint8_t head;                           /**< Ring index of the partial sum completed next */
+    uint8_t factor;                         /**< Decimation factor, 1 passes samples through */
+    uint8_t phase;                          /**< Position of the next input in the current output period */
+};
+
+#endif
@@ -0,0 +1,57 @@
+/** @file */
+
+#ifndef ALORA_FFT_H
+#define ALORA_FFT_H
+
+#include <stdint.h>
+
+/** Largest transform size, sets the resolution of the twiddle table */
+#define ALORA_FFT_MAX_SIZE 1024
+
+/**
+ * @brief Fixed-point radix-2 FFT for vibration analysis.
+ *
+ * Data is Q15, real and imaginary parts in separate arrays. The transform is
+ * an in-place decimation in time with every stage scaled by 1/2, so the
+ * output is X[k] / size and cannot overflow as long as the input magnitude
+ * stays below 32768 / sqrt(2). Twiddles come from a quarter-wave sine table
+ * of ALORA_FFT_MAX_SIZE / 4 + 1 entries shared by all sizes.
+ */
+class AloraFFT {
+public:
+    static bool transform(int16_t* real, int16_t* imag, uint16_t size);
+    static void window(int16_t* data, uint16_t size);
+
+    /**
+     * @brief Sine of a binary angle
+     *
+     * @param index angle in multiples of 2 pi / ALORA_FFT_MAX_SIZE
+     * @return int16_t sine in Q15
+     */
+    static inline int16_t sinQ15(uint16_t index) {
+        index &= ALORA_FFT_MAX_SIZE - 1;
+
+        if (index < ALORA_FFT_MAX_SIZE / 2) {
+            return index <= ALORA_FFT_MAX_SIZE / 4 ? sineTable[index] : sineTable[ALORA_FFT_MAX_SIZE / 2 - index];
+        }
+
+        index -= ALORA_FFT_MAX_SIZE / 2;
+
+        return index <= ALORA_FFT_MAX_SIZE / 4 ? -sineTable[index] : -sineTable[ALORA_FFT_MAX_SIZE / 2 - index];
+    }
+
+    /**
+     * @brief Cosine of a binary angle
+     *
+     * @param index angle in multiples of 2 pi / ALORA_FFT_MAX_SIZE
+     * @return int16_t cosine in Q15
+     */
+    static inline int16_t cosQ15(uint16_t index) {
+        return sinQ15(index + ALORA_FFT_MAX_SIZE / 4);
+    }
+
+private:
+    static const int16_t sineTable[ALORA_FFT_MAX_SIZE / 4 + 1];
+};
+
+#endif
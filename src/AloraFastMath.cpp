@@ -0,0 +1,201 @@
+/** @file */
+
+#include "AloraFastMath.h"
+
+/**
+ * atan(i / 256) for i = 0..256 as a binary angle, where 2^31 is pi.
+ */
+static const uint32_t ALORA_FAST_MATH_ATAN_TABLE[257] = {
+    0x00000000, 0x0028BE53, 0x00517C55, 0x007A39B4, 0x00A2F61E, 0x00CBB143,
+    0x00F46AD1, 0x011D2276, 0x0145D7E1, 0x016E8AC2, 0x01973AC8, 0x01BFE7A1,
+    0x01E890FD, 0x0211368B, 0x0239D7FC, 0x026274FE, 0x028B0D43, 0x02B3A07A,
+    0x02DC2E54, 0x0304B681, 0x032D38B4, 0x0355B49C, 0x037E29EB, 0x03A69855,
+    0x03CEFF8A, 0x03F75F3D, 0x041FB721, 0x044806EA, 0x04704E4B, 0x04988CF8,
+    0x04C0C2A5, 0x04E8EF07, 0x051111D4, 0x05392AC1, 0x05613984, 0x05893DD4,
+    0x05B13767, 0x05D925F6, 0x06010937, 0x0628E0E5, 0x0650ACB7, 0x06786C67,
+    0x06A01FAF, 0x06C7C649, 0x06EF5FF2, 0x0716EC63, 0x073E6B5B, 0x0765DC95,
+    0x078D3FCF, 0x07B494C6, 0x07DBDB3A, 0x080312EA, 0x082A3B95, 0x085154FC,
+    0x08785EDF, 0x089F5902, 0x08C64325, 0x08ED1D0D, 0x0913E67C, 0x093A9F37,
+    0x09614704, 0x0987DDA7, 0x09AE62E7, 0x09D4D68B, 0x09FB385B, 0x0A218820,
+    0x0A47C5A2, 0x0A6DF0AC, 0x0A940907, 0x0ABA0E80, 0x0AE000E2, 0x0B05DFFA,
+    0x0B2BAB95, 0x0B516382, 0x0B770790, 0x0B9C978D, 0x0BC2134C, 0x0BE77A9B,
+    0x0C0CCD4F, 0x0C320B38, 0x0C57342B, 0x0C7C47FB, 0x0CA1467D, 0x0CC62F87,
+    0x0CEB02EF, 0x0D0FC08D, 0x0D346837, 0x0D58F9C7, 0x0D7D7515, 0x0DA1D9FC,
+    0x0DC62856, 0x0DEA6000, 0x0E0E80D4, 0x0E328AB1, 0x0E567D73, 0x0E7A58FA,
+    0x0E9E1D24, 0x0EC1C9D1, 0x0EE55EE3, 0x0F08DC39, 0x0F2C41B7, 0x0F4F8F3F,
+    0x0F72C4B4, 0x0F95E1FB, 0x0FB8E6F9, 0x0FDBD394, 0x0FFEA7B1, 0x10216337,
+    0x1044060F, 0x10669021, 0x10890156, 0x10AB5998, 0x10CD98D1, 0x10EFBEED,
+    0x1111CBD6, 0x1133BF7A, 0x115599C7, 0x11775AA8, 0x1199020E, 0x11BA8FE7,
+    0x11DC0423, 0x11FD5EB3, 0x121E9F86, 0x123FC690, 0x1260D3C2, 0x1281C70F,
+    0x12A2A06A, 0x12C35FC8, 0x12E4051E, 0x13049060, 0x13250184, 0x13455882,
+    0x1365954F, 0x1385B7E4, 0x13A5C038, 0x13C5AE45, 0x13E58204, 0x14053B6E,
+    0x1424DA7E, 0x14445F2E, 0x1463C97A, 0x1483195F, 0x14A24ED8, 0x14C169E2,
+    0x14E06A7B, 0x14FF50A0, 0x151E1C51, 0x153CCD8C, 0x155B6450, 0x1579E09E,
+    0x15984275, 0x15B689D7, 0x15D4B6C5, 0x15F2C93F, 0x1610C149, 0x162E9EE6,
+    0x164C6217, 0x166A0AE0, 0x16879946, 0x16A50D4C, 0x16C266F7, 0x16DFA64C,
+    0x16FCCB50, 0x1719D60A, 0x1736C67F, 0x17539CB6, 0x177058B6, 0x178CFA85,
+    0x17A9822D, 0x17C5EFB4, 0x17E24323, 0x17FE7C82, 0x181A9BDB, 0x1836A137,
+    0x18528C9F, 0x186E5E1D, 0x188A15BC, 0x18A5B386, 0x18C13785, 0x18DCA1C6,
+    0x18F7F252, 0x19132937, 0x192E4680, 0x19494A38, 0x1964346E, 0x197F052C,
+    0x1999BC81, 0x19B45A79, 0x19CEDF22, 0x19E94A8A, 0x1A039CBE, 0x1A1DD5CD,
+    0x1A37F5C5, 0x1A51FCB4, 0x1A6BEAAA, 0x1A85BFB5, 0x1A9F7BE5, 0x1AB91F49,
+    0x1AD2A9F0, 0x1AEC1BEB, 0x1B057548, 0x1B1EB61A, 0x1B37DE6F, 0x1B50EE58,
+    0x1B69E5E6, 0x1B82C529, 0x1B9B8C33, 0x1BB43B15, 0x1BCCD1E0, 0x1BE550A5,
+    0x1BFDB776, 0x1C160664, 0x1C2E3D81, 0x1C465CE0, 0x1C5E6492, 0x1C7654A9,
+    0x1C8E2D38, 0x1CA5EE52, 0x1CBD9807, 0x1CD52A6C, 0x1CECA593, 0x1D04098F,
+    0x1D1B5672, 0x1D328C4F, 0x1D49AB3B, 0x1D60B347, 0x1D77A487, 0x1D8E7F0F,
+    0x1DA542F1, 0x1DBBF042, 0x1DD28714, 0x1DE9077C, 0x1DFF718C, 0x1E15C55A,
+    0x1E2C02F8, 0x1E422A7A, 0x1E583BF4, 0x1E6E377B, 0x1E841D21, 0x1E99ECFC,
+    0x1EAFA71F, 0x1EC54B9E, 0x1EDADA8D, 0x1EF05401, 0x1F05B80E, 0x1F1B06C8,
+    0x1F304043, 0x1F456493, 0x1F5A73CD, 0x1F6F6E05, 0x1F84534F, 0x1F9923C0,
+    0x1FADDF6B, 0x1FC28667, 0x1FD718C6, 0x1FEB969D, 0x20000000
+};
+
+/**
+ * @brief Four-quadrant arc tangent in Q15
+ *
+ * @param y Y component
+ * @param x X component
+ * @return int16_t binary angle, 32768 is pi
+ */
+int16_t AloraFastMath::atan2Q15(int16_t y, int16_t x) {
+    int32_t angle = atan2Q31(y, x);
+
+    // round to nearest, keeping the wrap-around at pi
+    return (int16_t)((uint32_t)(angle + 0x8000) >> 16);
+}
+
+/**
+ * @brief Four-quadrant arc tangent in Q31
+ *
+ * @param y Y component
+ * @param x X component
+ * @return int32_t binary angle, 2^31 is pi. Returns 0 when both components are 0
+ */
+int32_t AloraFastMath::atan2Q31(int32_t y, int32_t x) {
+    uint32_t ax = x < 0 ? (uint32_t)0 - (uint32_t)x : (uint32_t)x;
+    uint32_t ay = y < 0 ? (uint32_t)0 - (uint32_t)y : (uint32_t)y;
+
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+
+    uint32_t maxValue = ax > ay ? ax : ay;
+    uint32_t minValue = ax > ay ? ay : ax;
+
+    // ratio in [0, 1] as Q24, then table lookup with linear interpolation
+    uint32_t ratio = (uint32_t)(((uint64_t)minValue << 24) / maxValue);
+    uint32_t index = ratio >> 16;
+    uint32_t fraction = ratio & 0xFFFF;
+    uint32_t angle = ALORA_FAST_MATH_ATAN_TABLE[index];
+    if (fraction != 0) {
+        angle += (uint32_t)(((uint64_t)(ALORA_FAST_MATH_ATAN_TABLE[index + 1] - angle) * fraction + 0x8000) >> 16);
+    }
+
+    if (ay > ax) {
+        angle = 0x40000000UL - angle;
+    }
+
+    if (x < 0) {
+        angle = 0x80000000UL - angle;
+    }
+
+    if (y < 0) {
+        angle = (uint32_t)0 - angle;
+    }
+
+    return (int32_t)angle;
+}
+
+/**
+ * @brief Integer square root
+ *
+ * @param x input value
+ * @return uint32_t floor(sqrt(x))
+ */
+uint32_t AloraFastMath::isqrt(uint64_t x) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > x) {
+        bit >>= 2;
+    }
+
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (uint32_t)result;
+}
+
+/**
+ * @brief Square root of an unsigned Q15 value
+ *
+ * @param x input value, 32768 is 1.0
+ * @return uint16_t sqrt(x) in Q15
+ */
+uint16_t AloraFastMath::sqrtQ15(uint16_t x) {
+    return (uint16_t)isqrt((uint64_t)x << 15);
+}
+
+/**
+ * @brief Square root of an unsigned Q31 value
+ *
+ * @param x input value, 2^31 is 1.0
+ * @return uint32_t sqrt(x) in Q31
+ */
+uint32_t AloraFastMath::sqrtQ31(uint32_t x) {
+    return isqrt((uint64_t)x << 31);
+}
+
+/**
+ * @brief Scaled inverse square root of an integer.
+ * Multiply a vector component by the result and shift right by 16 to get
+ * a Q15 unit vector component.
+ *
+ * @param x input value, must be greater than 0
+ * @return uint32_t 2^31 / sqrt(x), 0xFFFFFFFF when x is 0
+ */
+uint32_t AloraFastMath::invSqrtQ31(uint32_t x) {
+    if (x == 0) {
+        return 0xFFFFFFFFUL;
+    }
+
+    // normalize to m in [2^30, 2^32), so m / 2^32 is in [0.25, 1)
+    uint8_t shift = 0;
+    uint32_t m = x;
+    while ((m & 0xC0000000UL) == 0) {
+        m <<= 2;
+        shift += 2;
+    }
+
+    // y = 1 / sqrt(m / 2^32) is in (1, 2], kept in Q30.
+    // Linear first guess followed by Newton steps y = y * (3 - m * y^2) / 2
+    uint64_t y = 0x95555555ULL - (((uint64_t)m * 0x55555555ULL) >> 32);
+    for (uint8_t i = 0; i < 4; i++) {
+        uint64_t y2 = (y * y) >> 30;
+        uint64_t my2 = ((uint64_t)m * y2) >> 32;
+        y = (y * ((3ULL << 30) - my2)) >> 31;
+    }
+
+    // 2^31 / sqrt(x) = y * 2^(shift / 2 - 15), with y in Q30
+    return (uint32_t)(y >> (15 - shift / 2));
+}
+
+/**
+ * @brief Length of a raw three dimensional vector, for example an IMU sample
+ *
+ * @return uint32_t floor(sqrt(x * x + y * y + z * z))
+ */
+uint32_t AloraFastMath::magnitude(int16_t x, int16_t y, int16_t z) {
+    uint32_t sum = (uint32_t)((int32_t)x * x) + (uint32_t)((int32_t)y * y) + (uint32_t)((int32_t)z * z);
+
+    return isqrt(sum);
+}
@@ -0,0 +1,117 @@
+/** @file */
+
+#ifndef ALORA_FAST_MATH_H
+#define ALORA_FAST_MATH_H
+
+#include <stdint.h>
+#include <string.h>
+
+/** Pi as float */
+#define ALORA_FAST_MATH_PI 3.14159265f
+
+/** Pi / 2 as float */
+#define ALORA_FAST_MATH_HALF_PI 1.57079633f
+
+/**
+ * @brief Approximated math kernels for heading and vector magnitude calculation.
+ *
+ * Error bounds, measured over the whole input domain:
+ * - atan2(): 1.2e-5 rad absolute (minimax polynomial of degree 9)
+ * - invSqrt(): 5e-6 relative (bit-level estimate with two Newton steps)
+ * - sqrt(): 5e-6 relative
+ * - atan2Q15(): 1 LSB, one LSB is pi / 32768 rad
+ * - atan2Q31(): 1.3e-6 rad absolute (interpolated 257 entries table)
+ * - sqrtQ15(), sqrtQ31(), magnitude(): exact floor of the result
+ * - invSqrtQ31(): 2 LSB
+ *
+ * Fixed-point angles are binary angles: the signed value divided by 2^15 (Q15)
+ * or 2^31 (Q31) gives the angle in multiples of pi, so a full turn wraps exactly.
+ */
+class AloraFastMath {
+public:
+    /**
+     * @brief Four-quadrant arc tangent
+     *
+     * @param y Y component
+     * @param x X component
+     * @return float angle in radians, -pi to pi. Returns 0 when both components are 0
+     */
+    static inline float atan2(float y, float x) {
+        float ax = x < 0.0f ? -x : x;
+        float ay = y < 0.0f ? -y : y;
+        float maxValue = ax > ay ? ax : ay;
+
+        if (maxValue == 0.0f) {
+            return 0.0f;
+        }
+
+        float minValue = ax > ay ? ay : ax;
+        float z = minValue / maxValue;
+        float z2 = z * z;
+        float angle = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+
+        if (ay > ax) {
+            angle = ALORA_FAST_MATH_HALF_PI - angle;
+        }
+
+        if (x < 0.0f) {
+            angle = ALORA_FAST_MATH_PI - angle;
+        }
+
+        return y < 0.0f ? -angle : angle;
+    }
+
+    /**
+     * @brief Inverse square root
+     *
+     * @param x input value, must be greater than 0
+     * @return float 1 / sqrt(x)
+     */
+    static inline float invSqrt(float x) {
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        bits = 0x5F375A86 - (bits >> 1);
+
+        float y;
+        memcpy(&y, &bits, sizeof(y));
+
+        float halfX = 0.5f * x;
+        y = y * (1.5f - halfX * y * y);
+        y = y * (1.5f - halfX * y * y);
+
+        return y;
+    }
+
+    /**
+     * @brief Square root
+     *
+     * @param x input value
+     * @return float sqrt(x), 0 when x is not positive
+     */
+    static inline float sqrt(float x) {
+        if (x <= 0.0f) {
+            return 0.0f;
+        }
+
+        return x * invSqrt(x);
+    }
+
+    /**
+     * @brief Length of a three dimensional vector
+     *
+     * @return float sqrt(x * x + y * y + z * z)
+     */
+    static inline float norm(float x, float y, float z) {
+        return sqrt(x * x + y * y + z * z);
+    }
+
+    static int16_t atan2Q15(int16_t y, int16_t x);
+    static int32_t atan2Q31(int32_t y, int32_t x);
+    static uint16_t sqrtQ15(uint16_t x);
+    static uint32_t sqrtQ31(uint32_t x);
+    static uint32_t invSqrtQ31(uint32_t x);
+    static uint32_t magnitude(int16_t x, int16_t y, int16_t z);
+    static uint32_t isqrt(uint64_t x);
+};
+
+#endif
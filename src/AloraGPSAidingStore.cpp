@@ -0,0 +1,109 @@
+/** @file */
+
+#include "AloraGPSAidingStore.h"
+
+#if defined(ESP32)
+    #include <Preferences.h>
+#else
+    #include <stdio.h>
+#endif
+
+/**
+ * @brief Load the last saved fix
+ *
+ * @param fix loaded fix, left unchanged on failure
+ * @return true if a valid blob was found
+ */
+bool AloraGPSAidingStore::load(AloraGPSAidingFix& fix) {
+    AloraGPSAidingFix stored;
+    size_t length = 0;
+
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_GPS_AIDING_NAMESPACE, true)) {
+        return false;
+    }
+
+    if (preferences.getBytesLength(ALORA_GPS_AIDING_KEY) == sizeof(stored)) {
+        length = preferences.getBytes(ALORA_GPS_AIDING_KEY, &stored, sizeof(stored));
+    }
+
+    preferences.end();
+#else
+    FILE* file = fopen(ALORA_GPS_AIDING_FILE, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    length = fread(&stored, 1, sizeof(stored), file);
+    fclose(file);
+#endif
+
+    if (length != sizeof(stored)
+        || stored.magic != ALORA_GPS_AIDING_MAGIC
+        || stored.version != ALORA_GPS_AIDING_VERSION) {
+        return false;
+    }
+
+    fix = stored;
+
+    return true;
+}
+
+/**
+ * @brief Save a fix. Magic number and version are filled in.
+ *
+ * @param fix fix to save
+ * @return true on success
+ */
+bool AloraGPSAidingStore::save(AloraGPSAidingFix& fix) {
+    fix.magic = ALORA_GPS_AIDING_MAGIC;
+    fix.version = ALORA_GPS_AIDING_VERSION;
+
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_GPS_AIDING_NAMESPACE, false)) {
+        return false;
+    }
+
+    size_t length = preferences.putBytes(ALORA_GPS_AIDING_KEY, &fix, sizeof(fix));
+    preferences.end();
+
+    return length == sizeof(fix);
+#else
+    FILE* file = fopen(ALORA_GPS_AIDING_FILE, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    size_t length = fwrite(&fix, 1, sizeof(fix), file);
+
+    return fclose(file) == 0 && length == sizeof(fix);
+#endif
+}
+
+/**
+ * @brief Remove the saved fix
+ *
+ * @return true if nothing is saved anymore
+ */
+bool AloraGPSAidingStore::clear() {
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_GPS_AIDING_NAMESPACE, false)) {
+        return false;
+    }
+
+    if (preferences.isKey(ALORA_GPS_AIDING_KEY)) {
+        preferences.remove(ALORA_GPS_AIDING_KEY);
+    }
+
+    preferences.end();
+
+    return true;
+#else
+    remove(ALORA_GPS_AIDING_FILE);
+
+    return true;
+#endif
+}
@@ -0,0 +1,52 @@
+/** @file */
+
+#ifndef ALORA_GPS_AIDING_STORE_H
+#define ALORA_GPS_AIDING_STORE_H
+
+#include <stdint.h>
+
+/** NVS namespace of the last GPS fix (ESP32) */
+#if !defined(ALORA_GPS_AIDING_NAMESPACE)
+    #define ALORA_GPS_AIDING_NAMESPACE "alora"
+#endif
+
+/** NVS key of the last GPS fix (ESP32) */
+#if !defined(ALORA_GPS_AIDING_KEY)
+    #define ALORA_GPS_AIDING_KEY "gpsfix"
+#endif
+
+/** File of the last GPS fix on targets without NVS */
+#if !defined(ALORA_GPS_AIDING_FILE)
+    #define ALORA_GPS_AIDING_FILE "alora_gps_fix.bin"
+#endif
+
+/** Blob magic number, "ALGF" */
+#define ALORA_GPS_AIDING_MAGIC 0x46474C41UL
+
+/** Blob layout version. Blobs with another version are ignored */
+#define ALORA_GPS_AIDING_VERSION 1
+
+/**
+ * @brief Last known position, injected into the receiver on the next power-up
+ */
+struct AloraGPSAidingFix {
+    uint32_t magic;                         /**< ALORA_GPS_AIDING_MAGIC */
+    uint16_t version;                       /**< ALORA_GPS_AIDING_VERSION */
+    int32_t latitudeL;                      /**< Latitude in degrees * 10^7 */
+    int32_t longitudeL;                     /**< Longitude in degrees * 10^7 */
+    int32_t altitude;                       /**< Altitude in cm */
+    uint32_t time;                          /**< UTC time of the fix, seconds since 1970 */
+};
+
+/**
+ * @brief Persistent storage of the last GPS fix. Uses NVS through
+ * Preferences on ESP32 and a file on other targets.
+ */
+class AloraGPSAidingStore {
+public:
+    static bool load(AloraGPSAidingFix& fix);
+    static bool save(AloraGPSAidingFix& fix);
+    static bool clear();
+};
+
+#endif
@@ -0,0 +1,181 @@
+/** @file */
+
+#include "AloraGPSConfig.h"
+#include <RTClib.h>
+
+/** UBX configuration message class */
+#define ALORA_UBX_CLASS_CFG 0x06
+
+/** UBX message id of the port configuration */
+#define ALORA_UBX_CFG_PRT 0x00
+
+/** UBX message id of the message rate configuration */
+#define ALORA_UBX_CFG_MSG 0x01
+
+/** UBX message id of the navigation rate configuration */
+#define ALORA_UBX_CFG_RATE 0x08
+
+/** UBX multiple GNSS assistance message class */
+#define ALORA_UBX_CLASS_MGA 0x13
+
+/** UBX message id of the initial position and time assistance */
+#define ALORA_UBX_MGA_INI 0x40
+
+/** UBX message class of the standard NMEA sentences */
+#define ALORA_UBX_CLASS_NMEA 0xF0
+
+/**
+ * @brief Keep only GGA and RMC in the receiver output
+ *
+ * @param stream UART of the receiver
+ * @param module ALORA_GPS_MODULE_MTK or ALORA_GPS_MODULE_UBLOX
+ */
+void AloraGPSConfig::setSentences(Stream& stream, uint8_t module) {
+    if (module == ALORA_GPS_MODULE_UBLOX) {
+        // GGA, GLL, GSA, GSV, RMC, VTG
+        const uint8_t ids[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05 };
+        const uint8_t rates[] = { 1, 0, 0, 0, 1, 0 };
+
+        for (uint8_t i = 0; i < sizeof(ids); i++) {
+            uint8_t payload[3] = { ALORA_UBX_CLASS_NMEA, ids[i], rates[i] };
+            sendUBX(stream, ALORA_UBX_CLASS_CFG, ALORA_UBX_CFG_MSG, payload, sizeof(payload));
+        }
+    } else {
+        // GLL, RMC, VTG, GGA, GSA, GSV, then unused and proprietary slots
+        NMEAGPS::send(&stream, "PMTK314,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0");
+    }
+}
+
+/**
+ * @brief Switch the receiver UART to another baud rate. The receiver answers
+ * at the new rate right after the command.
+ *
+ * @param stream UART of the receiver
+ * @param module ALORA_GPS_MODULE_MTK or ALORA_GPS_MODULE_UBLOX
+ * @param baud new baud rate
+ */
+void AloraGPSConfig::setBaudRate(Stream& stream, uint8_t module, uint32_t baud) {
+    if (module == ALORA_GPS_MODULE_UBLOX) {
+        // UART1, 8N1, UBX and NMEA in, NMEA out only
+        uint8_t payload[20] = {
+            0x01, 0x00, 0x00, 0x00,
+            0xD0, 0x08, 0x00, 0x00,
+            (uint8_t) baud, (uint8_t) (baud >> 8), (uint8_t) (baud >> 16), (uint8_t) (baud >> 24),
+            0x03, 0x00, 0x02, 0x00,
+            0x00, 0x00, 0x00, 0x00
+        };
+        sendUBX(stream, ALORA_UBX_CLASS_CFG, ALORA_UBX_CFG_PRT, payload, sizeof(payload));
+    } else {
+        char command[24];
+        snprintf(command, sizeof(command), "PMTK251,%lu", (unsigned long) baud);
+        NMEAGPS::send(&stream, command);
+    }
+}
+
+/**
+ * @brief Set the time between two fixes. Faster fixes need the higher baud
+ * rate, a 9600 baud UART fits only about 5 GGA and RMC pairs per second.
+ *
+ * @param stream UART of the receiver
+ * @param module ALORA_GPS_MODULE_MTK or ALORA_GPS_MODULE_UBLOX
+ * @param intervalMs fix interval in milliseconds, 100 is the fastest most modules support
+ */
+void AloraGPSConfig::setFixInterval(Stream& stream, uint8_t module, uint16_t intervalMs) {
+    if (module == ALORA_GPS_MODULE_UBLOX) {
+        // one navigation solution per measurement, aligned to GPS time
+        uint8_t payload[6] = {
+            (uint8_t) intervalMs, (uint8_t) (intervalMs >> 8),
+            0x01, 0x00,
+            0x01, 0x00
+        };
+        sendUBX(stream, ALORA_UBX_CLASS_CFG, ALORA_UBX_CFG_RATE, payload, sizeof(payload));
+    } else {
+        char command[16];
+        snprintf(command, sizeof(command), "PMTK220,%u", intervalMs);
+        NMEAGPS::send(&stream, command);
+    }
+}
+
+/**
+ * @brief Give the receiver an approximate position and time, so it can
+ * predict visible satellites and start a warm search instead of a cold one.
+ * Send it right after power-up.
+ *
+ * MTK receivers take position only together with time (PMTK741). u-blox
+ * receivers take both separately (UBX-MGA-INI, u-blox M8 and later).
+ *
+ * @param stream UART of the receiver
+ * @param module ALORA_GPS_MODULE_MTK or ALORA_GPS_MODULE_UBLOX
+ * @param fix last known position, NULL if unknown
+ * @param utc current UTC time in seconds since 1970, 0 if unknown
+ */
+void AloraGPSConfig::sendAiding(Stream& stream, uint8_t module, const AloraGPSAidingFix* fix, uint32_t utc) {
+    DateTime now(utc);
+
+    if (module == ALORA_GPS_MODULE_UBLOX) {
+        if (fix != NULL) {
+            const uint32_t accuracy = ALORA_GPS_AIDING_POSITION_ACCURACY_M * 100UL;
+            uint8_t payload[20] = { 0x01, 0x00, 0x00, 0x00 };
+
+            memcpy(&payload[4], &fix->latitudeL, 4);
+            memcpy(&payload[8], &fix->longitudeL, 4);
+            memcpy(&payload[12], &fix->altitude, 4);
+            memcpy(&payload[16], &accuracy, 4);
+            sendUBX(stream, ALORA_UBX_CLASS_MGA, ALORA_UBX_MGA_INI, payload, sizeof(payload));
+        }
+
+        if (utc != 0) {
+            // leap seconds unknown, the receiver knows them from its almanac
+            uint8_t payload[24] = {
+                0x10, 0x00, 0x00, 0x80,
+                (uint8_t) now.year(), (uint8_t) (now.year() >> 8), now.month(), now.day(),
+                now.hour(), now.minute(), now.second(), 0x00,
+                0x00, 0x00, 0x00, 0x00,
+                ALORA_GPS_AIDING_TIME_ACCURACY_S, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00
+            };
+            sendUBX(stream, ALORA_UBX_CLASS_MGA, ALORA_UBX_MGA_INI, payload, sizeof(payload));
+        }
+    } else if (utc != 0) {
+        char command[80];
+
+        if (fix != NULL) {
+            // degrees with 7 decimals straight from the integer format, no float rounding
+            uint32_t latitude = fix->latitudeL < 0 ? -fix->latitudeL : fix->latitudeL;
+            uint32_t longitude = fix->longitudeL < 0 ? -fix->longitudeL : fix->longitudeL;
+
+            snprintf(command, sizeof(command), "PMTK741,%s%lu.%07lu,%s%lu.%07lu,%ld,%04u,%02u,%02u,%02u,%02u,%02u",
+                fix->latitudeL < 0 ? "-" : "", (unsigned long) (latitude / 10000000UL), (unsigned long) (latitude % 10000000UL),
+                fix->longitudeL < 0 ? "-" : "", (unsigned long) (longitude / 10000000UL), (unsigned long) (longitude % 10000000UL),
+                (long) (fix->altitude / 100),
+                now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
+        } else {
+            snprintf(command, sizeof(command), "PMTK740,%04u,%02u,%02u,%02u,%02u,%02u",
+                now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
+        }
+
+        NMEAGPS::send(&stream, command);
+    }
+}
+
+/**
+ * @brief Send a UBX frame with its 8-bit Fletcher checksum
+ */
+void AloraGPSConfig::sendUBX(Stream& stream, uint8_t messageClass, uint8_t messageId, const uint8_t* payload, uint16_t length) {
+    uint8_t header[6] = { 0xB5, 0x62, messageClass, messageId, (uint8_t) length, (uint8_t) (length >> 8) };
+    uint8_t checksum[2] = { 0, 0 };
+
+    for (uint8_t i = 2; i < sizeof(header); i++) {
+        checksum[0] += header[i];
+        checksum[1] += checksum[0];
+    }
+
+    for (uint16_t i = 0; i < length; i++) {
+        checksum[0] += payload[i];
+        checksum[1] += checksum[0];
+    }
+
+    stream.write(header, sizeof(header));
+    stream.write(payload, length);
+    stream.write(checksum, sizeof(checksum));
+}
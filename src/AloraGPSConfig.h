@@ -0,0 +1,68 @@
+/** @file */
+
+#ifndef ALORA_GPS_CONFIG_H
+#define ALORA_GPS_CONFIG_H
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+#include "AloraGPSAidingStore.h"
+
+/** GPS receiver speaking PMTK commands (MediaTek based modules) */
+#define ALORA_GPS_MODULE_MTK 0
+
+/** GPS receiver speaking UBX commands (u-blox modules) */
+#define ALORA_GPS_MODULE_UBLOX 1
+
+/** Command set of the GPS receiver on the board */
+#if !defined(ALORA_GPS_MODULE)
+    #define ALORA_GPS_MODULE ALORA_GPS_MODULE_MTK
+#endif
+
+/** UART baud rate the GPS receiver is switched to */
+#if !defined(ALORA_GPS_BAUD)
+    #define ALORA_GPS_BAUD 115200
+#endif
+
+/** Time between two GPS fixes in milliseconds */
+#if !defined(ALORA_GPS_FIX_INTERVAL_MS)
+    #define ALORA_GPS_FIX_INTERVAL_MS 200
+#endif
+
+/** Accuracy in meters given to the receiver for an aiding position, covers moving while the GPS was off */
+#if !defined(ALORA_GPS_AIDING_POSITION_ACCURACY_M)
+    #define ALORA_GPS_AIDING_POSITION_ACCURACY_M 10000
+#endif
+
+/** Accuracy in seconds given to the receiver for an aiding time from the RTC */
+#if !defined(ALORA_GPS_AIDING_TIME_ACCURACY_S)
+    #define ALORA_GPS_AIDING_TIME_ACCURACY_S 2
+#endif
+
+/** Time to wait for a sentence at the new baud rate before going back to the old one */
+#if !defined(ALORA_GPS_CONFIG_TIMEOUT_MS)
+    #define ALORA_GPS_CONFIG_TIMEOUT_MS 2000
+#endif
+
+/**
+ * @brief Receiver commands for the GPS module.
+ *
+ * Only GGA and RMC are left enabled, they carry everything NeoGPS puts into
+ * a gps_fix with the default configuration. Every other sentence would be
+ * received and scanned just to be thrown away. PMTK sentences go out through
+ * NMEAGPS::send(), which adds the checksum. UBX frames are built here.
+ *
+ * Commands are fire and forget. AloraSensorKit::configureGPS() checks the
+ * result by listening for sentences at the new baud rate.
+ */
+class AloraGPSConfig {
+public:
+    static void setSentences(Stream& stream, uint8_t module);
+    static void setBaudRate(Stream& stream, uint8_t module, uint32_t baud);
+    static void setFixInterval(Stream& stream, uint8_t module, uint16_t intervalMs);
+    static void sendAiding(Stream& stream, uint8_t module, const AloraGPSAidingFix* fix, uint32_t utc);
+
+private:
+    static void sendUBX(Stream& stream, uint8_t messageClass, uint8_t messageId, const uint8_t* payload, uint16_t length);
+};
+
+#endif
@@ -0,0 +1,332 @@
+/** @file */
+
+#include "AloraGPSFusion.h"
+
+/** Initial standard deviation of the acceleration bias in m/s^2 */
+#define ALORA_GPS_FUSION_INITIAL_BIAS_SIGMA 0.2f
+
+/** Initial standard deviation of the velocity in m/s when the first fix has none */
+#define ALORA_GPS_FUSION_INITIAL_VELOCITY_SIGMA 5.0f
+
+AloraGPSFusion::AloraGPSFusion() {
+    reset();
+}
+
+/**
+ * @brief Drop the estimate, the next fix starts the filter again
+ */
+void AloraGPSFusion::reset() {
+    memset(axes, 0, sizeof(axes));
+    accel[0] = 0.0f;
+    accel[1] = 0.0f;
+    accel[2] = 0.0f;
+    lastMicros = 0;
+    initialized = false;
+    rejects = 0;
+    setOrigin(0, 0);
+}
+
+/**
+ * @brief Integrate acceleration up to a new IMU sample
+ *
+ * @param east gravity-free acceleration towards magnetic east in m/s^2
+ * @param north gravity-free acceleration towards magnetic north in m/s^2
+ * @param up gravity-free acceleration upwards in m/s^2
+ * @param timestamp micros() of the sample
+ */
+void AloraGPSFusion::predict(float east, float north, float up, uint32_t timestamp) {
+    if (initialized) {
+        // the previous sample holds until this one
+        advance(timestamp);
+    } else {
+        lastMicros = timestamp;
+    }
+
+    const float declination = ALORA_GPS_FUSION_DECLINATION_DEG * (float) DEG_TO_RAD;
+    float c = cosf(declination);
+    float s = sinf(declination);
+
+    accel[0] = east * c + north * s;
+    accel[1] = north * c - east * s;
+    accel[2] = up;
+}
+
+/**
+ * @brief Correct the estimate with a GPS fix. The first fix with a location
+ * starts the filter.
+ *
+ * @param fix fix from NMEAGPS
+ * @param timestamp micros() when the fix was received
+ * @return true if the fix was used
+ */
+bool AloraGPSFusion::correct(const gps_fix& fix, uint32_t timestamp) {
+    if (!fix.valid.location) {
+        return false;
+    }
+
+#ifdef GPS_FIX_HDOP
+    float hdop = fix.valid.hdop && fix.hdop > 0 ? fix.hdop * 0.001f : ALORA_GPS_FUSION_DEFAULT_HDOP;
+#else
+    float hdop = ALORA_GPS_FUSION_DEFAULT_HDOP;
+#endif
+    float horizontalVariance = hdop * ALORA_GPS_FUSION_UERE * hdop * ALORA_GPS_FUSION_UERE;
+    float verticalVariance = horizontalVariance * ALORA_GPS_FUSION_VERTICAL_FACTOR * ALORA_GPS_FUSION_VERTICAL_FACTOR;
+
+    float velocity[3] = { 0.0f, 0.0f, 0.0f };
+    bool hasVelocity = fix.valid.speed && fix.valid.heading;
+    if (hasVelocity) {
+        float speed = fix.speed_metersph() * (1.0f / 3600.0f);
+        float heading = fix.heading() * (float) DEG_TO_RAD;
+
+        velocity[0] = speed * sinf(heading);
+        velocity[1] = speed * cosf(heading);
+    }
+
+    if (initialized) {
+        advance(timestamp);
+    }
+
+    float position[3];
+    toLocal(fix.latitudeL(), fix.longitudeL(), position[0], position[1]);
+    position[2] = fix.valid.altitude ? fix.altitude() : axes[2].x[0];
+
+    if (!initialized) {
+        setOrigin(fix.latitudeL(), fix.longitudeL());
+        position[0] = 0.0f;
+        position[1] = 0.0f;
+        start(position, hasVelocity ? velocity : NULL, horizontalVariance, verticalVariance);
+        lastMicros = timestamp;
+        initialized = true;
+
+        return true;
+    }
+
+    if (!inGate(axes[0], position[0], horizontalVariance) || !inGate(axes[1], position[1], horizontalVariance)) {
+        if (++rejects < ALORA_GPS_FUSION_MAX_REJECTS) {
+            return false;
+        }
+
+        // the estimate diverged, trust the receiver again
+        setOrigin(fix.latitudeL(), fix.longitudeL());
+        position[0] = 0.0f;
+        position[1] = 0.0f;
+        start(position, hasVelocity ? velocity : NULL, horizontalVariance, verticalVariance);
+
+        return true;
+    }
+
+    rejects = 0;
+
+    update(axes[0], 0, position[0], horizontalVariance);
+    update(axes[1], 0, position[1], horizontalVariance);
+    if (fix.valid.altitude) {
+        update(axes[2], 0, position[2], verticalVariance);
+    }
+
+    if (hasVelocity) {
+        const float velocityVariance = ALORA_GPS_FUSION_VELOCITY_SIGMA * ALORA_GPS_FUSION_VELOCITY_SIGMA;
+
+        update(axes[0], 1, velocity[0], velocityVariance);
+        update(axes[1], 1, velocity[1], velocityVariance);
+    }
+
+    // keep the linearization error and the float resolution small
+    float east = axes[0].x[0];
+    float north = axes[1].x[0];
+    if (fabsf(east) > ALORA_GPS_FUSION_REORIGIN_M || fabsf(north) > ALORA_GPS_FUSION_REORIGIN_M) {
+        int32_t latitude = originLatitude + (int32_t) lroundf(north / northScale);
+        int32_t longitude = originLongitude + (int32_t) lroundf(east / eastScale);
+        float shiftEast, shiftNorth;
+
+        toLocal(latitude, longitude, shiftEast, shiftNorth);
+        axes[0].x[0] -= shiftEast;
+        axes[1].x[0] -= shiftNorth;
+        setOrigin(latitude, longitude);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Check whether a fix started the filter
+ *
+ * @return true if position queries are valid
+ */
+bool AloraGPSFusion::isInitialized() {
+    return initialized;
+}
+
+/**
+ * @brief Get position and velocity extrapolated to a point in time. The
+ * filter state is not changed, so it can be queried at any rate.
+ *
+ * @param timestamp micros() of the query, times before the last IMU sample or fix return that state
+ * @param position fused position will be stored here
+ * @return true if the filter is initialized
+ */
+bool AloraGPSFusion::getPosition(uint32_t timestamp, AloraFusedPosition& position) {
+    if (!initialized) {
+        return false;
+    }
+
+    Axis predicted[3];
+    memcpy(predicted, axes, sizeof(predicted));
+
+    int32_t elapsed = (int32_t) (timestamp - lastMicros);
+    if (elapsed > 0) {
+        step(predicted, accel, elapsed * 1e-6f);
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        position.position[i] = predicted[i].x[0];
+        position.velocity[i] = predicted[i].x[1];
+        position.positionVariance[i] = predicted[i].p[0][0];
+        position.velocityVariance[i] = predicted[i].p[1][1];
+    }
+
+    position.latitudeL = originLatitude + (int32_t) lroundf(predicted[1].x[0] / northScale);
+    position.longitudeL = originLongitude + (int32_t) lroundf(predicted[0].x[0] / eastScale);
+    position.altitude = predicted[2].x[0];
+
+    return true;
+}
+
+void AloraGPSFusion::start(const float position[3], const float* velocity, float horizontalVariance, float verticalVariance) {
+    const float velocityVariance = velocity != NULL
+        ? ALORA_GPS_FUSION_VELOCITY_SIGMA * ALORA_GPS_FUSION_VELOCITY_SIGMA
+        : ALORA_GPS_FUSION_INITIAL_VELOCITY_SIGMA * ALORA_GPS_FUSION_INITIAL_VELOCITY_SIGMA;
+
+    memset(axes, 0, sizeof(axes));
+
+    for (uint8_t i = 0; i < 3; i++) {
+        axes[i].x[0] = position[i];
+        axes[i].x[1] = velocity != NULL ? velocity[i] : 0.0f;
+        axes[i].p[0][0] = i < 2 ? horizontalVariance : verticalVariance;
+        axes[i].p[1][1] = velocityVariance;
+        axes[i].p[2][2] = ALORA_GPS_FUSION_INITIAL_BIAS_SIGMA * ALORA_GPS_FUSION_INITIAL_BIAS_SIGMA;
+    }
+
+    rejects = 0;
+}
+
+/**
+ * @brief Move the local origin and compute the WGS84 meters per unit there
+ */
+void AloraGPSFusion::setOrigin(int32_t latitude, int32_t longitude) {
+    const float a = 6378137.0f;
+    const float e2 = 6.69437999e-3f;
+    const float unit = 1e-7f * (float) DEG_TO_RAD;
+
+    float phi = latitude * unit;
+    float s = sinf(phi);
+    float w = 1.0f - e2 * s * s;
+    float sqrtW = sqrtf(w);
+
+    originLatitude = latitude;
+    originLongitude = longitude;
+    northScale = a * (1.0f - e2) / (w * sqrtW) * unit;
+    eastScale = a / sqrtW * cosf(phi) * unit;
+}
+
+void AloraGPSFusion::toLocal(int32_t latitude, int32_t longitude, float& east, float& north) {
+    int64_t deltaLongitude = (int64_t) longitude - originLongitude;
+
+    // shortest way across the antimeridian
+    if (deltaLongitude > 1800000000LL) {
+        deltaLongitude -= 3600000000LL;
+    } else if (deltaLongitude < -1800000000LL) {
+        deltaLongitude += 3600000000LL;
+    }
+
+    north = ((int64_t) latitude - originLatitude) * northScale;
+    east = deltaLongitude * eastScale;
+}
+
+void AloraGPSFusion::advance(uint32_t timestamp) {
+    int32_t elapsed = (int32_t) (timestamp - lastMicros);
+    if (elapsed <= 0) {
+        return;
+    }
+
+    step(axes, accel, elapsed * 1e-6f);
+    lastMicros = timestamp;
+}
+
+/**
+ * @brief Propagate all axes, holding the acceleration for at most
+ * ALORA_GPS_FUSION_MAX_HOLD and coasting for the rest of the interval
+ */
+void AloraGPSFusion::step(Axis* axes, const float* accel, float dt) {
+    float hold = dt < ALORA_GPS_FUSION_MAX_HOLD ? dt : ALORA_GPS_FUSION_MAX_HOLD;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        propagate(axes[i], accel[i], hold);
+
+        // bias as input is zero acceleration after bias removal
+        if (dt > hold) {
+            propagate(axes[i], axes[i].x[2], dt - hold);
+        }
+    }
+}
+
+void AloraGPSFusion::propagate(Axis& axis, float accel, float dt) {
+    float half = 0.5f * dt * dt;
+    float a = accel - axis.x[2];
+
+    axis.x[0] += axis.x[1] * dt + a * half;
+    axis.x[1] += a * dt;
+
+    // P = F P F^T with F = [1 dt -half; 0 1 -dt; 0 0 1]
+    float (*p)[3] = axis.p;
+    float fp[3][3];
+    for (uint8_t j = 0; j < 3; j++) {
+        fp[0][j] = p[0][j] + dt * p[1][j] - half * p[2][j];
+        fp[1][j] = p[1][j] - dt * p[2][j];
+        fp[2][j] = p[2][j];
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        p[i][0] = fp[i][0] + dt * fp[i][1] - half * fp[i][2];
+        p[i][1] = fp[i][1] - dt * fp[i][2];
+        p[i][2] = fp[i][2];
+    }
+
+    // white acceleration noise held over the step, bias random walk
+    const float q = ALORA_GPS_FUSION_ACCEL_SIGMA * ALORA_GPS_FUSION_ACCEL_SIGMA;
+    p[0][0] += q * half * half;
+    p[0][1] += q * half * dt;
+    p[1][0] += q * half * dt;
+    p[1][1] += q * dt * dt;
+    p[2][2] += ALORA_GPS_FUSION_BIAS_SIGMA * ALORA_GPS_FUSION_BIAS_SIGMA * dt;
+}
+
+bool AloraGPSFusion::inGate(const Axis& axis, float measurement, float variance) {
+    float innovation = measurement - axis.x[0];
+
+    return innovation * innovation <= ALORA_GPS_FUSION_GATE * ALORA_GPS_FUSION_GATE * (axis.p[0][0] + variance);
+}
+
+/**
+ * @brief Scalar Kalman update of one state element
+ */
+void AloraGPSFusion::update(Axis& axis, uint8_t index, float measurement, float variance) {
+    float (*p)[3] = axis.p;
+    float innovation = measurement - axis.x[index];
+    float inverse = 1.0f / (p[index][index] + variance);
+    float gain[3];
+    float row[3];
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gain[i] = p[i][index] * inverse;
+        row[i] = p[index][i];
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        axis.x[i] += gain[i] * innovation;
+
+        for (uint8_t j = i; j < 3; j++) {
+            p[i][j] -= gain[i] * row[j];
+            p[j][i] = p[i][j];
+        }
+    }
+}
@@ -0,0 +1,130 @@
+/** @file */
+
+#ifndef ALORA_GPS_FUSION_H
+#define ALORA_GPS_FUSION_H
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+
+/** Standard deviation of the earth-frame acceleration input in m/s^2, covers sensor noise and attitude error */
+#if !defined(ALORA_GPS_FUSION_ACCEL_SIGMA)
+    #define ALORA_GPS_FUSION_ACCEL_SIGMA 0.5f
+#endif
+
+/** Random walk of the acceleration bias in m/s^2 per square root of a second */
+#if !defined(ALORA_GPS_FUSION_BIAS_SIGMA)
+    #define ALORA_GPS_FUSION_BIAS_SIGMA 0.01f
+#endif
+
+/** Horizontal position error in meters at HDOP 1 */
+#if !defined(ALORA_GPS_FUSION_UERE)
+    #define ALORA_GPS_FUSION_UERE 3.0f
+#endif
+
+/** HDOP assumed for a fix without one, and for every fix when NeoGPS is built without GPS_FIX_HDOP */
+#if !defined(ALORA_GPS_FUSION_DEFAULT_HDOP)
+    #define ALORA_GPS_FUSION_DEFAULT_HDOP 2.0f
+#endif
+
+/** Vertical position error relative to the horizontal one */
+#if !defined(ALORA_GPS_FUSION_VERTICAL_FACTOR)
+    #define ALORA_GPS_FUSION_VERTICAL_FACTOR 2.0f
+#endif
+
+/** Standard deviation of the GPS horizontal velocity in m/s */
+#if !defined(ALORA_GPS_FUSION_VELOCITY_SIGMA)
+    #define ALORA_GPS_FUSION_VELOCITY_SIGMA 0.5f
+#endif
+
+/** Innovation gate in standard deviations. A fix outside it is rejected */
+#if !defined(ALORA_GPS_FUSION_GATE)
+    #define ALORA_GPS_FUSION_GATE 5.0f
+#endif
+
+/** Consecutive rejected fixes after which the filter restarts at the fix */
+#if !defined(ALORA_GPS_FUSION_MAX_REJECTS)
+    #define ALORA_GPS_FUSION_MAX_REJECTS 5
+#endif
+
+/** Longest time in seconds an acceleration sample is held. Beyond it the filter coasts at constant velocity */
+#if !defined(ALORA_GPS_FUSION_MAX_HOLD)
+    #define ALORA_GPS_FUSION_MAX_HOLD 0.1f
+#endif
+
+/** Distance in meters from the local origin after which the origin moves to the current position */
+#if !defined(ALORA_GPS_FUSION_REORIGIN_M)
+    #define ALORA_GPS_FUSION_REORIGIN_M 10000.0f
+#endif
+
+/** Magnetic declination in degrees, east positive. Rotates the magnetic-north IMU frame to true north */
+#if !defined(ALORA_GPS_FUSION_DECLINATION_DEG)
+    #define ALORA_GPS_FUSION_DECLINATION_DEG 0.0f
+#endif
+
+/**
+ * @brief Fused position and velocity at one point in time
+ */
+struct AloraFusedPosition {
+    int32_t latitudeL;                      /**< Latitude in degrees * 10^7, the NeoGPS integer format */
+    int32_t longitudeL;                     /**< Longitude in degrees * 10^7 */
+    float altitude;                         /**< Altitude in meters */
+    float position[3];                      /**< East, north, up offset in meters from the local origin */
+    float velocity[3];                      /**< East, north, up velocity in m/s */
+    float positionVariance[3];              /**< East, north, up position variance in m^2 */
+    float velocityVariance[3];              /**< East, north, up velocity variance in (m/s)^2 */
+};
+
+/**
+ * @brief Loosely coupled GPS and IMU position filter.
+ *
+ * The IMU gives gravity-free acceleration in a local east-north-up frame,
+ * it is integrated by predict() at the IMU rate. Every GPS fix corrects the
+ * estimate through correct(). Latitude and longitude are linearized around a
+ * local origin, the only non-linear part of the model, which moves along with
+ * the receiver.
+ *
+ * With the attitude taken from the orientation filter, the axes are
+ * independent, so the filter runs as three Kalman filters of position,
+ * velocity and acceleration bias. Each step costs the same fixed number of
+ * float operations on a 3 x 3 covariance per axis.
+ */
+class AloraGPSFusion {
+public:
+    AloraGPSFusion();
+
+    void reset();
+    void predict(float east, float north, float up, uint32_t timestamp);
+    bool correct(const gps_fix& fix, uint32_t timestamp);
+    bool isInitialized();
+    bool getPosition(uint32_t timestamp, AloraFusedPosition& position);
+
+private:
+    /**
+     * @brief State of one axis: position, velocity and acceleration bias
+     */
+    struct Axis {
+        float x[3];                         /**< Position in m, velocity in m/s, bias in m/s^2 */
+        float p[3][3];                      /**< State covariance */
+    };
+
+    Axis axes[3];                           /**< East, north and up filters */
+    float accel[3];                         /**< Latest east, north, up acceleration in m/s^2 */
+    uint32_t lastMicros;                    /**< Time the state belongs to */
+    bool initialized;                       /**< Whether a fix started the filter */
+    uint8_t rejects;                        /**< Consecutive fixes outside the gate */
+    int32_t originLatitude;                 /**< Local origin latitude in degrees * 10^7 */
+    int32_t originLongitude;                /**< Local origin longitude in degrees * 10^7 */
+    float northScale;                       /**< Meters per 10^-7 degree of latitude at the origin */
+    float eastScale;                        /**< Meters per 10^-7 degree of longitude at the origin */
+
+    void start(const float position[3], const float* velocity, float horizontalVariance, float verticalVariance);
+    void setOrigin(int32_t latitude, int32_t longitude);
+    void toLocal(int32_t latitude, int32_t longitude, float& east, float& north);
+    void advance(uint32_t timestamp);
+    static void step(Axis* axes, const float* accel, float dt);
+    static void propagate(Axis& axis, float accel, float dt);
+    static bool inGate(const Axis& axis, float measurement, float variance);
+    static void update(Axis& axis, uint8_t index, float measurement, float variance);
+};
+
+#endif
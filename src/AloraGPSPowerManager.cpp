@@ -0,0 +1,113 @@
+/** @file */
+
+#include "AloraGPSPowerManager.h"
+
+AloraGPSPowerManager::AloraGPSPowerManager() {
+    reset(0);
+}
+
+/**
+ * @brief Start a new on period
+ *
+ * @param now millis()
+ */
+void AloraGPSPowerManager::reset(uint32_t now) {
+    on = true;
+    moving = false;
+    movingAtOff = false;
+    onMillis = now;
+    offMillis = now;
+    offInterval = ALORA_GPS_POWER_MOVING_INTERVAL_S * 1000UL;
+}
+
+/**
+ * @brief Advance the duty cycle
+ *
+ * @param now millis()
+ * @param moving whether the IMU detects motion
+ * @return true if the receiver should be powered
+ */
+bool AloraGPSPowerManager::update(uint32_t now, bool moving) {
+    this->moving = moving;
+
+    if (on) {
+        if (now - onMillis >= ALORA_GPS_POWER_ACQUIRE_TIMEOUT_S * 1000UL) {
+            // no good fix here, try again later instead of burning the battery
+            turnOff(now, moving);
+        }
+
+        return on;
+    }
+
+    uint32_t elapsed = now - offMillis;
+    bool woken = moving && !movingAtOff && elapsed >= ALORA_GPS_POWER_MOVING_INTERVAL_S * 1000UL;
+
+    if (woken || elapsed >= offInterval) {
+        on = true;
+        onMillis = now;
+    }
+
+    return on;
+}
+
+/**
+ * @brief Check a fix received while the receiver is on
+ *
+ * @param fix fix from NMEAGPS
+ * @param now millis()
+ * @return true if the fix is good enough and the receiver should be turned off
+ */
+bool AloraGPSPowerManager::onFix(const gps_fix& fix, uint32_t now) {
+    if (!on || !fix.valid.location) {
+        return false;
+    }
+
+#ifdef GPS_FIX_HDOP
+    if (!fix.valid.hdop || fix.hdop > ALORA_GPS_POWER_MAX_HDOP * 1000) {
+        return false;
+    }
+#else
+    // without HDOP only a standard fix or better counts
+    if (!fix.valid.status || fix.status < gps_fix::STATUS_STD) {
+        return false;
+    }
+#endif
+
+    bool driving = fix.valid.speed && fix.speed_metersph() > ALORA_GPS_POWER_MOVING_SPEED * 3600;
+    turnOff(now, moving || driving);
+
+    return true;
+}
+
+/**
+ * @brief Check whether the receiver should be powered
+ *
+ * @return true while waiting for a fix
+ */
+bool AloraGPSPowerManager::isOn() {
+    return on;
+}
+
+/**
+ * @brief Get the off time of the current cycle
+ *
+ * @return uint32_t off time in milliseconds
+ */
+uint32_t AloraGPSPowerManager::getOffInterval() {
+    return offInterval;
+}
+
+void AloraGPSPowerManager::turnOff(uint32_t now, bool moving) {
+    const uint32_t movingInterval = ALORA_GPS_POWER_MOVING_INTERVAL_S * 1000UL;
+    const uint32_t stillInterval = ALORA_GPS_POWER_STILL_INTERVAL_S * 1000UL;
+
+    if (moving) {
+        offInterval = movingInterval;
+    } else {
+        offInterval = offInterval < stillInterval / 2 ? offInterval * 2 : stillInterval;
+    }
+
+    on = false;
+    movingAtOff = moving;
+    offMillis = now;
+}
@@ -0,0 +1,69 @@
+/** @file */
+
+#ifndef ALORA_GPS_POWER_MANAGER_H
+#define ALORA_GPS_POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+
+/** Largest HDOP of a fix that ends an on period */
+#if !defined(ALORA_GPS_POWER_MAX_HDOP)
+    #define ALORA_GPS_POWER_MAX_HDOP 2.0f
+#endif
+
+/** Time in seconds the receiver stays off between fixes while moving */
+#if !defined(ALORA_GPS_POWER_MOVING_INTERVAL_S)
+    #define ALORA_GPS_POWER_MOVING_INTERVAL_S 30
+#endif
+
+/** Longest time in seconds the receiver stays off while still. The off time doubles every cycle up to it */
+#if !defined(ALORA_GPS_POWER_STILL_INTERVAL_S)
+    #define ALORA_GPS_POWER_STILL_INTERVAL_S 900
+#endif
+
+/** Longest time in seconds the receiver stays on waiting for a good fix */
+#if !defined(ALORA_GPS_POWER_ACQUIRE_TIMEOUT_S)
+    #define ALORA_GPS_POWER_ACQUIRE_TIMEOUT_S 120
+#endif
+
+/** GPS speed in m/s above which the board counts as moving */
+#if !defined(ALORA_GPS_POWER_MOVING_SPEED)
+    #define ALORA_GPS_POWER_MOVING_SPEED 1.0f
+#endif
+
+/**
+ * @brief Duty cycle of the GPS receiver.
+ *
+ * The receiver is on until a fix with HDOP at most ALORA_GPS_POWER_MAX_HDOP
+ * arrives (any standard fix when NeoGPS is built without GPS_FIX_HDOP), or
+ * for ALORA_GPS_POWER_ACQUIRE_TIMEOUT_S without one, then off for
+ * an interval chosen by motion. While moving, the off time is
+ * ALORA_GPS_POWER_MOVING_INTERVAL_S. While still, it doubles with every
+ * cycle up to ALORA_GPS_POWER_STILL_INTERVAL_S. Motion during a still off
+ * period wakes the receiver as soon as the moving interval has passed.
+ *
+ * The class only decides, the caller switches the power. AloraSensorKit does
+ * that through the GPS enable pin.
+ */
+class AloraGPSPowerManager {
+public:
+    AloraGPSPowerManager();
+
+    void reset(uint32_t now);
+    bool update(uint32_t now, bool moving);
+    bool onFix(const gps_fix& fix, uint32_t now);
+    bool isOn();
+    uint32_t getOffInterval();
+
+private:
+    bool on;                                /**< Whether the receiver should be powered */
+    bool moving;                            /**< Motion reported by the last update() */
+    bool movingAtOff;                       /**< Motion when the receiver was turned off */
+    uint32_t onMillis;                      /**< Time the receiver was turned on */
+    uint32_t offMillis;                     /**< Time the receiver was turned off */
+    uint32_t offInterval;                   /**< Off time of the current cycle in milliseconds */
+
+    void turnOff(uint32_t now, bool moving);
+};
+
+#endif
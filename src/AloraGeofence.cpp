@@ -0,0 +1,339 @@
+/** @file */
+
+#include "AloraGeofence.h"
+
+AloraGeofence::AloraGeofence() {
+    clear();
+}
+
+/**
+ * @brief Remove all zones and their state
+ */
+void AloraGeofence::clear() {
+    zoneCount = 0;
+    vertexCount = 0;
+    indexed = false;
+    activeCount = 0;
+    activeOverflow = false;
+    eventCount = 0;
+    fixCount = 0;
+
+    memset(inside, 0, sizeof(inside));
+    memset(pending, 0, sizeof(pending));
+    memset(visited, 0, sizeof(visited));
+}
+
+/**
+ * @brief Add a polygon zone. Call build() after the last zone.
+ *
+ * @param zoneId identifier reported in events
+ * @param latitudes vertex latitudes in degrees * 10^7
+ * @param longitudes vertex longitudes in degrees * 10^7
+ * @param count number of vertices, at least 3. The polygon is closed implicitly
+ * @return true if the zone fits into the storage
+ */
+bool AloraGeofence::addZone(uint16_t zoneId, const int32_t* latitudes, const int32_t* longitudes, uint16_t count) {
+    if (count < 3 || zoneCount >= ALORA_GEOFENCE_MAX_ZONES || count > ALORA_GEOFENCE_MAX_VERTICES - vertexCount) {
+        return false;
+    }
+
+    Zone& zone = zones[zoneCount];
+    zone.id = zoneId;
+    zone.firstVertex = vertexCount;
+    zone.vertexCount = count;
+    zone.minLatitude = latitudes[0];
+    zone.maxLatitude = latitudes[0];
+    zone.minLongitude = longitudes[0];
+    zone.maxLongitude = longitudes[0];
+
+    for (uint16_t i = 0; i < count; i++) {
+        this->latitudes[vertexCount + i] = latitudes[i];
+        this->longitudes[vertexCount + i] = longitudes[i];
+
+        zone.minLatitude = latitudes[i] < zone.minLatitude ? latitudes[i] : zone.minLatitude;
+        zone.maxLatitude = latitudes[i] > zone.maxLatitude ? latitudes[i] : zone.maxLatitude;
+        zone.minLongitude = longitudes[i] < zone.minLongitude ? longitudes[i] : zone.minLongitude;
+        zone.maxLongitude = longitudes[i] > zone.maxLongitude ? longitudes[i] : zone.maxLongitude;
+    }
+
+    vertexCount += count;
+    zoneCount++;
+    indexed = false;
+
+    return true;
+}
+
+/**
+ * @brief Build the grid index over all zones. update() reports nothing until
+ * the index is built.
+ *
+ * @return true if the zone references fit into ALORA_GEOFENCE_MAX_CELL_ENTRIES
+ */
+bool AloraGeofence::build() {
+    indexed = false;
+    memset(cellStart, 0, sizeof(cellStart));
+
+    if (zoneCount == 0) {
+        return false;
+    }
+
+    int32_t minLatitude = zones[0].minLatitude;
+    int32_t maxLatitude = zones[0].maxLatitude;
+    int32_t minLongitude = zones[0].minLongitude;
+    int32_t maxLongitude = zones[0].maxLongitude;
+
+    for (uint16_t z = 1; z < zoneCount; z++) {
+        minLatitude = zones[z].minLatitude < minLatitude ? zones[z].minLatitude : minLatitude;
+        maxLatitude = zones[z].maxLatitude > maxLatitude ? zones[z].maxLatitude : maxLatitude;
+        minLongitude = zones[z].minLongitude < minLongitude ? zones[z].minLongitude : minLongitude;
+        maxLongitude = zones[z].maxLongitude > maxLongitude ? zones[z].maxLongitude : maxLongitude;
+    }
+
+    gridLatitude = minLatitude;
+    gridLongitude = minLongitude;
+    cellHeight = (uint32_t) (((int64_t) maxLatitude - minLatitude) / ALORA_GEOFENCE_GRID_SIZE + 1);
+    cellWidth = (uint32_t) (((int64_t) maxLongitude - minLongitude) / ALORA_GEOFENCE_GRID_SIZE + 1);
+
+    // count references per cell into cellStart[cell + 1]
+    uint32_t entries = 0;
+    for (uint16_t z = 0; z < zoneCount; z++) {
+        const Zone& zone = zones[z];
+        uint16_t row0 = ((int64_t) zone.minLatitude - gridLatitude) / cellHeight;
+        uint16_t row1 = ((int64_t) zone.maxLatitude - gridLatitude) / cellHeight;
+        uint16_t column0 = ((int64_t) zone.minLongitude - gridLongitude) / cellWidth;
+        uint16_t column1 = ((int64_t) zone.maxLongitude - gridLongitude) / cellWidth;
+
+        for (uint16_t row = row0; row <= row1; row++) {
+            for (uint16_t column = column0; column <= column1; column++) {
+                cellStart[row * ALORA_GEOFENCE_GRID_SIZE + column + 1]++;
+            }
+        }
+
+        entries += (row1 - row0 + 1) * (column1 - column0 + 1);
+    }
+
+    if (entries > ALORA_GEOFENCE_MAX_CELL_ENTRIES) {
+        return false;
+    }
+
+    for (uint16_t cell = 0; cell < CELLS; cell++) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+
+    // fill, cellStart[cell] is the cursor and ends at the start of the next cell
+    for (uint16_t z = 0; z < zoneCount; z++) {
+        const Zone& zone = zones[z];
+        uint16_t row0 = ((int64_t) zone.minLatitude - gridLatitude) / cellHeight;
+        uint16_t row1 = ((int64_t) zone.maxLatitude - gridLatitude) / cellHeight;
+        uint16_t column0 = ((int64_t) zone.minLongitude - gridLongitude) / cellWidth;
+        uint16_t column1 = ((int64_t) zone.maxLongitude - gridLongitude) / cellWidth;
+
+        for (uint16_t row = row0; row <= row1; row++) {
+            for (uint16_t column = column0; column <= column1; column++) {
+                cellZones[cellStart[row * ALORA_GEOFENCE_GRID_SIZE + column]++] = z;
+            }
+        }
+    }
+
+    for (uint16_t cell = CELLS; cell > 0; cell--) {
+        cellStart[cell] = cellStart[cell - 1];
+    }
+
+    cellStart[0] = 0;
+    indexed = true;
+
+    return true;
+}
+
+/**
+ * @brief Evaluate a GPS fix
+ *
+ * @param fix fix from NMEAGPS, ignored without a valid location
+ * @return uint8_t number of enter and exit events, read them with getEvent()
+ */
+uint8_t AloraGeofence::update(const gps_fix& fix) {
+    if (!fix.valid.location) {
+        eventCount = 0;
+        return 0;
+    }
+
+    return update(fix.latitudeL(), fix.longitudeL());
+}
+
+/**
+ * @brief Evaluate a position
+ *
+ * @param latitude latitude in degrees * 10^7
+ * @param longitude longitude in degrees * 10^7
+ * @return uint8_t number of enter and exit events, read them with getEvent()
+ */
+uint8_t AloraGeofence::update(int32_t latitude, int32_t longitude) {
+    eventCount = 0;
+
+    if (!indexed) {
+        return 0;
+    }
+
+    if (++fixCount == 0) {
+        memset(visited, 0, sizeof(visited));
+        fixCount = 1;
+    }
+
+    uint16_t nextActive[ALORA_GEOFENCE_MAX_ACTIVE];
+    uint8_t nextCount = 0;
+
+    int64_t row = ((int64_t) latitude - gridLatitude) / (int64_t) cellHeight;
+    int64_t column = ((int64_t) longitude - gridLongitude) / (int64_t) cellWidth;
+
+    if (latitude >= gridLatitude && longitude >= gridLongitude && row < ALORA_GEOFENCE_GRID_SIZE && column < ALORA_GEOFENCE_GRID_SIZE) {
+        uint16_t cell = row * ALORA_GEOFENCE_GRID_SIZE + column;
+
+        for (uint16_t entry = cellStart[cell]; entry < cellStart[cell + 1]; entry++) {
+            uint16_t z = cellZones[entry];
+            visited[z] = fixCount;
+            evaluate(z, contains(zones[z], latitude, longitude), nextActive, nextCount);
+        }
+    }
+
+    // zones outside the current cell cannot contain the position
+    if (activeOverflow) {
+        // the active list was truncated, find the zones it missed
+        activeOverflow = false;
+
+        for (uint16_t z = 0; z < zoneCount; z++) {
+            if (visited[z] != fixCount && ((inside[z >> 3] & (1 << (z & 7))) || pending[z] > 0)) {
+                visited[z] = fixCount;
+                evaluate(z, false, nextActive, nextCount);
+            }
+        }
+    } else {
+        for (uint8_t i = 0; i < activeCount; i++) {
+            uint16_t z = active[i];
+
+            if (visited[z] != fixCount) {
+                visited[z] = fixCount;
+                evaluate(z, false, nextActive, nextCount);
+            }
+        }
+    }
+
+    memcpy(active, nextActive, nextCount * sizeof(active[0]));
+    activeCount = nextCount;
+
+    return eventCount;
+}
+
+/**
+ * @brief Get an event of the last update()
+ *
+ * @param index event index, 0 to the update() result - 1
+ * @param event event will be stored here
+ * @return true if the index is valid
+ */
+bool AloraGeofence::getEvent(uint8_t index, AloraGeofenceEvent& event) {
+    if (index >= eventCount) {
+        return false;
+    }
+
+    event = events[index];
+
+    return true;
+}
+
+/**
+ * @brief Check whether the last positions are inside a zone
+ *
+ * @param zoneId identifier passed to addZone()
+ * @return true if inside, false if outside or unknown
+ */
+bool AloraGeofence::isInside(uint16_t zoneId) {
+    int16_t z = findZone(zoneId);
+
+    return z >= 0 && (inside[z >> 3] & (1 << (z & 7)));
+}
+
+/**
+ * @brief Get number of zones
+ *
+ * @return uint16_t number of zones added since clear()
+ */
+uint16_t AloraGeofence::getZoneCount() {
+    return zoneCount;
+}
+
+/**
+ * @brief Exact even-odd point-in-polygon test
+ */
+bool AloraGeofence::contains(const Zone& zone, int32_t latitude, int32_t longitude) {
+    if (latitude < zone.minLatitude || latitude > zone.maxLatitude || longitude < zone.minLongitude || longitude > zone.maxLongitude) {
+        return false;
+    }
+
+    const int32_t* y = &latitudes[zone.firstVertex];
+    const int32_t* x = &longitudes[zone.firstVertex];
+    bool result = false;
+
+    for (uint16_t i = 0, j = zone.vertexCount - 1; i < zone.vertexCount; j = i++) {
+        if ((y[i] > latitude) == (y[j] > latitude)) {
+            continue;
+        }
+
+        // is the position left of the edge crossing at its latitude
+        int64_t dy = (int64_t) y[j] - y[i];
+        int64_t left = ((int64_t) longitude - x[i]) * dy;
+        int64_t right = ((int64_t) latitude - y[i]) * ((int64_t) x[j] - x[i]);
+
+        if (dy > 0 ? left < right : left > right) {
+            result = !result;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Debounce the inside test of one zone and keep it active while it is
+ * inside or changing. A change without room for its event is kept pending
+ * until the next fix, a zone without room in the active list makes the next
+ * update() scan all zones.
+ */
+void AloraGeofence::evaluate(uint16_t zone, bool isInside, uint16_t* nextActive, uint8_t& nextCount) {
+    uint8_t mask = 1 << (zone & 7);
+    bool state = (inside[zone >> 3] & mask) != 0;
+
+    if (isInside == state) {
+        pending[zone] = 0;
+    } else {
+        if (pending[zone] < ALORA_GEOFENCE_DEBOUNCE) {
+            pending[zone]++;
+        }
+
+        if (pending[zone] >= ALORA_GEOFENCE_DEBOUNCE && eventCount < ALORA_GEOFENCE_MAX_ACTIVE) {
+            pending[zone] = 0;
+            state = isInside;
+            inside[zone >> 3] ^= mask;
+
+            events[eventCount].zoneId = zones[zone].id;
+            events[eventCount].entered = state;
+            eventCount++;
+        }
+    }
+
+    if (state || pending[zone] > 0) {
+        if (nextCount < ALORA_GEOFENCE_MAX_ACTIVE) {
+            nextActive[nextCount++] = zone;
+        } else {
+            activeOverflow = true;
+        }
+    }
+}
+
+int16_t AloraGeofence::findZone(uint16_t zoneId) {
+    for (uint16_t z = 0; z < zoneCount; z++) {
+        if (zones[z].id == zoneId) {
+            return z;
+        }
+    }
+
+    return -1;
+}
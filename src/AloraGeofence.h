@@ -0,0 +1,123 @@
+/** @file */
+
+#ifndef ALORA_GEOFENCE_H
+#define ALORA_GEOFENCE_H
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+
+/** Largest number of zones */
+#if !defined(ALORA_GEOFENCE_MAX_ZONES)
+    #define ALORA_GEOFENCE_MAX_ZONES 512
+#endif
+
+/** Largest number of polygon vertices over all zones */
+#if !defined(ALORA_GEOFENCE_MAX_VERTICES)
+    #define ALORA_GEOFENCE_MAX_VERTICES 4096
+#endif
+
+/** Number of grid cells per side of the spatial index */
+#if !defined(ALORA_GEOFENCE_GRID_SIZE)
+    #define ALORA_GEOFENCE_GRID_SIZE 32
+#endif
+
+/** Largest number of zone references over all grid cells */
+#if !defined(ALORA_GEOFENCE_MAX_CELL_ENTRIES)
+    #define ALORA_GEOFENCE_MAX_CELL_ENTRIES 4096
+#endif
+
+/** Number of zones that are inside or changing tracked without scanning all zones */
+#if !defined(ALORA_GEOFENCE_MAX_ACTIVE)
+    #define ALORA_GEOFENCE_MAX_ACTIVE 32
+#endif
+
+/** Consecutive fixes that must agree before a zone is entered or left, filters jitter on a boundary */
+#if !defined(ALORA_GEOFENCE_DEBOUNCE)
+    #define ALORA_GEOFENCE_DEBOUNCE 2
+#endif
+
+/**
+ * @brief Zone enter or exit reported by AloraGeofence::update()
+ */
+struct AloraGeofenceEvent {
+    uint16_t zoneId;                        /**< Identifier passed to addZone() */
+    bool entered;                           /**< true on enter, false on exit */
+};
+
+/**
+ * @brief Polygon geofences with a grid index and incremental enter/exit
+ * detection.
+ *
+ * Zones are simple polygons in NeoGPS integer coordinates (degrees * 10^7).
+ * build() spreads the zone bounding boxes over a uniform grid covering all
+ * zones, so a fix is only tested against the zones listed in its cell. The
+ * point-in-polygon test runs on integers with 64-bit cross products, so it
+ * is exact. Only zones of the current cell and zones that are currently
+ * inside are evaluated, the cost of a fix does not grow with the number of
+ * distant zones. Beyond ALORA_GEOFENCE_MAX_ACTIVE zones inside at once a fix
+ * scans all zones, and beyond ALORA_GEOFENCE_MAX_ACTIVE changes in one fix the
+ * rest are reported on the next fixes.
+ *
+ * Storage is fixed member arrays sized at compile time. Polygons must not
+ * cross the antimeridian.
+ */
+class AloraGeofence {
+public:
+    AloraGeofence();
+
+    void clear();
+    bool addZone(uint16_t zoneId, const int32_t* latitudes, const int32_t* longitudes, uint16_t count);
+    bool build();
+
+    uint8_t update(const gps_fix& fix);
+    uint8_t update(int32_t latitude, int32_t longitude);
+    bool getEvent(uint8_t index, AloraGeofenceEvent& event);
+    bool isInside(uint16_t zoneId);
+    uint16_t getZoneCount();
+
+private:
+    /**
+     * @brief Polygon and bounding box of one zone
+     */
+    struct Zone {
+        uint16_t id;                        /**< Identifier passed to addZone() */
+        uint16_t firstVertex;               /**< Index of the first vertex in latitudes and longitudes */
+        uint16_t vertexCount;               /**< Number of vertices */
+        int32_t minLatitude;                /**< Bounding box */
+        int32_t maxLatitude;                /**< Bounding box */
+        int32_t minLongitude;               /**< Bounding box */
+        int32_t maxLongitude;               /**< Bounding box */
+    };
+
+    static const uint16_t CELLS = ALORA_GEOFENCE_GRID_SIZE * ALORA_GEOFENCE_GRID_SIZE;
+
+    Zone zones[ALORA_GEOFENCE_MAX_ZONES];   /**< Zones in insertion order */
+    int32_t latitudes[ALORA_GEOFENCE_MAX_VERTICES];  /**< Vertex latitudes of all zones */
+    int32_t longitudes[ALORA_GEOFENCE_MAX_VERTICES]; /**< Vertex longitudes of all zones */
+    uint16_t zoneCount;                     /**< Number of zones */
+    uint16_t vertexCount;                   /**< Number of used vertices */
+
+    uint16_t cellStart[CELLS + 1];          /**< First entry of every cell in cellZones */
+    uint16_t cellZones[ALORA_GEOFENCE_MAX_CELL_ENTRIES]; /**< Zone indices listed per cell */
+    int32_t gridLatitude;                   /**< South edge of the grid */
+    int32_t gridLongitude;                  /**< West edge of the grid */
+    uint32_t cellHeight;                    /**< Cell height in degrees * 10^7 */
+    uint32_t cellWidth;                     /**< Cell width in degrees * 10^7 */
+    bool indexed;                           /**< Whether build() succeeded after the last change */
+
+    uint8_t inside[(ALORA_GEOFENCE_MAX_ZONES + 7) / 8]; /**< Debounced inside state per zone */
+    uint8_t pending[ALORA_GEOFENCE_MAX_ZONES]; /**< Consecutive fixes disagreeing with the state */
+    uint16_t active[ALORA_GEOFENCE_MAX_ACTIVE]; /**< Zones that are inside or have a pending change */
+    uint8_t activeCount;                    /**< Number of active zones */
+    bool activeOverflow;                    /**< Whether active zones did not fit into active, the next update() scans all zones */
+    uint16_t visited[ALORA_GEOFENCE_MAX_ZONES]; /**< Fix number a zone was last evaluated at */
+    uint16_t fixCount;                      /**< Number of evaluated fixes, wraps around */
+    AloraGeofenceEvent events[ALORA_GEOFENCE_MAX_ACTIVE]; /**< Events of the last update() */
+    uint8_t eventCount;                     /**< Number of events of the last update() */
+
+    bool contains(const Zone& zone, int32_t latitude, int32_t longitude);
+    void evaluate(uint16_t zone, bool isInside, uint16_t* nextActive, uint8_t& nextCount);
+    int16_t findZone(uint16_t zoneId);
+};
+
+#endif
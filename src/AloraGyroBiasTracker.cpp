@@ -0,0 +1,93 @@
+/** @file */
+
+#include "AloraGyroBiasTracker.h"
+#include "AloraFastMath.h"
+
+AloraGyroBiasTracker::AloraGyroBiasTracker() {
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+
+    reset(zero);
+}
+
+/**
+ * @brief Restart the estimator from a known bias
+ *
+ * @param bias initial gyroscope bias in deg/s
+ */
+void AloraGyroBiasTracker::reset(const float bias[3]) {
+    for (uint8_t i = 0; i < 3; i++) {
+        this->bias[i] = bias[i];
+    }
+
+    accelMean = 0.0f;
+    accelVariance = 0.0f;
+    stillSamples = 0;
+    primed = false;
+}
+
+/**
+ * @brief Feed one sample
+ *
+ * @param gx gyroscope X axis in deg/s, without bias removal
+ * @param gy gyroscope Y axis in deg/s, without bias removal
+ * @param gz gyroscope Z axis in deg/s, without bias removal
+ * @param ax accelerometer X axis in g
+ * @param ay accelerometer Y axis in g
+ * @param az accelerometer Z axis in g
+ * @return true if the bias estimate was updated
+ */
+bool AloraGyroBiasTracker::update(float gx, float gy, float gz, float ax, float ay, float az) {
+    float magnitude = AloraFastMath::norm(ax, ay, az);
+
+    if (!primed) {
+        accelMean = magnitude;
+        primed = true;
+    }
+
+    float deviation = magnitude - accelMean;
+    accelMean += ALORA_GYRO_BIAS_VARIANCE_ALPHA * deviation;
+    accelVariance += ALORA_GYRO_BIAS_VARIANCE_ALPHA * (deviation * deviation - accelVariance);
+
+    float rx = gx - bias[0];
+    float ry = gy - bias[1];
+    float rz = gz - bias[2];
+
+    bool still = accelVariance < ALORA_GYRO_BIAS_STILL_ACCEL_VARIANCE
+        && rx * rx + ry * ry + rz * rz < ALORA_GYRO_BIAS_STILL_RATE * ALORA_GYRO_BIAS_STILL_RATE;
+
+    if (!still) {
+        stillSamples = 0;
+        return false;
+    }
+
+    if (stillSamples < ALORA_GYRO_BIAS_STILL_SAMPLES) {
+        stillSamples++;
+        return false;
+    }
+
+    bias[0] += ALORA_GYRO_BIAS_ALPHA * rx;
+    bias[1] += ALORA_GYRO_BIAS_ALPHA * ry;
+    bias[2] += ALORA_GYRO_BIAS_ALPHA * rz;
+
+    return true;
+}
+
+/**
+ * @brief Check whether the sensor is currently considered stationary
+ *
+ * @return true if enough stationary samples were seen in a row
+ */
+bool AloraGyroBiasTracker::isStill() {
+    return stillSamples >= ALORA_GYRO_BIAS_STILL_SAMPLES;
+}
+
+/**
+ * @brief Get the bias estimate
+ *
+ * @param bias gyroscope bias in deg/s will be stored here
+ */
+void AloraGyroBiasTracker::getBias(float bias[3]) {
+    for (uint8_t i = 0; i < 3; i++) {
+        bias[i] = this->bias[i];
+    }
+}
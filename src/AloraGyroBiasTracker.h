@@ -0,0 +1,60 @@
+/** @file */
+
+#ifndef ALORA_GYRO_BIAS_TRACKER_H
+#define ALORA_GYRO_BIAS_TRACKER_H
+
+#include <stdint.h>
+
+/** Largest gyroscope rate in deg/s, after bias removal, still considered stationary */
+#if !defined(ALORA_GYRO_BIAS_STILL_RATE)
+    #define ALORA_GYRO_BIAS_STILL_RATE 2.0f
+#endif
+
+/** Largest accelerometer magnitude variance in g^2 still considered stationary */
+#if !defined(ALORA_GYRO_BIAS_STILL_ACCEL_VARIANCE)
+    #define ALORA_GYRO_BIAS_STILL_ACCEL_VARIANCE 0.0001f
+#endif
+
+/** Consecutive stationary samples needed before the bias is updated */
+#if !defined(ALORA_GYRO_BIAS_STILL_SAMPLES)
+    #define ALORA_GYRO_BIAS_STILL_SAMPLES 64
+#endif
+
+/** Exponential filter factor of the bias estimate, per stationary sample */
+#if !defined(ALORA_GYRO_BIAS_ALPHA)
+    #define ALORA_GYRO_BIAS_ALPHA 0.002f
+#endif
+
+/** Exponential filter factor of the accelerometer magnitude mean and variance */
+#if !defined(ALORA_GYRO_BIAS_VARIANCE_ALPHA)
+    #define ALORA_GYRO_BIAS_VARIANCE_ALPHA 0.05f
+#endif
+
+/**
+ * @brief Background gyroscope bias estimator.
+ *
+ * Works on samples that are already read for the orientation filter, so it
+ * needs no bus transaction of its own. A sample is stationary when the
+ * variance of the accelerometer magnitude and the bias corrected gyroscope
+ * rate are both small. After ALORA_GYRO_BIAS_STILL_SAMPLES stationary samples
+ * in a row, every further stationary sample pulls the bias estimate towards
+ * the measured rate with an exponential filter.
+ */
+class AloraGyroBiasTracker {
+public:
+    AloraGyroBiasTracker();
+
+    void reset(const float bias[3]);
+    bool update(float gx, float gy, float gz, float ax, float ay, float az);
+    bool isStill();
+    void getBias(float bias[3]);
+
+private:
+    float bias[3];                          /**< Gyroscope bias estimate in deg/s */
+    float accelMean;                        /**< Filtered accelerometer magnitude in g */
+    float accelVariance;                    /**< Filtered accelerometer magnitude variance in g^2 */
+    uint16_t stillSamples;                  /**< Consecutive stationary samples */
+    bool primed;                            /**< Whether accelMean was seeded */
+};
+
+#endif
@@ -0,0 +1,82 @@
+/** @file */
+
+#include "AloraIMUBatch.h"
+
+#if ALORA_IMU_BATCH_USE_ESP_DSP
+#include <dsps_mulc.h>
+#endif
+
+/** Ask GCC to vectorize the kernels even when the sketch is built with -Os */
+#if defined(__GNUC__) && !defined(__clang__)
+    #define ALORA_IMU_BATCH_VECTORIZE __attribute__((optimize("tree-vectorize")))
+#else
+    #define ALORA_IMU_BATCH_VECTORIZE
+#endif
+
+/**
+ * @brief Convert interleaved raw triples to physical units
+ *
+ * @param raw interleaved raw triples, 3 * count values
+ * @param count number of triples
+ * @param bias raw bias of each axis subtracted before scaling, NULL for none
+ * @param scale physical unit per LSB, for example LSM9DS1 aRes, gRes or mRes
+ * @param x X axis output buffer, count values
+ * @param y Y axis output buffer, count values
+ * @param z Z axis output buffer, count values
+ */
+ALORA_IMU_BATCH_VECTORIZE
+void AloraIMUBatch::convert(const int16_t* __restrict raw, uint16_t count, const int16_t* bias, float scale, float* __restrict x, float* __restrict y, float* __restrict z) {
+    const int32_t biasX = bias != NULL ? bias[0] : 0;
+    const int32_t biasY = bias != NULL ? bias[1] : 0;
+    const int32_t biasZ = bias != NULL ? bias[2] : 0;
+
+#if ALORA_IMU_BATCH_USE_ESP_DSP
+    for (uint16_t i = 0; i < count; i++) {
+        x[i] = (float)(raw[3 * i] - biasX);
+        y[i] = (float)(raw[3 * i + 1] - biasY);
+        z[i] = (float)(raw[3 * i + 2] - biasZ);
+    }
+
+    dsps_mulc_f32(x, x, count, scale, 1, 1);
+    dsps_mulc_f32(y, y, count, scale, 1, 1);
+    dsps_mulc_f32(z, z, count, scale, 1, 1);
+#else
+    for (uint16_t i = 0; i < count; i++) {
+        x[i] = (float)(raw[3 * i] - biasX) * scale;
+        y[i] = (float)(raw[3 * i + 1] - biasY) * scale;
+        z[i] = (float)(raw[3 * i + 2] - biasZ) * scale;
+    }
+#endif
+}
+
+/**
+ * @brief Split interleaved raw triples into per-axis buffers, keeping raw LSB
+ * units. This is the fixed-point path, the result saturates to int16_t.
+ *
+ * @param raw interleaved raw triples, 3 * count values
+ * @param count number of triples
+ * @param bias raw bias of each axis, NULL for none
+ * @param x X axis output buffer, count values
+ * @param y Y axis output buffer, count values
+ * @param z Z axis output buffer, count values
+ */
+ALORA_IMU_BATCH_VECTORIZE
+void AloraIMUBatch::deinterleave(const int16_t* __restrict raw, uint16_t count, const int16_t* bias, int16_t* __restrict x, int16_t* __restrict y, int16_t* __restrict z) {
+    const int32_t biasX = bias != NULL ? bias[0] : 0;
+    const int32_t biasY = bias != NULL ? bias[1] : 0;
+    const int32_t biasZ = bias != NULL ? bias[2] : 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t valueX = raw[3 * i] - biasX;
+        int32_t valueY = raw[3 * i + 1] - biasY;
+        int32_t valueZ = raw[3 * i + 2] - biasZ;
+
+        valueX = valueX > 32767 ? 32767 : (valueX < -32768 ? -32768 : valueX);
+        valueY = valueY > 32767 ? 32767 : (valueY < -32768 ? -32768 : valueY);
+        valueZ = valueZ > 32767 ? 32767 : (valueZ < -32768 ? -32768 : valueZ);
+
+        x[i] = (int16_t)valueX;
+        y[i] = (int16_t)valueY;
+        z[i] = (int16_t)valueZ;
+    }
+}
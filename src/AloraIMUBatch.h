@@ -0,0 +1,40 @@
+/** @file */
+
+#ifndef ALORA_IMU_BATCH_H
+#define ALORA_IMU_BATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Use ESP-DSP SIMD kernels (PIE on ESP32-S3) for the scaling pass when the component is available */
+#if !defined(ALORA_IMU_BATCH_USE_ESP_DSP)
+    #if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(__has_include)
+        #if __has_include(<dsps_mulc.h>)
+            #define ALORA_IMU_BATCH_USE_ESP_DSP 1
+        #endif
+    #endif
+#endif
+
+#if !defined(ALORA_IMU_BATCH_USE_ESP_DSP)
+    #define ALORA_IMU_BATCH_USE_ESP_DSP 0
+#endif
+
+/**
+ * @brief Block conversion kernels for raw IMU samples.
+ *
+ * Input is an array of interleaved raw triples (x0, y0, z0, x1, y1, z1, ...),
+ * the layout of a LSM9DS1 FIFO or register burst. Output is one buffer per
+ * axis (structure of arrays) with bias subtraction fused into the same pass.
+ * convert() also scales to physical units, LSM9DS1::calcGyroBatch() and its
+ * siblings use it for FIFO batches and logs. deinterleave() keeps raw LSB
+ * units, the vibration analyzer splits every FIFO drain into its FFT block
+ * this way. The loops have no dependency between samples, so the compiler vectorizes
+ * them on host targets with strided load support (for example -mavx2).
+ */
+class AloraIMUBatch {
+public:
+    static void convert(const int16_t* raw, uint16_t count, const int16_t* bias, float scale, float* x, float* y, float* z);
+    static void deinterleave(const int16_t* raw, uint16_t count, const int16_t* bias, int16_t* x, int16_t* y, int16_t* z);
+};
+
+#endif
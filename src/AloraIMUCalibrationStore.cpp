@@ -0,0 +1,138 @@
+/** @file */
+
+#include "AloraIMUCalibrationStore.h"
+
+#if defined(ESP32)
+    #include <Preferences.h>
+    #include <esp_attr.h>
+#else
+    #include <stdio.h>
+#endif
+
+#if !defined(RTC_DATA_ATTR)
+    #define RTC_DATA_ATTR
+#endif
+
+/** Copy of the last loaded or saved blob, kept in RTC memory over deep sleep */
+RTC_DATA_ATTR static AloraIMUCalibration retained;
+
+/**
+ * @brief Load calibration saved for the given sensor
+ *
+ * @param sensorId sensor identification the blob must match
+ * @param calibration loaded calibration, left unchanged on failure
+ * @return true if a valid blob for this sensor was found
+ */
+bool AloraIMUCalibrationStore::load(uint16_t sensorId, AloraIMUCalibration& calibration) {
+    // wake-up from deep sleep, skip the flash read
+    if (retained.magic == ALORA_IMU_CALIBRATION_MAGIC && retained.sensorId == sensorId) {
+        calibration = retained;
+        return true;
+    }
+
+    AloraIMUCalibration stored;
+    size_t length = 0;
+
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_IMU_CALIBRATION_NAMESPACE, true)) {
+        return false;
+    }
+
+    if (preferences.getBytesLength(ALORA_IMU_CALIBRATION_KEY) == sizeof(stored)) {
+        length = preferences.getBytes(ALORA_IMU_CALIBRATION_KEY, &stored, sizeof(stored));
+    }
+
+    preferences.end();
+#else
+    FILE* file = fopen(ALORA_IMU_CALIBRATION_FILE, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    length = fread(&stored, 1, sizeof(stored), file);
+    fclose(file);
+#endif
+
+    if (length != sizeof(stored)
+        || stored.magic != ALORA_IMU_CALIBRATION_MAGIC
+        || stored.version != ALORA_IMU_CALIBRATION_VERSION
+        || stored.sensorId != sensorId) {
+        return false;
+    }
+
+    calibration = stored;
+    retained = stored;
+
+    return true;
+}
+
+/**
+ * @brief Save calibration. Magic number and version are filled in.
+ *
+ * @param calibration calibration to save
+ * @return true on success
+ */
+bool AloraIMUCalibrationStore::save(AloraIMUCalibration& calibration) {
+    calibration.magic = ALORA_IMU_CALIBRATION_MAGIC;
+    calibration.version = ALORA_IMU_CALIBRATION_VERSION;
+    retained.magic = 0;
+
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_IMU_CALIBRATION_NAMESPACE, false)) {
+        return false;
+    }
+
+    size_t length = preferences.putBytes(ALORA_IMU_CALIBRATION_KEY, &calibration, sizeof(calibration));
+    preferences.end();
+
+    if (length == sizeof(calibration)) {
+        retained = calibration;
+    }
+
+    return length == sizeof(calibration);
+#else
+    FILE* file = fopen(ALORA_IMU_CALIBRATION_FILE, "wb");
+    if (file == NULL) {
+        return false;
+    }
+
+    size_t length = fwrite(&calibration, 1, sizeof(calibration), file);
+    if (fclose(file) != 0 || length != sizeof(calibration)) {
+        return false;
+    }
+
+    retained = calibration;
+
+    return true;
+#endif
+}
+
+/**
+ * @brief Remove saved calibration
+ *
+ * @return true if nothing is saved anymore
+ */
+bool AloraIMUCalibrationStore::clear() {
+    retained.magic = 0;
+
+#if defined(ESP32)
+    Preferences preferences;
+    if (!preferences.begin(ALORA_IMU_CALIBRATION_NAMESPACE, false)) {
+        return false;
+    }
+
+    if (preferences.isKey(ALORA_IMU_CALIBRATION_KEY)) {
+        preferences.remove(ALORA_IMU_CALIBRATION_KEY);
+    }
+
+    preferences.end();
+
+    return true;
+#else
+    remove(ALORA_IMU_CALIBRATION_FILE);
+
+    return true;
+#endif
+}
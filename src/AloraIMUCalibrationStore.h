@@ -0,0 +1,72 @@
+/** @file */
+
+#ifndef ALORA_IMU_CALIBRATION_STORE_H
+#define ALORA_IMU_CALIBRATION_STORE_H
+
+#include <stdint.h>
+
+/** NVS namespace of the IMU calibration blob (ESP32) */
+#if !defined(ALORA_IMU_CALIBRATION_NAMESPACE)
+    #define ALORA_IMU_CALIBRATION_NAMESPACE "alora"
+#endif
+
+/** NVS key of the IMU calibration blob (ESP32) */
+#if !defined(ALORA_IMU_CALIBRATION_KEY)
+    #define ALORA_IMU_CALIBRATION_KEY "imucal"
+#endif
+
+/** File of the IMU calibration blob on targets without NVS */
+#if !defined(ALORA_IMU_CALIBRATION_FILE)
+    #define ALORA_IMU_CALIBRATION_FILE "alora_imu_calibration.bin"
+#endif
+
+/** Blob magic number, "ALIC" */
+#define ALORA_IMU_CALIBRATION_MAGIC 0x43494C41UL
+
+/** Blob layout version. Blobs with another version are ignored */
+#define ALORA_IMU_CALIBRATION_VERSION 3
+
+/** Accelerometer and gyroscope biases are valid */
+#define ALORA_IMU_CALIBRATION_ACCEL_GYRO 0x01
+
+/** Magnetometer bias is valid */
+#define ALORA_IMU_CALIBRATION_MAG 0x02
+
+/** Magnetometer ellipsoid fit (hard-iron offset and soft-iron matrix) is valid */
+#define ALORA_IMU_CALIBRATION_SOFT_IRON 0x04
+
+/** Accelerometer and gyroscope bias-versus-temperature model is valid */
+#define ALORA_IMU_CALIBRATION_TEMPERATURE 0x08
+
+/**
+ * @brief IMU calibration result. Biases are stored in physical units so they
+ * stay valid when the sensor full scale range changes.
+ */
+struct AloraIMUCalibration {
+    uint32_t magic;                         /**< ALORA_IMU_CALIBRATION_MAGIC */
+    uint16_t version;                       /**< ALORA_IMU_CALIBRATION_VERSION */
+    uint16_t sensorId;                      /**< Sensor identification, LSM9DS1 combined WHO_AM_I */
+    uint8_t flags;                          /**< Valid parts, ALORA_IMU_CALIBRATION_* bits */
+    float gyroBias[3];                      /**< Gyroscope bias in deg/s */
+    float accelBias[3];                     /**< Accelerometer bias in g */
+    float magBias[3];                       /**< Magnetometer bias in gauss */
+    float softIron[9];                      /**< Magnetometer soft-iron matrix, row major */
+    float hardIron[3];                      /**< Magnetometer hard-iron offset in gauss */
+    float temperatureReference;             /**< Die temperature in degrees Celsius gyroBias and accelBias belong to */
+    float gyroTempSlope[3];                 /**< Gyroscope bias slope in deg/s per degree */
+    float accelTempSlope[3];                /**< Accelerometer bias slope in g per degree */
+};
+
+/**
+ * @brief Persistent storage of the IMU calibration. Uses NVS through
+ * Preferences on ESP32 and a file on other targets. The last blob is also
+ * kept in RTC memory, so wake-ups from deep sleep do not read the flash.
+ */
+class AloraIMUCalibrationStore {
+public:
+    static bool load(uint16_t sensorId, AloraIMUCalibration& calibration);
+    static bool save(AloraIMUCalibration& calibration);
+    static bool clear();
+};
+
+#endif
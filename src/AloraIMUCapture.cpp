@@ -0,0 +1,302 @@
+/** @file */
+
+#include "AloraIMUCapture.h"
+
+#if defined(ESP32)
+    #define ALORA_IMU_CAPTURE_ISR_ATTR IRAM_ATTR
+#else
+    #define ALORA_IMU_CAPTURE_ISR_ATTR
+#endif
+
+volatile bool AloraIMUCapture::interruptFlag = false;
+
+AloraIMUCapture::AloraIMUCapture():
+ imuSensor(NULL),
+ head(0),
+ stored(0),
+ triggerPosition(0),
+ triggerTimestamp(0),
+ preCount(0),
+ postCount(0),
+ state(IDLE),
+ triggerRequested(false),
+ threshold(ALORA_IMU_CAPTURE_THRESHOLD_G) {
+}
+
+/**
+ * @brief Set the sensor to capture from
+ *
+ * @param imuSensor initialized LSM9DS1 object
+ */
+void AloraIMUCapture::begin(LSM9DS1* imuSensor) {
+    this->imuSensor = imuSensor;
+}
+
+/**
+ * @brief Start streaming into the pre-trigger ring. A previous event window
+ * is discarded. The accelerometer/gyroscope data rate is not changed, set it
+ * to ALORA_IMU_CAPTURE_RATE_HZ first to get the configured window lengths.
+ *
+ * @return true if streaming started
+ */
+bool AloraIMUCapture::arm() {
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    head = 0;
+    stored = 0;
+    preCount = 0;
+    postCount = 0;
+    triggerRequested = false;
+    interruptFlag = false;
+
+    imuSensor->enableFIFO(true);
+    imuSensor->setFIFO(FIFO_CONT, 0x1F);
+
+#if ALORA_IMU_INT1_PIN >= 0
+    // threshold register compares with the upper byte of the output, 1 LSB = full scale / 128
+    float code = ALORA_IMU_CAPTURE_HW_THRESHOLD_G * 128.0f / imuSensor->settings.accel.scale;
+    uint8_t ths = code >= 255.0f ? 255 : (uint8_t) code;
+
+    imuSensor->configAccelThs(ths, X_AXIS);
+    imuSensor->configAccelThs(ths, Y_AXIS);
+    imuSensor->configAccelThs(ths, Z_AXIS);
+    imuSensor->configAccelInt(XHIE_XL | YHIE_XL | ZHIE_XL);
+    imuSensor->configInt(XG_INT1, INT_IG_XL, INT_ACTIVE_HIGH, INT_PUSH_PULL);
+
+    pinMode(ALORA_IMU_INT1_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(ALORA_IMU_INT1_PIN), onInterrupt, RISING);
+#endif
+
+    state = ARMED;
+
+    return true;
+}
+
+/**
+ * @brief Fire the trigger at the next sample
+ */
+void AloraIMUCapture::trigger() {
+    if (state == ARMED) {
+        triggerRequested = true;
+    }
+}
+
+/**
+ * @brief Drain the FIFO into the ring buffer and check the trigger
+ *
+ * @return uint8_t number of new samples
+ */
+uint8_t AloraIMUCapture::update() {
+    if (state != ARMED && state != TRIGGERED) {
+        return 0;
+    }
+
+    if (interruptFlag) {
+        interruptFlag = false;
+        triggerRequested = state == ARMED;
+
+        // reading the source register clears the latched interrupt
+        imuSensor->getAccelIntSrc();
+    }
+
+    int16_t gyroRaw[3 * 32];
+    int16_t accelRaw[3 * 32];
+    uint8_t samples = imuSensor->readFIFO(gyroRaw, accelRaw, 32);
+    uint32_t now = micros();
+    uint8_t range = currentRange();
+
+    for (uint8_t i = 0; i < samples; i++) {
+        AloraIMUSample& sample = ring[head];
+
+        for (uint8_t axis = 0; axis < 3; axis++) {
+            sample.gyro[axis] = gyroRaw[3 * i + axis];
+            sample.accel[axis] = accelRaw[3 * i + axis];
+        }
+
+        sample.range = range;
+
+        if (state == ARMED && (triggerRequested || exceedsThreshold(sample))) {
+            state = TRIGGERED;
+            triggerRequested = false;
+            triggerPosition = head;
+            triggerTimestamp = now - (uint32_t) (samples - 1 - i) * 1000000UL / ALORA_IMU_CAPTURE_RATE_HZ;
+            preCount = stored < ALORA_IMU_CAPTURE_PRE_SAMPLES ? stored : ALORA_IMU_CAPTURE_PRE_SAMPLES;
+            postCount = 0;
+        }
+
+        head = (head + 1) % RING_SIZE;
+        if (stored < RING_SIZE) {
+            stored++;
+        }
+
+        if (state == TRIGGERED && ++postCount >= ALORA_IMU_CAPTURE_POST_SAMPLES) {
+            state = FROZEN;
+            stopStreaming();
+
+            return i + 1;
+        }
+    }
+
+    return samples;
+}
+
+/**
+ * @brief Stop streaming and discard the event window
+ */
+void AloraIMUCapture::release() {
+    if (state == ARMED || state == TRIGGERED) {
+        stopStreaming();
+    }
+
+    state = IDLE;
+    preCount = 0;
+    postCount = 0;
+}
+
+/**
+ * @brief Check whether the FIFO is streaming into the ring buffer
+ *
+ * @return true if armed or recording after the trigger
+ */
+bool AloraIMUCapture::isArmed() {
+    return state == ARMED || state == TRIGGERED;
+}
+
+/**
+ * @brief Check whether an event window is complete and ready for export
+ *
+ * @return true if the event window is frozen
+ */
+bool AloraIMUCapture::isFrozen() {
+    return state == FROZEN;
+}
+
+/**
+ * @brief Set software trigger threshold
+ *
+ * @param g deviation of the acceleration magnitude from 1 g, 0 disables the software trigger
+ */
+void AloraIMUCapture::setThreshold(float g) {
+    threshold = g;
+}
+
+/**
+ * @brief Get number of samples in the frozen event window
+ *
+ * @return uint16_t number of samples, 0 if no window is frozen
+ */
+uint16_t AloraIMUCapture::getEventLength() {
+    return state == FROZEN ? preCount + postCount : 0;
+}
+
+/**
+ * @brief Get position of the trigger sample in the event window, which is
+ * also the number of samples before the trigger
+ *
+ * @return uint16_t index of the trigger sample
+ */
+uint16_t AloraIMUCapture::getTriggerIndex() {
+    return preCount;
+}
+
+/**
+ * @brief Get the time of the trigger sample. Sample i of the event window
+ * is (i - getTriggerIndex()) sample periods from it.
+ *
+ * @return uint32_t micros() of the trigger sample
+ */
+uint32_t AloraIMUCapture::getTriggerTimestamp() {
+    return triggerTimestamp;
+}
+
+/**
+ * @brief Get a sample of the frozen event window, oldest first
+ *
+ * @param index sample index, 0 to getEventLength() - 1
+ * @param sample sample will be stored here
+ * @return true if the index is valid
+ */
+bool AloraIMUCapture::getEventSample(uint16_t index, AloraIMUSample& sample) {
+    if (index >= getEventLength()) {
+        return false;
+    }
+
+    sample = ring[(triggerPosition + RING_SIZE - preCount + index) % RING_SIZE];
+
+    return true;
+}
+
+/**
+ * @brief Get the most recent sample written to the ring buffer
+ *
+ * @return const AloraIMUSample& latest sample
+ */
+const AloraIMUSample& AloraIMUCapture::getLatestSample() {
+    return ring[(head + RING_SIZE - 1) % RING_SIZE];
+}
+
+/**
+ * @brief Decode the accelerometer full scale of a sample
+ *
+ * @param range AloraIMUSample::range tag
+ * @return uint8_t full scale in g
+ */
+uint8_t AloraIMUCapture::getAccelRange(uint8_t range) {
+    return 2 << (range & 0x03);
+}
+
+/**
+ * @brief Decode the gyroscope full scale of a sample
+ *
+ * @param range AloraIMUSample::range tag
+ * @return uint16_t full scale in degrees per second
+ */
+uint16_t AloraIMUCapture::getGyroRange(uint8_t range) {
+    static const uint16_t gyroScales[] = { 245, 500, 2000, 2000 };
+
+    return gyroScales[(range >> 2) & 0x03];
+}
+
+void ALORA_IMU_CAPTURE_ISR_ATTR AloraIMUCapture::onInterrupt() {
+    interruptFlag = true;
+}
+
+uint8_t AloraIMUCapture::currentRange() {
+    uint8_t accelIndex = 0;
+    while (accelIndex < 3 && (2 << accelIndex) < imuSensor->settings.accel.scale) {
+        accelIndex++;
+    }
+
+    uint8_t gyroIndex = imuSensor->settings.gyro.scale >= 2000 ? 2 : (imuSensor->settings.gyro.scale >= 500 ? 1 : 0);
+
+    return accelIndex | (gyroIndex << 2);
+}
+
+bool AloraIMUCapture::exceedsThreshold(const AloraIMUSample& sample) {
+    if (threshold <= 0.0f) {
+        return false;
+    }
+
+    float resolution = getAccelRange(sample.range) / 32768.0f;
+    float x = sample.accel[0] * resolution;
+    float y = sample.accel[1] * resolution;
+    float z = sample.accel[2] * resolution;
+    float squared = x * x + y * y + z * z;
+    float high = 1.0f + threshold;
+    float low = threshold < 1.0f ? 1.0f - threshold : 0.0f;
+
+    return squared > high * high || squared < low * low;
+}
+
+void AloraIMUCapture::stopStreaming() {
+#if ALORA_IMU_INT1_PIN >= 0
+    detachInterrupt(digitalPinToInterrupt(ALORA_IMU_INT1_PIN));
+    imuSensor->configInt(XG_INT1, 0, INT_ACTIVE_HIGH, INT_PUSH_PULL);
+    imuSensor->configAccelInt(0);
+#endif
+
+    imuSensor->setFIFO(FIFO_OFF, 0x00);
+    imuSensor->enableFIFO(false);
+}
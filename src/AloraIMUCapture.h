@@ -0,0 +1,124 @@
+/** @file */
+
+#ifndef ALORA_IMU_CAPTURE_H
+#define ALORA_IMU_CAPTURE_H
+
+#include <Arduino.h>
+#include "SparkFunLSM9DS1.h"
+
+/** Accelerometer/gyroscope data rate in Hz while a capture is armed */
+#if !defined(ALORA_IMU_CAPTURE_RATE_HZ)
+    #define ALORA_IMU_CAPTURE_RATE_HZ 952
+#endif
+
+/** Length of the event window before the trigger in milliseconds */
+#if !defined(ALORA_IMU_CAPTURE_PRE_MS)
+    #define ALORA_IMU_CAPTURE_PRE_MS 500
+#endif
+
+/** Length of the event window after the trigger in milliseconds */
+#if !defined(ALORA_IMU_CAPTURE_POST_MS)
+    #define ALORA_IMU_CAPTURE_POST_MS 2000
+#endif
+
+/** Number of samples kept before the trigger */
+#define ALORA_IMU_CAPTURE_PRE_SAMPLES ((uint16_t) ((uint32_t) ALORA_IMU_CAPTURE_PRE_MS * ALORA_IMU_CAPTURE_RATE_HZ / 1000))
+
+/** Number of samples recorded after the trigger, the trigger sample included */
+#define ALORA_IMU_CAPTURE_POST_SAMPLES ((uint16_t) ((uint32_t) ALORA_IMU_CAPTURE_POST_MS * ALORA_IMU_CAPTURE_RATE_HZ / 1000))
+
+/** Deviation of the acceleration magnitude from 1 g that fires the software trigger */
+#if !defined(ALORA_IMU_CAPTURE_THRESHOLD_G)
+    #define ALORA_IMU_CAPTURE_THRESHOLD_G 0.5f
+#endif
+
+/** Pin connected to LSM9DS1 INT1_A/G. When set, the accelerometer threshold interrupt fires the trigger */
+#if !defined(ALORA_IMU_INT1_PIN)
+    #define ALORA_IMU_INT1_PIN -1
+#endif
+
+/** Absolute acceleration on any axis in g that raises the hardware threshold interrupt */
+#if !defined(ALORA_IMU_CAPTURE_HW_THRESHOLD_G)
+    #define ALORA_IMU_CAPTURE_HW_THRESHOLD_G 1.5f
+#endif
+
+/**
+ * @brief One raw accelerometer/gyroscope sample of a capture
+ */
+struct AloraIMUSample {
+    int16_t gyro[3];                        /**< Raw gyroscope X, Y, Z without bias removal */
+    int16_t accel[3];                       /**< Raw accelerometer X, Y, Z without bias removal */
+    uint8_t range;                          /**< Full scale tag, see AloraIMUCapture::getAccelRange() and getGyroRange() */
+};
+
+/**
+ * @brief Triggered high-rate IMU capture with pre-trigger history.
+ *
+ * While armed, the LSM9DS1 FIFO runs in continuous mode and update() drains
+ * it into a ring buffer, so the latest ALORA_IMU_CAPTURE_PRE_SAMPLES samples
+ * are always available. A trigger (software threshold on the acceleration
+ * magnitude, the hardware threshold interrupt on ALORA_IMU_INT1_PIN or a
+ * call to trigger()) starts recording ALORA_IMU_CAPTURE_POST_SAMPLES more
+ * samples, then the event window is frozen until release().
+ *
+ * The ring buffer is a fixed member array, sized at compile time. The FIFO
+ * holds 32 samples, so update() must run at least every 32 sample periods
+ * (33 ms at 952 Hz) or samples are lost.
+ */
+class AloraIMUCapture {
+public:
+    AloraIMUCapture();
+
+    void begin(LSM9DS1* imuSensor);
+    bool arm();
+    void trigger();
+    uint8_t update();
+    void release();
+
+    bool isArmed();
+    bool isFrozen();
+    void setThreshold(float g);
+
+    uint16_t getEventLength();
+    uint16_t getTriggerIndex();
+    uint32_t getTriggerTimestamp();
+    bool getEventSample(uint16_t index, AloraIMUSample& sample);
+    const AloraIMUSample& getLatestSample();
+
+    static uint8_t getAccelRange(uint8_t range);
+    static uint16_t getGyroRange(uint8_t range);
+
+private:
+    /**
+     * @brief Capture state
+     */
+    enum State {
+        IDLE,                               /**< FIFO is not used */
+        ARMED,                              /**< Streaming into the pre-trigger ring */
+        TRIGGERED,                          /**< Streaming the samples after the trigger */
+        FROZEN                              /**< Event window complete, streaming stopped */
+    };
+
+    static const uint16_t RING_SIZE = ALORA_IMU_CAPTURE_PRE_SAMPLES + ALORA_IMU_CAPTURE_POST_SAMPLES;
+
+    LSM9DS1* imuSensor;                     /**< LSM9DS1 object pointer */
+    AloraIMUSample ring[RING_SIZE];         /**< Sample ring buffer */
+    uint16_t head;                          /**< Ring index of the next sample */
+    uint16_t stored;                        /**< Number of valid samples in the ring */
+    uint16_t triggerPosition;               /**< Ring index of the trigger sample */
+    uint32_t triggerTimestamp;              /**< micros() of the trigger sample */
+    uint16_t preCount;                      /**< Number of samples before the trigger in the event window */
+    uint16_t postCount;                     /**< Number of samples recorded since the trigger */
+    State state;                            /**< Capture state */
+    bool triggerRequested;                  /**< Trigger at the next sample */
+    float threshold;                        /**< Software trigger threshold in g */
+
+    static volatile bool interruptFlag;     /**< Set by the INT1 interrupt handler */
+    static void onInterrupt();
+
+    uint8_t currentRange();
+    bool exceedsThreshold(const AloraIMUSample& sample);
+    void stopStreaming();
+};
+
+#endif
@@ -1,6 +1,82 @@
 #include "AloraIMULSM9DS1Adapter.h"
 
-AloraIMULSM9DS1Adapter::AloraIMULSM9DS1Adapter() {
+#if defined(ESP32)
+    #include <esp_attr.h>
+    #define ALORA_IMU_ADAPTER_ISR_ATTR IRAM_ATTR
+#else
+    #define ALORA_IMU_ADAPTER_ISR_ATTR
+#endif
+
+#if !defined(RTC_DATA_ATTR)
+    #define RTC_DATA_ATTR
+#endif
+
+/** Retained state magic number, "AIRS" */
+#define ALORA_IMU_RESUME_MAGIC 0x53524941UL
+
+/**
+ * Sensor configuration kept in RTC memory while LSM9DS1 stays powered over deep sleep
+ */
+struct AloraIMUResumeState {
+    uint32_t magic;                 /**< ALORA_IMU_RESUME_MAGIC after retain() */
+    uint16_t sensorId;              /**< Combined WHO_AM_I of the retained sensor */
+    IMUSettings settings;           /**< LSM9DS1 settings the registers were written with */
+    uint8_t enabledSensors;         /**< Powered sensors */
+    float outputRate;               /**< Output rate after decimation */
+    float requestedRate;            /**< Target rate of the last setOutputRate() */
+    bool motionGating;              /**< Whether the inactivity detection is configured */
+    bool motionIdle;                /**< Whether the wake interrupt is armed at the idle rate */
+    float motionRestoreRate;        /**< Target rate restored on wake */
+    uint8_t motionRestoreSensors;   /**< Sensors restored on wake */
+};
+
+RTC_DATA_ATTR static AloraIMUResumeState retained;
+
+volatile bool AloraIMULSM9DS1Adapter::motionFlag = false;
+
+AloraIMULSM9DS1Adapter::AloraIMULSM9DS1Adapter():
+ imuSensor(NULL),
+ lastUpdateMicros(0),
+ enabledSensors(ALORA_IMU_ACCEL | ALORA_IMU_GYRO | ALORA_IMU_MAG),
+ outputRate(0.0f),
+ requestedRate(ALORA_IMU_OUTPUT_RATE_HZ),
+ capture(NULL),
+ captureRestoreRate(ALORA_IMU_OUTPUT_RATE_HZ),
+ captureRestoreSensors(ALORA_IMU_SENSORS),
+ vibration(NULL),
+ vibrationRestoreRate(ALORA_IMU_OUTPUT_RATE_HZ),
+ vibrationRestoreSensors(ALORA_IMU_SENSORS),
+ decimating(false),
+ decimationRestoreRate(ALORA_IMU_OUTPUT_RATE_HZ),
+ decimationRestoreSensors(ALORA_IMU_SENSORS),
+ motionGating(false),
+ motionIdle(false),
+ motionRestoreRate(ALORA_IMU_OUTPUT_RATE_HZ),
+ motionRestoreSensors(ALORA_IMU_SENSORS),
+ lastMotionPollMillis(0),
+ autoRange(ALORA_IMU_AUTO_RANGE),
+ accelQuietSamples(0),
+ gyroQuietSamples(0),
+ rangeChangeCount(0),
+ sensorId(0),
+ calibrationFlags(0),
+ calibrationRunning(false),
+ magCalibrating(false),
+ magNextSolve(0),
+ gyroBiasTracking(ALORA_IMU_GYRO_BIAS_TRACKING),
+ tempCompensating(ALORA_IMU_TEMP_COMPENSATION),
+ temperature(25.0f),
+ lastTempMillis(0),
+ lastTempSaveMillis(0) {
+    for (uint8_t i = 0; i < 3; i++) {
+        magBody[i] = 0.0;
+        accelBody[i] = 0.0;
+        gyroBody[i] = 0.0;
+        gyroBase[i] = 0.0;
+        accelBase[i] = 0.0;
+        gyroApplied[i] = 0.0;
+        accelApplied[i] = 0.0;
+    }
 }
 
 AloraIMULSM9DS1Adapter::~AloraIMULSM9DS1Adapter() {
@@ -8,94 +84,1510 @@ AloraIMULSM9DS1Adapter::~AloraIMULSM9DS1Adapter() {
 }
 
 bool AloraIMULSM9DS1Adapter::begin(uint8_t accAddress, uint8_t magAddress) {
+    // the reset makes a retained configuration stale
+    retained.magic = 0;
+
     imuSensor = new LSM9DS1();
     imuSensor->settings.device.commInterface = IMU_MODE_I2C;
     imuSensor->settings.device.mAddress = magAddress;
     imuSensor->settings.device.agAddress = accAddress;
 
-    return imuSensor->begin();
-}
+    sensorId = imuSensor->begin();
+    if (sensorId == 0) {
+        return false;
+    }
 
-float AloraIMULSM9DS1Adapter::readAccelX() {
-    imuSensor->readAccel();
+    setOutputRate(ALORA_IMU_OUTPUT_RATE_HZ, ALORA_IMU_SENSORS);
+
+    if (capture != NULL) {
+        capture->begin(imuSensor);
+    }
 
-    return imuSensor->calcAccel(imuSensor->ax);
+    if (vibration != NULL) {
+        vibration->begin(imuSensor);
+    }
+
+    imuSensor->readTemp();
+    temperature = imuSensor->calcTemp(imuSensor->temperature);
+    lastTempMillis = millis();
+
+    loadCalibration();
+
+    return true;
 }
 
-float AloraIMULSM9DS1Adapter::readAccelY() {
-    imuSensor->readAccel();
+/**
+ * @brief Keep the sensor configuration in RTC memory before a deep sleep
+ * that leaves LSM9DS1 powered. A running capture, vibration analysis or
+ * decimation is stopped first, so the FIFO is off while sleeping. Nothing is
+ * kept during a calibration, begin() runs after wake-up then.
+ */
+void AloraIMULSM9DS1Adapter::retain() {
+    retained.magic = 0;
 
-    return imuSensor->calcAccel(imuSensor->ay);
+    if (imuSensor == NULL || calibrationRunning) {
+        return;
+    }
+
+    stopCapture();
+    stopVibration();
+    stopDecimation();
+
+    retained.sensorId = sensorId;
+    retained.settings = imuSensor->settings;
+    retained.enabledSensors = enabledSensors;
+    retained.outputRate = outputRate;
+    retained.requestedRate = requestedRate;
+    retained.motionGating = motionGating;
+    retained.motionIdle = motionIdle;
+    retained.motionRestoreRate = motionRestoreRate;
+    retained.motionRestoreSensors = motionRestoreSensors;
+    retained.magic = ALORA_IMU_RESUME_MAGIC;
 }
 
-float AloraIMULSM9DS1Adapter::readAccelZ() {
-    imuSensor->readAccel();
+/**
+ * @brief Take over a LSM9DS1 that stayed powered over deep sleep with the
+ * configuration kept by retain(). Only WHO_AM_I and the temperature are
+ * read, scales, data rates and interrupt configuration stay in the sensor.
+ *
+ * @param accAddress I2C address of accelerometer
+ * @param magAddress I2C address of magnetometer
+ * @return true if the sensor was taken over, false if begin() is needed
+ */
+bool AloraIMULSM9DS1Adapter::resume(uint8_t accAddress, uint8_t magAddress) {
+    if (retained.magic != ALORA_IMU_RESUME_MAGIC) {
+        return false;
+    }
+
+    // a reset while resuming falls back to begin()
+    retained.magic = 0;
+
+    imuSensor = new LSM9DS1();
+    imuSensor->settings = retained.settings;
+    imuSensor->settings.device.commInterface = IMU_MODE_I2C;
+    imuSensor->settings.device.mAddress = magAddress;
+    imuSensor->settings.device.agAddress = accAddress;
+
+    sensorId = imuSensor->attach();
+    if (sensorId == 0 || sensorId != retained.sensorId) {
+        delete imuSensor;
+        imuSensor = NULL;
+        sensorId = 0;
+
+        return false;
+    }
+
+    enabledSensors = retained.enabledSensors;
+    outputRate = retained.outputRate;
+    requestedRate = retained.requestedRate;
+    motionGating = retained.motionGating;
+    motionIdle = retained.motionIdle;
+    motionRestoreRate = retained.motionRestoreRate;
+    motionRestoreSensors = retained.motionRestoreSensors;
+    lastMotionPollMillis = millis();
+
+#if ALORA_IMU_INT1_PIN >= 0
+    if (motionIdle) {
+        // motion while sleeping latched the interrupt, its edge is gone
+        motionFlag = imuSensor->getAccelIntSrc() != 0;
+        pinMode(ALORA_IMU_INT1_PIN, INPUT);
+        attachInterrupt(digitalPinToInterrupt(ALORA_IMU_INT1_PIN), onMotionInterrupt, RISING);
+    }
+#endif
+
+    if (capture != NULL) {
+        capture->begin(imuSensor);
+    }
+
+    if (vibration != NULL) {
+        vibration->begin(imuSensor);
+    }
+
+    imuSensor->readTemp();
+    temperature = imuSensor->calcTemp(imuSensor->temperature);
+    lastTempMillis = millis();
 
-    return imuSensor->calcAccel(imuSensor->az);
+    loadCalibration();
+
+    return true;
 }
 
-float AloraIMULSM9DS1Adapter::readGyroX() {
-    imuSensor->readGyro();
+/**
+ * @brief Poll LSM9DS1 for a new sample and feed it to the orientation filter.
+ * Only the status register is read when no new sample is available, so this
+ * can be called on every loop iteration.
+ */
+void AloraIMULSM9DS1Adapter::update() {
+    if (imuSensor == NULL) {
+        return;
+    }
+
+    if (calibrationRunning) {
+        imuSensor->updateCalibration();
+
+        // accel/gyro calibration owns the FIFO, regular reads would steal its samples
+        if (imuSensor->isCalibrating()) {
+            return;
+        }
+
+        if (!magCalibrating) {
+            calibrationRunning = false;
+
+            // biases were measured at the current temperature without compensation
+            imuSensor->readTemp();
+            temperature = imuSensor->calcTemp(imuSensor->temperature);
+            tempCompensation.setReference(temperature);
+
+            for (uint8_t i = 0; i < 3; i++) {
+                gyroBase[i] = imuSensor->gBias[i];
+                accelBase[i] = imuSensor->aBias[i];
+            }
+
+            gyroBiasTracker.reset(gyroBase);
+            saveCalibration();
+        }
+    }
+
+    if (motionGating && !calibrationRunning && !updateMotionGating()) {
+        return;
+    }
+
+    float gyro[3] = { 0.0f, 0.0f, 0.0f };
+    float accel[3];
+
+    if (capture != NULL && capture->isArmed()) {
+        // FIFO streaming owns the output registers, continue with the newest captured sample
+        if (capture->update() == 0) {
+            return;
+        }
+
+        loadSample(capture->getLatestSample());
+
+        if (capture->isFrozen()) {
+            setOutputRate(captureRestoreRate, captureRestoreSensors);
+        }
+    } else if (vibration != NULL && vibration->isRunning()) {
+        // same for vibration analysis, the spectrum is computed inside vibration->update()
+        if (vibration->update() == 0) {
+            return;
+        }
+
+        loadSample(vibration->getLatestSample());
+    } else if (decimating) {
+        if (!loadDecimatedSample()) {
+            return;
+        }
+    } else if (enabledSensors & ALORA_IMU_GYRO) {
+        if (!imuSensor->gyroAvailable()) {
+            return;
+        }
+
+        imuSensor->readGyro();
+        imuSensor->readAccel();
+    } else if (imuSensor->accelAvailable()) {
+        imuSensor->readAccel();
+    } else {
+        return;
+    }
 
-    return imuSensor->calcGyro(imuSensor->gx);
+    if (enabledSensors & ALORA_IMU_GYRO) {
+        gyro[0] = imuSensor->calcGyro(imuSensor->gx);
+        gyro[1] = imuSensor->calcGyro(imuSensor->gy);
+        gyro[2] = imuSensor->calcGyro(imuSensor->gz);
+    }
+
+    accel[0] = imuSensor->calcAccel(imuSensor->ax);
+    accel[1] = imuSensor->calcAccel(imuSensor->ay);
+    accel[2] = imuSensor->calcAccel(imuSensor->az);
+
+    // stationary check would misread the motion of a running calibration,
+    // and the bias models need gyroscope samples
+    if (!calibrationRunning && (enabledSensors & ALORA_IMU_GYRO)) {
+        compensate(gyro, accel);
+    }
+
+    if ((enabledSensors & ALORA_IMU_MAG) && imuSensor->magAvailable()) {
+        float mx, my, mz;
+        readMagCorrected(mx, my, mz);
+
+        // magnetometer X axis points the opposite way of accelerometer/gyroscope X axis
+        magBody[0] = -mx;
+        magBody[1] = my;
+        magBody[2] = mz;
+    }
+
+    accelBody[0] = accel[0];
+    accelBody[1] = accel[1];
+    accelBody[2] = accel[2];
+    gyroBody[0] = gyro[0];
+    gyroBody[1] = gyro[1];
+    gyroBody[2] = gyro[2];
+
+    uint32_t now = micros();
+    if (lastUpdateMicros != 0) {
+        float dt = (now - lastUpdateMicros) * 1e-6f;
+        ahrs.update(gyro[0], gyro[1], gyro[2], accel[0], accel[1], accel[2], magBody[0], magBody[1], magBody[2], dt);
+    }
+
+    lastUpdateMicros = now;
+
+    // calibration biases are measured at a fixed full scale
+    if (autoRange && !calibrationRunning) {
+        updateRanges();
+    }
 }
 
-float AloraIMULSM9DS1Adapter::readGyroY() {
-    imuSensor->readGyro();
+/**
+ * @brief Run the motion gating state machine. Inactivity status and, without
+ * ALORA_IMU_INT1_PIN, the wake interrupt source are read every
+ * ALORA_IMU_MOTION_POLL_MS. With the pin, an idle sensor costs no bus access.
+ *
+ * @return true if the sensor is active and should be sampled
+ */
+bool AloraIMULSM9DS1Adapter::updateMotionGating() {
+    uint32_t now = millis();
+    bool poll = now - lastMotionPollMillis >= ALORA_IMU_MOTION_POLL_MS;
+
+    if (motionIdle) {
+#if ALORA_IMU_INT1_PIN >= 0
+        bool moved = motionFlag;
+#else
+        bool moved = poll && imuSensor->getAccelIntSrc() != 0;
+#endif
+
+        if (poll) {
+            lastMotionPollMillis = now;
+        }
+
+        if (!moved) {
+            return false;
+        }
+
+        leaveMotionIdle();
+
+        return true;
+    }
+
+    // a running capture or vibration analysis needs the full rate
+    if (!poll || isStreaming()) {
+        return true;
+    }
+
+    lastMotionPollMillis = now;
+
+    if (imuSensor->getInactivity()) {
+        enterMotionIdle();
+
+        return false;
+    }
 
-    return imuSensor->calcGyro(imuSensor->gy);
+    return true;
 }
 
-float AloraIMULSM9DS1Adapter::readGyroZ() {
-    imuSensor->readGyro();
+/**
+ * @brief Drop to accelerometer-only low rate and arm the wake interrupt
+ */
+void AloraIMULSM9DS1Adapter::enterMotionIdle() {
+    motionRestoreRate = requestedRate;
+    motionRestoreSensors = enabledSensors;
+
+    imuSensor->settings.accel.HPFInterruptEnable = true;
+    setOutputRate(ALORA_IMU_MOTION_IDLE_RATE_HZ, ALORA_IMU_ACCEL);
+
+    // threshold register compares with the upper byte of the output, 1 LSB = full scale / 128
+    float code = ALORA_IMU_MOTION_THRESHOLD_G * 128.0f / imuSensor->settings.accel.scale;
+    uint8_t ths = code >= 255.0f ? 255 : (code < 1.0f ? 1 : (uint8_t) code);
+
+    imuSensor->configAccelThs(ths, X_AXIS);
+    imuSensor->configAccelThs(ths, Y_AXIS);
+    imuSensor->configAccelThs(ths, Z_AXIS);
+    imuSensor->configAccelInt(XHIE_XL | YHIE_XL | ZHIE_XL);
+
+    // clear an event latched before the filter settled
+    imuSensor->getAccelIntSrc();
+    motionFlag = false;
 
-    return imuSensor->calcGyro(imuSensor->gz);
+#if ALORA_IMU_INT1_PIN >= 0
+    imuSensor->configInt(XG_INT1, INT_IG_XL, INT_ACTIVE_HIGH, INT_PUSH_PULL);
+    pinMode(ALORA_IMU_INT1_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(ALORA_IMU_INT1_PIN), onMotionInterrupt, RISING);
+#endif
+
+    motionIdle = true;
 }
 
-float AloraIMULSM9DS1Adapter::readMagX() {
-    imuSensor->readMag();
+/**
+ * @brief Disarm the wake interrupt and restore the full rate
+ */
+void AloraIMULSM9DS1Adapter::leaveMotionIdle() {
+#if ALORA_IMU_INT1_PIN >= 0
+    detachInterrupt(digitalPinToInterrupt(ALORA_IMU_INT1_PIN));
+    imuSensor->configInt(XG_INT1, 0, INT_ACTIVE_HIGH, INT_PUSH_PULL);
+#endif
+
+    imuSensor->configAccelInt(0);
+    imuSensor->getAccelIntSrc();
+    motionFlag = false;
 
-    return imuSensor->calcMag(imuSensor->mx);
+    imuSensor->settings.accel.HPFInterruptEnable = false;
+    setOutputRate(motionRestoreRate, motionRestoreSensors);
+
+    motionIdle = false;
+    lastMotionPollMillis = millis();
 }
 
-float AloraIMULSM9DS1Adapter::readMagY() {
-    imuSensor->readMag();
+void ALORA_IMU_ADAPTER_ISR_ATTR AloraIMULSM9DS1Adapter::onMotionInterrupt() {
+    motionFlag = true;
+}
+
+/**
+ * @brief Copy a sample drained from the FIFO into the LSM9DS1 sample fields,
+ * with the same bias removal readGyro() and readAccel() would apply
+ *
+ * @param sample raw sample
+ */
+void AloraIMULSM9DS1Adapter::loadSample(const AloraIMUSample& sample) {
+    bool autoCalc = imuSensor->getAutoCalc();
 
-    return imuSensor->calcMag(imuSensor->my);
+    imuSensor->gx = sample.gyro[0] - (autoCalc ? imuSensor->gBiasRaw[0] : 0);
+    imuSensor->gy = sample.gyro[1] - (autoCalc ? imuSensor->gBiasRaw[1] : 0);
+    imuSensor->gz = sample.gyro[2] - (autoCalc ? imuSensor->gBiasRaw[2] : 0);
+    imuSensor->ax = sample.accel[0] - (autoCalc ? imuSensor->aBiasRaw[0] : 0);
+    imuSensor->ay = sample.accel[1] - (autoCalc ? imuSensor->aBiasRaw[1] : 0);
+    imuSensor->az = sample.accel[2] - (autoCalc ? imuSensor->aBiasRaw[2] : 0);
 }
 
-float AloraIMULSM9DS1Adapter::readMagZ() {
-    imuSensor->readMag();
+/**
+ * @brief Drain the FIFO through the decimators and load the newest output of
+ * each
+ *
+ * @return true if the batch completed an output sample of both decimators
+ */
+bool AloraIMULSM9DS1Adapter::loadDecimatedSample() {
+    int16_t gyroRaw[3 * 32];
+    int16_t accelRaw[3 * 32];
+    uint8_t count = imuSensor->readFIFO(gyroRaw, accelRaw, 32);
+
+    // the decimators can be configured apart through their getters, so the output counts may differ
+    uint16_t accelOutputs = accelDecimator.process(accelRaw, count);
+    uint16_t gyroOutputs = gyroDecimator.process(gyroRaw, count);
+
+    if (accelOutputs == 0 || gyroOutputs == 0) {
+        return false;
+    }
+
+    AloraIMUSample sample;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        sample.gyro[axis] = gyroRaw[3 * (gyroOutputs - 1) + axis];
+        sample.accel[axis] = accelRaw[3 * (accelOutputs - 1) + axis];
+    }
 
-    return imuSensor->calcMag(imuSensor->mz);
+    loadSample(sample);
+
+    return true;
 }
 
-float AloraIMULSM9DS1Adapter::readMagHeading() {
-    float heading = 0.0;
-    float mx = readMagX();
-    float my = readMagY();
-    float mz = readMagZ();
-
-    if (imuSensor->my > 0) {
-        heading = 90 - (atan(mx / my) * (180 / PI));
-    } else if (imuSensor->my < 0) {
-        heading = -(atan(mx / my) * (180 / PI));
+/**
+ * @brief Step full scales on the sample just read. A range steps up as soon
+ * as one axis reaches ALORA_IMU_RANGE_UP_LEVEL, and down only after
+ * ALORA_IMU_RANGE_DOWN_SAMPLES samples that would fit the lower range with
+ * a large margin, so it does not toggle around one level. Raw biases are
+ * recalculated for the new resolution.
+ */
+void AloraIMULSM9DS1Adapter::updateRanges() {
+    static const uint8_t accelScales[] = { 2, 4, 8, 16 };
+    static const uint16_t gyroScales[] = { 245, 500, 2000 };
+
+    bool changed = false;
+    uint16_t peak = peakRaw(imuSensor->ax, imuSensor->ay, imuSensor->az);
+    uint8_t index = 0;
+    while (index < 3 && accelScales[index] < imuSensor->settings.accel.scale) {
+        index++;
+    }
+
+    if (peak >= ALORA_IMU_RANGE_UP_LEVEL && index < 3) {
+        imuSensor->setAccelScale(accelScales[index + 1]);
+        changed = true;
+    } else if (index > 0 && peak * (float) accelScales[index] < ALORA_IMU_RANGE_DOWN_FRACTION * accelScales[index - 1] * 32768.0f) {
+        if (++accelQuietSamples >= ALORA_IMU_RANGE_DOWN_SAMPLES) {
+            imuSensor->setAccelScale(accelScales[index - 1]);
+            changed = true;
+        }
     } else {
-        if (mx < 0) {
-            heading = 180.0;
+        accelQuietSamples = 0;
+    }
+
+    if (enabledSensors & ALORA_IMU_GYRO) {
+        peak = peakRaw(imuSensor->gx, imuSensor->gy, imuSensor->gz);
+        index = 0;
+        while (index < 2 && gyroScales[index] < imuSensor->settings.gyro.scale) {
+            index++;
+        }
+
+        if (peak >= ALORA_IMU_RANGE_UP_LEVEL && index < 2) {
+            imuSensor->setGyroScale(gyroScales[index + 1]);
+            changed = true;
+        } else if (index > 0 && peak * (float) gyroScales[index] < ALORA_IMU_RANGE_DOWN_FRACTION * gyroScales[index - 1] * 32768.0f) {
+            if (++gyroQuietSamples >= ALORA_IMU_RANGE_DOWN_SAMPLES) {
+                imuSensor->setGyroScale(gyroScales[index - 1]);
+                changed = true;
+            }
         } else {
-            heading = 0.0;
+            gyroQuietSamples = 0;
         }
     }
 
-    return heading;
+    if (!changed) {
+        return;
+    }
+
+    accelQuietSamples = 0;
+    gyroQuietSamples = 0;
+    rangeChangeCount++;
+
+    // filter history holds samples of the old resolution
+    accelDecimator.reset();
+    gyroDecimator.reset();
+
+    if (imuSensor->getAutoCalc()) {
+        adoptSensorCalibration();
+        applyBiases();
+    }
+}
+
+/**
+ * @brief Largest absolute value of a raw sample
+ *
+ * @return uint16_t largest absolute axis value
+ */
+uint16_t AloraIMULSM9DS1Adapter::peakRaw(int16_t x, int16_t y, int16_t z) {
+    uint16_t ax = x < 0 ? -(int32_t) x : x;
+    uint16_t ay = y < 0 ? -(int32_t) y : y;
+    uint16_t az = z < 0 ? -(int32_t) z : z;
+    uint16_t peak = ax > ay ? ax : ay;
+
+    return peak > az ? peak : az;
 }
 
 /**
- * @brief Get pointer to LSM9DS1 object
+ * @brief Run the bias models on a sample and move updated estimates into the
+ * LSM9DS1 bias subtraction. The gyroscope bias tracker sees every sample, the
+ * die temperature is read every ALORA_IMU_TEMP_INTERVAL_MS. Values are
+ * corrected in place, so the current sample already uses the new biases.
  *
- * @return LSM9DS1* pointer to LSM9DS1 object
+ * @param gyro gyroscope sample in deg/s, as returned by readGyro()
+ * @param accel accelerometer sample in g, as returned by readAccel()
  */
-LSM9DS1* AloraIMULSM9DS1Adapter::getIMUSensor() {
-    return this->imuSensor;
+void AloraIMULSM9DS1Adapter::compensate(float gyro[3], float accel[3]) {
+    // readGyro() and readAccel() already subtracted the raw biases, the models need raw values
+    float gyroSubtracted[3] = { 0.0f, 0.0f, 0.0f };
+    float accelSubtracted[3] = { 0.0f, 0.0f, 0.0f };
+    if (imuSensor->getAutoCalc()) {
+        adoptSensorCalibration();
+
+        for (uint8_t i = 0; i < 3; i++) {
+            gyroSubtracted[i] = imuSensor->calcGyro(imuSensor->gBiasRaw[i]);
+            accelSubtracted[i] = imuSensor->calcAccel(imuSensor->aBiasRaw[i]);
+        }
+    }
+
+    float gyroRaw[3];
+    float accelRaw[3];
+    float gyroOffset[3];
+    tempCompensation.getGyroOffset(temperature, gyroOffset);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroRaw[i] = gyro[i] + gyroSubtracted[i];
+        accelRaw[i] = accel[i] + accelSubtracted[i];
+    }
+
+    bool changed = false;
+
+    // tracker estimates the bias at the reference temperature
+    if (gyroBiasTracker.update(gyroRaw[0] - gyroOffset[0], gyroRaw[1] - gyroOffset[1], gyroRaw[2] - gyroOffset[2],
+            accelRaw[0], accelRaw[1], accelRaw[2]) && gyroBiasTracking) {
+        gyroBiasTracker.getBias(gyroBase);
+        changed = true;
+    }
+
+    if (tempCompensating) {
+        if (gyroBiasTracker.isStill()) {
+            tempCompensation.addStillSample(gyroRaw[0], gyroRaw[1], gyroRaw[2], accelRaw[0], accelRaw[1], accelRaw[2]);
+        } else {
+            tempCompensation.addMotion();
+        }
+
+        uint32_t now = millis();
+        if (now - lastTempMillis >= ALORA_IMU_TEMP_INTERVAL_MS) {
+            lastTempMillis = now;
+
+            imuSensor->readTemp();
+            temperature = imuSensor->calcTemp(imuSensor->temperature);
+
+            if (tempCompensation.addTemperature(temperature)) {
+                calibrationFlags |= ALORA_IMU_CALIBRATION_TEMPERATURE;
+
+                if (now - lastTempSaveMillis >= ALORA_IMU_TEMP_SAVE_INTERVAL_MS) {
+                    lastTempSaveMillis = now;
+                    saveCalibration();
+                }
+            }
+
+            changed = changed || tempCompensation.hasModel();
+        }
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    applyBiases();
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyro[i] = gyroRaw[i] - imuSensor->calcGyro(imuSensor->gBiasRaw[i]);
+        accel[i] = accelRaw[i] - imuSensor->calcAccel(imuSensor->aBiasRaw[i]);
+    }
+}
+
+/**
+ * @brief Load biases at the reference temperature plus the temperature
+ * offset at the last measured die temperature into LSM9DS1
+ */
+void AloraIMULSM9DS1Adapter::applyBiases() {
+    float gyroBias[3];
+    float accelBias[3];
+
+    tempCompensation.getGyroOffset(temperature, gyroBias);
+    tempCompensation.getAccelOffset(temperature, accelBias);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroBias[i] += gyroBase[i];
+        accelBias[i] += accelBase[i];
+    }
+
+    imuSensor->setCalibration(gyroBias, accelBias);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroApplied[i] = gyroBias[i];
+        accelApplied[i] = accelBias[i];
+    }
+}
+
+/**
+ * @brief Take over biases LSM9DS1::calibrate() measured when it was called
+ * through getIMUSensor(). LSM9DS1 then holds biases applyBiases() did not
+ * load, which would otherwise be replaced by the stale bases.
+ */
+void AloraIMULSM9DS1Adapter::adoptSensorCalibration() {
+    if (!imuSensor->getAutoCalc()) {
+        return;
+    }
+
+    bool calibrated = false;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (imuSensor->gBias[i] != gyroApplied[i] || imuSensor->aBias[i] != accelApplied[i]) {
+            calibrated = true;
+        }
+    }
+
+    if (!calibrated) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroBase[i] = imuSensor->gBias[i];
+        accelBase[i] = imuSensor->aBias[i];
+        gyroApplied[i] = gyroBase[i];
+        accelApplied[i] = accelBase[i];
+    }
+
+    gyroBiasTracker.reset(gyroBase);
+    calibrationFlags |= ALORA_IMU_CALIBRATION_ACCEL_GYRO;
+}
+
+float AloraIMULSM9DS1Adapter::readAccelX() {
+    float x, y, z;
+    readAccel(x, y, z);
+
+    return x;
+}
+
+float AloraIMULSM9DS1Adapter::readAccelY() {
+    float x, y, z;
+    readAccel(x, y, z);
+
+    return y;
+}
+
+float AloraIMULSM9DS1Adapter::readAccelZ() {
+    float x, y, z;
+    readAccel(x, y, z);
+
+    return z;
+}
+
+/**
+ * @brief Read all accelerometer axes in a single bus transaction. While
+ * calibration or FIFO streaming owns the sensor, the last sample of update()
+ * is returned without a bus transaction.
+ *
+ * @param x X axis value will be stored in this variable
+ * @param y Y axis value will be stored in this variable
+ * @param z Z axis value will be stored in this variable
+ */
+void AloraIMULSM9DS1Adapter::readAccel(float& x, float& y, float& z) {
+    if (isRegisterReadBlocked()) {
+        x = accelBody[0];
+        y = accelBody[1];
+        z = accelBody[2];
+
+        return;
+    }
+
+    imuSensor->readAccel();
+
+    x = imuSensor->calcAccel(imuSensor->ax);
+    y = imuSensor->calcAccel(imuSensor->ay);
+    z = imuSensor->calcAccel(imuSensor->az);
+}
+
+float AloraIMULSM9DS1Adapter::readGyroX() {
+    float x, y, z;
+    readGyro(x, y, z);
+
+    return x;
+}
+
+float AloraIMULSM9DS1Adapter::readGyroY() {
+    float x, y, z;
+    readGyro(x, y, z);
+
+    return y;
+}
+
+float AloraIMULSM9DS1Adapter::readGyroZ() {
+    float x, y, z;
+    readGyro(x, y, z);
+
+    return z;
+}
+
+/**
+ * @brief Read all gyroscope axes in a single bus transaction. While
+ * calibration or FIFO streaming owns the sensor, the last sample of update()
+ * is returned without a bus transaction.
+ *
+ * @param x X axis value will be stored in this variable
+ * @param y Y axis value will be stored in this variable
+ * @param z Z axis value will be stored in this variable
+ */
+void AloraIMULSM9DS1Adapter::readGyro(float& x, float& y, float& z) {
+    if (isRegisterReadBlocked()) {
+        x = gyroBody[0];
+        y = gyroBody[1];
+        z = gyroBody[2];
+
+        return;
+    }
+
+    imuSensor->readGyro();
+
+    x = imuSensor->calcGyro(imuSensor->gx);
+    y = imuSensor->calcGyro(imuSensor->gy);
+    z = imuSensor->calcGyro(imuSensor->gz);
+}
+
+float AloraIMULSM9DS1Adapter::readMagX() {
+    float x, y, z;
+    readMag(x, y, z);
+
+    return x;
+}
+
+float AloraIMULSM9DS1Adapter::readMagY() {
+    float x, y, z;
+    readMag(x, y, z);
+
+    return y;
+}
+
+float AloraIMULSM9DS1Adapter::readMagZ() {
+    float x, y, z;
+    readMag(x, y, z);
+
+    return z;
+}
+
+/**
+ * @brief Read all magnetometer axes in a single bus transaction. While
+ * calibration or FIFO streaming owns the sensor, the last sample of update()
+ * is returned, so the ellipsoid fit does not get extra samples.
+ *
+ * @param x X axis value will be stored in this variable
+ * @param y Y axis value will be stored in this variable
+ * @param z Z axis value will be stored in this variable
+ */
+void AloraIMULSM9DS1Adapter::readMag(float& x, float& y, float& z) {
+    if (isRegisterReadBlocked()) {
+        // magBody is in accelerometer/gyroscope frame
+        x = -magBody[0];
+        y = magBody[1];
+        z = magBody[2];
+
+        return;
+    }
+
+    readMagCorrected(x, y, z);
+}
+
+/**
+ * @brief Read magnetometer and apply the hard/soft-iron correction. While the
+ * ellipsoid fit is collecting, the uncorrected sample is fed to it first.
+ *
+ * @param x X axis value will be stored in this variable
+ * @param y Y axis value will be stored in this variable
+ * @param z Z axis value will be stored in this variable
+ */
+void AloraIMULSM9DS1Adapter::readMagCorrected(float& x, float& y, float& z) {
+    imuSensor->readMag();
+
+    x = imuSensor->calcMag(imuSensor->mx);
+    y = imuSensor->calcMag(imuSensor->my);
+    z = imuSensor->calcMag(imuSensor->mz);
+
+    if (magCalibrating && magCalibrator.addSample(x, y, z)) {
+        uint16_t samples = magCalibrator.getSampleCount();
+
+        if (samples >= magNextSolve) {
+            if (magCalibrator.solve()) {
+                magCalibrating = false;
+                calibrationFlags |= ALORA_IMU_CALIBRATION_SOFT_IRON;
+            } else {
+                magNextSolve = samples + ALORA_MAG_CALIBRATOR_RETRY_SAMPLES;
+            }
+        }
+    }
+
+    magCalibrator.apply(x, y, z);
+}
+
+/**
+ * @brief Read tilt-compensated heading from the orientation filter.
+ * No bus transaction is done, the filter is fed by update().
+ *
+ * @return float heading in degrees clockwise from magnetic north
+ */
+float AloraIMULSM9DS1Adapter::readMagHeading() {
+    return ahrs.getHeading();
+}
+
+/**
+ * @brief Read roll angle from the orientation filter
+ *
+ * @return float roll in degrees
+ */
+float AloraIMULSM9DS1Adapter::readRoll() {
+    return ahrs.getRoll();
+}
+
+/**
+ * @brief Read pitch angle from the orientation filter
+ *
+ * @return float pitch in degrees
+ */
+float AloraIMULSM9DS1Adapter::readPitch() {
+    return ahrs.getPitch();
+}
+
+/**
+ * @brief Rotate the latest accelerometer sample to the earth frame of the
+ * orientation filter and remove gravity
+ *
+ * @param east acceleration towards magnetic east in m/s^2 will be stored here
+ * @param north acceleration towards magnetic north in m/s^2 will be stored here
+ * @param up upwards acceleration in m/s^2 will be stored here
+ * @param timestamp micros() of the sample will be stored here
+ * @return true if a sample was fed to the orientation filter
+ */
+bool AloraIMULSM9DS1Adapter::readEarthAcceleration(float& east, float& north, float& up, uint32_t& timestamp) {
+    if (lastUpdateMicros == 0) {
+        return false;
+    }
+
+    float w, x, y, z;
+    ahrs.getQuaternion(w, x, y, z);
+
+    const float* a = accelBody;
+    const float gravity = 9.80665f;
+
+    // orientation filter earth frame is x magnetic north, y west, z up
+    float ex = (1.0f - 2.0f * (y * y + z * z)) * a[0] + 2.0f * (x * y - w * z) * a[1] + 2.0f * (x * z + w * y) * a[2];
+    float ey = 2.0f * (x * y + w * z) * a[0] + (1.0f - 2.0f * (x * x + z * z)) * a[1] + 2.0f * (y * z - w * x) * a[2];
+    float ez = 2.0f * (x * z - w * y) * a[0] + 2.0f * (y * z + w * x) * a[1] + (1.0f - 2.0f * (x * x + y * y)) * a[2];
+
+    east = -ey * gravity;
+    north = ex * gravity;
+    up = (ez - 1.0f) * gravity;
+    timestamp = lastUpdateMicros;
+
+    return true;
+}
+
+/**
+ * @brief Select sensor data rates and power modes for a target output rate.
+ * The lowest data rate at or above the target is used, gyroscope low-power
+ * mode is enabled up to 119 Hz and unused sensors are powered down. Without
+ * gyroscope the accelerometer runs alone in its low-power mode with the
+ * largest decimation that still meets the target, and the orientation filter
+ * only corrects from accelerometer and magnetometer.
+ *
+ * @param hz target output rate in Hz
+ * @param sensors sensors to power, ALORA_IMU_ACCEL, ALORA_IMU_GYRO and ALORA_IMU_MAG bits
+ * @return true on success
+ */
+bool AloraIMULSM9DS1Adapter::setOutputRate(float hz, uint8_t sensors) {
+    // data rates of settings.*.sampleRate codes, gyroscope and accelerometer codes start at 1
+    static const float gyroRates[] = { 14.9f, 59.5f, 119.0f, 238.0f, 476.0f, 952.0f };
+    static const float accelRates[] = { 10.0f, 50.0f, 119.0f, 238.0f, 476.0f, 952.0f };
+    static const float magRates[] = { 0.625f, 1.25f, 2.5f, 5.0f, 10.0f, 20.0f, 40.0f, 80.0f };
+
+    if (imuSensor == NULL || !(hz > 0.0f)) {
+        return false;
+    }
+
+    uint8_t code = 0;
+    imuSensor->settings.accel.decimation = 0;
+
+    if (sensors & ALORA_IMU_GYRO) {
+        while (code < 5 && gyroRates[code] < hz) {
+            code++;
+        }
+
+        // accelerometer follows the gyroscope data rate while both are on
+        imuSensor->settings.gyro.enabled = true;
+        imuSensor->settings.gyro.sampleRate = code + 1;
+        imuSensor->settings.gyro.lowPowerEnable = gyroRates[code] <= 119.0f;
+        imuSensor->settings.accel.enabled = true;
+        imuSensor->settings.accel.sampleRate = code + 1;
+        outputRate = gyroRates[code];
+    } else {
+        while (code < 5 && accelRates[code] < hz) {
+            code++;
+        }
+
+        uint8_t decimation = 0;
+        while (decimation < 3 && accelRates[code] / (2 << decimation) >= hz) {
+            decimation++;
+        }
+
+        // gyroscope power-down puts the accelerometer in its own low-power mode
+        imuSensor->settings.gyro.enabled = false;
+        imuSensor->settings.accel.enabled = (sensors & ALORA_IMU_ACCEL) != 0;
+        imuSensor->settings.accel.sampleRate = code + 1;
+        imuSensor->settings.accel.decimation = decimation;
+        outputRate = (sensors & ALORA_IMU_ACCEL) ? accelRates[code] / (1 << decimation) : 0.0f;
+    }
+
+    if (sensors & ALORA_IMU_MAG) {
+        float magTarget = hz < ALORA_IMU_MAG_MAX_RATE_HZ ? hz : ALORA_IMU_MAG_MAX_RATE_HZ;
+
+        code = 0;
+        while (code < 7 && magRates[code] < magTarget) {
+            code++;
+        }
+
+        imuSensor->settings.mag.sampleRate = code;
+        imuSensor->settings.mag.operatingMode = 0;
+    } else {
+        imuSensor->settings.mag.operatingMode = 2;
+    }
+
+    imuSensor->applySettings();
+
+    enabledSensors = sensors;
+    requestedRate = hz;
+    lastUpdateMicros = 0;
+
+    return true;
+}
+
+/**
+ * @brief Use a capture engine. update() feeds it while it is armed and keeps
+ * the orientation filter running on the captured samples.
+ *
+ * @param capture capture engine, NULL to detach
+ */
+void AloraIMULSM9DS1Adapter::attachCapture(AloraIMUCapture* capture) {
+    if (this->capture != NULL) {
+        stopCapture();
+    }
+
+    this->capture = capture;
+    if (capture != NULL) {
+        capture->begin(imuSensor);
+    }
+}
+
+/**
+ * @brief Switch to ALORA_IMU_CAPTURE_RATE_HZ and arm the attached capture
+ * engine. The previous output rate is restored when the event window is
+ * frozen or stopCapture() is called.
+ *
+ * @return true if the capture is armed
+ */
+bool AloraIMULSM9DS1Adapter::startCapture() {
+    if (imuSensor == NULL || capture == NULL || calibrationRunning) {
+        return false;
+    }
+
+    // the FIFO streams into one consumer at a time
+    if (isStreaming()) {
+        return false;
+    }
+
+    if (capture->isArmed()) {
+        return true;
+    }
+
+    if (motionIdle) {
+        leaveMotionIdle();
+    }
+
+    captureRestoreRate = requestedRate;
+    captureRestoreSensors = enabledSensors;
+    setOutputRate(ALORA_IMU_CAPTURE_RATE_HZ, enabledSensors | ALORA_IMU_ACCEL | ALORA_IMU_GYRO);
+
+    if (!capture->arm()) {
+        setOutputRate(captureRestoreRate, captureRestoreSensors);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stop the attached capture engine and discard its event window
+ */
+void AloraIMULSM9DS1Adapter::stopCapture() {
+    if (capture == NULL) {
+        return;
+    }
+
+    bool armed = capture->isArmed();
+    capture->release();
+
+    if (armed) {
+        setOutputRate(captureRestoreRate, captureRestoreSensors);
+    }
+}
+
+/**
+ * @brief Use a vibration analyzer. update() feeds it while it is running and
+ * keeps the orientation filter running on the streamed samples.
+ *
+ * @param vibration vibration analyzer, NULL to detach
+ */
+void AloraIMULSM9DS1Adapter::attachVibration(AloraVibrationAnalyzer* vibration) {
+    if (this->vibration != NULL) {
+        stopVibration();
+    }
+
+    this->vibration = vibration;
+    if (vibration != NULL) {
+        vibration->begin(imuSensor);
+    }
+}
+
+/**
+ * @brief Switch to ALORA_VIBRATION_RATE_HZ and stream the FIFO into the
+ * attached vibration analyzer until stopVibration() is called
+ *
+ * @return true if the analyzer is running
+ */
+bool AloraIMULSM9DS1Adapter::startVibration() {
+    if (imuSensor == NULL || vibration == NULL || calibrationRunning) {
+        return false;
+    }
+
+    if (vibration->isRunning()) {
+        return true;
+    }
+
+    // the FIFO streams into one consumer at a time
+    if (isStreaming()) {
+        return false;
+    }
+
+    if (motionIdle) {
+        leaveMotionIdle();
+    }
+
+    vibrationRestoreRate = requestedRate;
+    vibrationRestoreSensors = enabledSensors;
+    setOutputRate(ALORA_VIBRATION_RATE_HZ, enabledSensors | ALORA_IMU_ACCEL | ALORA_IMU_GYRO);
+
+    if (!vibration->start(outputRate)) {
+        setOutputRate(vibrationRestoreRate, vibrationRestoreSensors);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Stop the attached vibration analyzer and restore the previous output
+ * rate. The last features stay available.
+ */
+void AloraIMULSM9DS1Adapter::stopVibration() {
+    if (vibration == NULL || !vibration->isRunning()) {
+        return;
+    }
+
+    vibration->stop();
+    setOutputRate(vibrationRestoreRate, vibrationRestoreSensors);
+}
+
+/**
+ * @brief Run the accelerometer and gyroscope at ALORA_IMU_DECIMATION_INPUT_RATE_HZ
+ * and filter the FIFO stream down to the requested rate, instead of reading the
+ * latest register value at a lower data rate. The decimated rate is the input
+ * rate divided by the nearest integer factor, see getDecimatedRate().
+ *
+ * @param hz output rate in Hz
+ * @return true if decimation started
+ */
+bool AloraIMULSM9DS1Adapter::startDecimation(float hz) {
+    if (imuSensor == NULL || calibrationRunning || !(hz > 0.0f)) {
+        return false;
+    }
+
+    if (decimating) {
+        stopDecimation();
+    }
+
+    // the FIFO streams into one consumer at a time
+    if (isStreaming()) {
+        return false;
+    }
+
+    if (motionIdle) {
+        leaveMotionIdle();
+    }
+
+    decimationRestoreRate = requestedRate;
+    decimationRestoreSensors = enabledSensors;
+    setOutputRate(ALORA_IMU_DECIMATION_INPUT_RATE_HZ, enabledSensors | ALORA_IMU_ACCEL | ALORA_IMU_GYRO);
+
+    float factor = outputRate / hz + 0.5f;
+    if (factor < 1.0f) {
+        factor = 1.0f;
+    } else if (factor > ALORA_DECIMATOR_MAX_FACTOR) {
+        factor = ALORA_DECIMATOR_MAX_FACTOR;
+    }
+
+    accelDecimator.setFactor((uint8_t) factor);
+    gyroDecimator.setFactor((uint8_t) factor);
+
+    imuSensor->enableFIFO(true);
+    imuSensor->setFIFO(FIFO_CONT, 0x1F);
+    decimating = true;
+
+    return true;
+}
+
+/**
+ * @brief Stop decimation and restore the previous output rate
+ */
+void AloraIMULSM9DS1Adapter::stopDecimation() {
+    if (!decimating) {
+        return;
+    }
+
+    imuSensor->setFIFO(FIFO_OFF, 0x00);
+    imuSensor->enableFIFO(false);
+    decimating = false;
+
+    setOutputRate(decimationRestoreRate, decimationRestoreSensors);
+}
+
+/**
+ * @brief Get output rate of the running decimation
+ *
+ * @return float decimated rate in Hz, 0 if decimation is not running
+ */
+float AloraIMULSM9DS1Adapter::getDecimatedRate() {
+    return decimating ? outputRate / accelDecimator.getFactor() : 0.0f;
+}
+
+/**
+ * @brief Get decimator of the accelerometer stream, for example to filter
+ * batches of a capture with the same response
+ *
+ * @return AloraDecimator& accelerometer decimator
+ */
+AloraDecimator& AloraIMULSM9DS1Adapter::getAccelDecimator() {
+    return accelDecimator;
+}
+
+/**
+ * @brief Get decimator of the gyroscope stream
+ *
+ * @return AloraDecimator& gyroscope decimator
+ */
+AloraDecimator& AloraIMULSM9DS1Adapter::getGyroDecimator() {
+    return gyroDecimator;
+}
+
+/**
+ * @brief Check whether a capture, the vibration analyzer or decimation owns the FIFO
+ *
+ * @return true if the FIFO is streaming
+ */
+bool AloraIMULSM9DS1Adapter::isStreaming() {
+    return (capture != NULL && capture->isArmed()) || (vibration != NULL && vibration->isRunning()) || decimating;
+}
+
+/**
+ * @brief Check whether output register reads outside update() would disturb
+ * the FIFO: a running calibration averages every sample, an armed capture
+ * must stay contiguous, and the vibration FFT and the decimation filter need
+ * constant sample spacing. Each register read pops a FIFO slot.
+ *
+ * @return true if the float getters must return the last sample of update()
+ */
+bool AloraIMULSM9DS1Adapter::isRegisterReadBlocked() {
+    return calibrationRunning || isStreaming();
+}
+
+/**
+ * @brief Get accelerometer/gyroscope output rate picked by setOutputRate()
+ *
+ * @return float output rate in Hz after decimation, 0 when powered down
+ */
+float AloraIMULSM9DS1Adapter::getOutputRate() {
+    return outputRate;
+}
+
+/**
+ * @brief Start non-blocking IMU calibration. It is advanced by update(), so
+ * the main loop keeps running. Accelerometer and gyroscope calibration needs
+ * the board flat and still. Magnetometer calibration needs the board rotated
+ * through all orientations, it finishes once the samples cover enough of
+ * the ellipsoid for a plausible fit.
+ *
+ * @param includeMag also fit the magnetometer hard-iron offset and soft-iron matrix
+ */
+void AloraIMULSM9DS1Adapter::startCalibration(bool includeMag) {
+    // accelerometer/gyroscope calibration drains gyroscope samples from the FIFO
+    if (imuSensor == NULL || !(enabledSensors & ALORA_IMU_GYRO)) {
+        return;
+    }
+
+    if (isStreaming()) {
+        return;
+    }
+
+    if (motionIdle) {
+        leaveMotionIdle();
+    }
+
+    imuSensor->beginCalibration(true);
+    calibrationFlags |= ALORA_IMU_CALIBRATION_ACCEL_GYRO;
+
+    if (includeMag) {
+        // fit uncorrected samples, the offset registers would hide the hard iron
+        const float zero[3] = { 0.0f, 0.0f, 0.0f };
+        imuSensor->setMagCalibration(zero, true);
+        calibrationFlags &= ~ALORA_IMU_CALIBRATION_MAG;
+
+        magCalibrator.reset();
+        magCalibrating = true;
+        magNextSolve = ALORA_MAG_CALIBRATOR_SAMPLES;
+    }
+
+    calibrationRunning = true;
+}
+
+/**
+ * @brief Check whether a calibration started by startCalibration() is running
+ *
+ * @return true if calibration is still running
+ */
+bool AloraIMULSM9DS1Adapter::isCalibrating() {
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    return imuSensor->isCalibrating() || magCalibrating;
+}
+
+/**
+ * @brief Get calibration progress
+ *
+ * @return uint8_t progress in percent of the slowest running calibration
+ */
+uint8_t AloraIMULSM9DS1Adapter::getCalibrationProgress() {
+    if (imuSensor == NULL) {
+        return 100;
+    }
+
+    uint8_t agProgress = imuSensor->calibrationProgress();
+    uint8_t magProgress = 100;
+
+    // a rejected fit keeps collecting past the nominal sample count
+    if (magCalibrating) {
+        uint32_t samples = magCalibrator.getSampleCount();
+        magProgress = samples >= ALORA_MAG_CALIBRATOR_SAMPLES ? 99 : samples * 100 / ALORA_MAG_CALIBRATOR_SAMPLES;
+    }
+
+    return agProgress < magProgress ? agProgress : magProgress;
+}
+
+/**
+ * @brief Load saved calibration and apply it to LSM9DS1, so no calibration
+ * is needed at boot. Called by begin().
+ *
+ * @return true if calibration for this sensor was found
+ */
+bool AloraIMULSM9DS1Adapter::loadCalibration() {
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    AloraIMUCalibration calibration;
+    if (!AloraIMUCalibrationStore::load(sensorId, calibration)) {
+        return false;
+    }
+
+    if (calibration.flags & ALORA_IMU_CALIBRATION_ACCEL_GYRO) {
+        for (uint8_t i = 0; i < 3; i++) {
+            gyroBase[i] = calibration.gyroBias[i];
+            accelBase[i] = calibration.accelBias[i];
+        }
+
+        gyroBiasTracker.reset(gyroBase);
+    }
+
+    if (calibration.flags & ALORA_IMU_CALIBRATION_TEMPERATURE) {
+        tempCompensation.setModel(calibration.temperatureReference, calibration.gyroTempSlope, calibration.accelTempSlope);
+    }
+
+    if (calibration.flags & (ALORA_IMU_CALIBRATION_ACCEL_GYRO | ALORA_IMU_CALIBRATION_TEMPERATURE)) {
+        applyBiases();
+    }
+
+    if (calibration.flags & ALORA_IMU_CALIBRATION_MAG) {
+        imuSensor->setMagCalibration(calibration.magBias, true);
+    } else if (calibration.flags & ALORA_IMU_CALIBRATION_SOFT_IRON) {
+        // registers keep their value over a reset, the fit was done without offset
+        const float zero[3] = { 0.0f, 0.0f, 0.0f };
+        imuSensor->setMagCalibration(zero, true);
+    }
+
+    if (calibration.flags & ALORA_IMU_CALIBRATION_SOFT_IRON) {
+        magCalibrator.setCorrection(calibration.softIron, calibration.hardIron);
+    }
+
+    calibrationFlags = calibration.flags;
+
+    return true;
+}
+
+/**
+ * @brief Save the current calibration. Called automatically when a
+ * calibration started by startCalibration() completes.
+ *
+ * @return true on success
+ */
+bool AloraIMULSM9DS1Adapter::saveCalibration() {
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    // also covers a blocking LSM9DS1::calibrate() called through getIMUSensor()
+    adoptSensorCalibration();
+
+    if (calibrationFlags == 0) {
+        return false;
+    }
+
+    AloraIMUCalibration calibration;
+    calibration.sensorId = sensorId;
+    calibration.flags = calibrationFlags;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        calibration.gyroBias[i] = gyroBase[i];
+        calibration.accelBias[i] = accelBase[i];
+        calibration.magBias[i] = imuSensor->mBias[i];
+    }
+
+    magCalibrator.getCorrection(calibration.softIron, calibration.hardIron);
+    tempCompensation.getModel(calibration.temperatureReference, calibration.gyroTempSlope, calibration.accelTempSlope);
+
+    return AloraIMUCalibrationStore::save(calibration);
+}
+
+/**
+ * @brief Get pointer to LSM9DS1 object
+ *
+ * @return LSM9DS1* pointer to LSM9DS1 object
+ */
+LSM9DS1* AloraIMULSM9DS1Adapter::getIMUSensor() {
+    return this->imuSensor;
+}
+
+/**
+ * @brief Get the orientation filter fed by update()
+ *
+ * @return AloraAHRS& reference to the orientation filter
+ */
+AloraAHRS& AloraIMULSM9DS1Adapter::getAHRS() {
+    return this->ahrs;
+}
+
+/**
+ * @brief Get the magnetometer calibrator applied to every magnetometer read
+ *
+ * @return AloraMagCalibrator& reference to the magnetometer calibrator
+ */
+AloraMagCalibrator& AloraIMULSM9DS1Adapter::getMagCalibrator() {
+    return this->magCalibrator;
+}
+
+/**
+ * @brief Enable or disable gyroscope bias tracking while stationary
+ *
+ * @param enable true to track the bias
+ */
+void AloraIMULSM9DS1Adapter::setGyroBiasTracking(bool enable) {
+    if (enable && !gyroBiasTracking) {
+        gyroBiasTracker.reset(gyroBase);
+    }
+
+    gyroBiasTracking = enable;
+}
+
+/**
+ * @brief Enable or disable learning and applying the temperature model
+ *
+ * @param enable true to compensate temperature
+ */
+void AloraIMULSM9DS1Adapter::setTempCompensation(bool enable) {
+    tempCompensating = enable;
+}
+
+/**
+ * @brief Get die temperature of the last low rate temperature read
+ *
+ * @return float temperature in degrees Celsius
+ */
+float AloraIMULSM9DS1Adapter::getTemperature() {
+    return temperature;
+}
+
+/**
+ * @brief Get the temperature model of accelerometer and gyroscope biases
+ *
+ * @return AloraIMUTempCompensation& reference to the temperature model
+ */
+AloraIMUTempCompensation& AloraIMULSM9DS1Adapter::getTempCompensation() {
+    return this->tempCompensation;
+}
+
+/**
+ * @brief Get accelerometer full scale range
+ *
+ * @return uint16_t full scale in g
+ */
+uint16_t AloraIMULSM9DS1Adapter::getAccelRange() {
+    return imuSensor != NULL ? imuSensor->settings.accel.scale : 0;
+}
+
+/**
+ * @brief Get gyroscope full scale range
+ *
+ * @return uint16_t full scale in degrees per second
+ */
+uint16_t AloraIMULSM9DS1Adapter::getGyroRange() {
+    return imuSensor != NULL ? imuSensor->settings.gyro.scale : 0;
+}
+
+/**
+ * @brief Get number of full scale changes made by auto-ranging
+ *
+ * @return uint16_t number of range changes, wraps around
+ */
+uint16_t AloraIMULSM9DS1Adapter::getRangeChangeCount() {
+    return rangeChangeCount;
+}
+
+/**
+ * @brief Read features of the last vibration spectrum
+ *
+ * @param features vibration features will be stored here
+ * @return true if an attached analyzer computed a spectrum
+ */
+bool AloraIMULSM9DS1Adapter::readVibration(AloraVibrationFeatures& features) {
+    if (vibration == NULL || !vibration->hasFeatures()) {
+        return false;
+    }
+
+    features = vibration->getFeatures();
+
+    return true;
+}
+
+/**
+ * @brief Enable or disable automatic full scale selection
+ *
+ * @param enable true to step full scales from update()
+ */
+void AloraIMULSM9DS1Adapter::setAutoRange(bool enable) {
+    autoRange = enable;
+    accelQuietSamples = 0;
+    gyroQuietSamples = 0;
+}
+
+/**
+ * @brief Enable or disable motion-gated sampling. The LSM9DS1 inactivity
+ * function detects a still sensor, which is then held at
+ * ALORA_IMU_MOTION_IDLE_RATE_HZ with the gyroscope powered down and is not
+ * sampled. The accelerometer threshold interrupt on high-pass filtered data
+ * wakes it back to the previous rate.
+ *
+ * @param enable true to gate sampling on motion
+ * @return true on success
+ */
+bool AloraIMULSM9DS1Adapter::setMotionGating(bool enable) {
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    if (enable) {
+        // activity threshold register is 7 bits, 1 LSB = full scale / 128
+        float code = ALORA_IMU_INACTIVITY_THRESHOLD_G * 128.0f / imuSensor->settings.accel.scale;
+        uint8_t ths = code >= 127.0f ? 127 : (code < 1.0f ? 1 : (uint8_t) code);
+
+        imuSensor->configInactivity(ALORA_IMU_INACTIVITY_DURATION, ths, false);
+        lastMotionPollMillis = millis();
+    } else {
+        if (motionIdle) {
+            leaveMotionIdle();
+        }
+
+        imuSensor->configInactivity(0, 0, false);
+    }
+
+    motionGating = enable;
+
+    return true;
+}
+
+/**
+ * @brief Check whether motion gating holds the sensor idle
+ *
+ * @return true if idle, values are not refreshed until motion
+ */
+bool AloraIMULSM9DS1Adapter::isMotionIdle() {
+    return motionIdle;
 }
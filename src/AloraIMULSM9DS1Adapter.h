@@ -6,6 +6,108 @@
 #include <Arduino.h>
 #include "SparkFunLSM9DS1.h"
 #include "AloraIMUSensorInterface.h"
+#include "AloraAHRS.h"
+#include "AloraIMUCalibrationStore.h"
+#include "AloraMagCalibrator.h"
+#include "AloraGyroBiasTracker.h"
+#include "AloraIMUTempCompensation.h"
+#include "AloraIMUCapture.h"
+#include "AloraVibrationAnalyzer.h"
+#include "AloraDecimator.h"
+
+/** Accelerometer bit of the sensor mask passed to setOutputRate() */
+#define ALORA_IMU_ACCEL 0x01
+
+/** Gyroscope bit of the sensor mask passed to setOutputRate() */
+#define ALORA_IMU_GYRO 0x02
+
+/** Magnetometer bit of the sensor mask passed to setOutputRate() */
+#define ALORA_IMU_MAG 0x04
+
+/** Output rate in Hz set by begin(). The lowest sensor data rate that satisfies it is used */
+#if !defined(ALORA_IMU_OUTPUT_RATE_HZ)
+    #define ALORA_IMU_OUTPUT_RATE_HZ 50.0f
+#endif
+
+/** Sensors enabled by begin(), ALORA_IMU_ACCEL, ALORA_IMU_GYRO and ALORA_IMU_MAG bits */
+#if !defined(ALORA_IMU_SENSORS)
+    #define ALORA_IMU_SENSORS (ALORA_IMU_ACCEL | ALORA_IMU_GYRO | ALORA_IMU_MAG)
+#endif
+
+/** Highest magnetometer data rate in Hz picked by setOutputRate(), heading changes slowly */
+#if !defined(ALORA_IMU_MAG_MAX_RATE_HZ)
+    #define ALORA_IMU_MAG_MAX_RATE_HZ 20.0f
+#endif
+
+/** Step accelerometer/gyroscope full scale automatically. Disabled by default */
+#if !defined(ALORA_IMU_AUTO_RANGE)
+    #define ALORA_IMU_AUTO_RANGE 0
+#endif
+
+/** Raw magnitude on any axis that steps the full scale up, about 85 % of the range */
+#if !defined(ALORA_IMU_RANGE_UP_LEVEL)
+    #define ALORA_IMU_RANGE_UP_LEVEL 28000
+#endif
+
+/** Fraction of the next lower full scale the peak must stay below before stepping down */
+#if !defined(ALORA_IMU_RANGE_DOWN_FRACTION)
+    #define ALORA_IMU_RANGE_DOWN_FRACTION 0.4f
+#endif
+
+/** Consecutive samples with enough headroom before the full scale steps down */
+#if !defined(ALORA_IMU_RANGE_DOWN_SAMPLES)
+    #define ALORA_IMU_RANGE_DOWN_SAMPLES 256
+#endif
+
+/** Accelerometer-only data rate in Hz while motion gating holds the sensor idle */
+#if !defined(ALORA_IMU_MOTION_IDLE_RATE_HZ)
+    #define ALORA_IMU_MOTION_IDLE_RATE_HZ 10.0f
+#endif
+
+/** High-pass filtered acceleration in g on any axis that wakes the sensor from idle */
+#if !defined(ALORA_IMU_MOTION_THRESHOLD_G)
+    #define ALORA_IMU_MOTION_THRESHOLD_G 0.1f
+#endif
+
+/** Acceleration in g below which the sensor counts as inactive */
+#if !defined(ALORA_IMU_INACTIVITY_THRESHOLD_G)
+    #define ALORA_IMU_INACTIVITY_THRESHOLD_G 0.1f
+#endif
+
+/** Inactivity duration register value before the sensor goes idle, in units of 8 / ODR */
+#if !defined(ALORA_IMU_INACTIVITY_DURATION)
+    #define ALORA_IMU_INACTIVITY_DURATION 255
+#endif
+
+/** Interval in milliseconds of the inactivity status check, and of the wake check when ALORA_IMU_INT1_PIN is not set */
+#if !defined(ALORA_IMU_MOTION_POLL_MS)
+    #define ALORA_IMU_MOTION_POLL_MS 500
+#endif
+
+/** Accelerometer/gyroscope data rate in Hz while startDecimation() filters the FIFO down to the output rate */
+#if !defined(ALORA_IMU_DECIMATION_INPUT_RATE_HZ)
+    #define ALORA_IMU_DECIMATION_INPUT_RATE_HZ 952
+#endif
+
+/** Track gyroscope bias while the sensor is stationary. Enabled by default */
+#if !defined(ALORA_IMU_GYRO_BIAS_TRACKING)
+    #define ALORA_IMU_GYRO_BIAS_TRACKING 1
+#endif
+
+/** Learn and apply the bias-versus-temperature model. Enabled by default */
+#if !defined(ALORA_IMU_TEMP_COMPENSATION)
+    #define ALORA_IMU_TEMP_COMPENSATION 1
+#endif
+
+/** Interval of the die temperature read in milliseconds */
+#if !defined(ALORA_IMU_TEMP_INTERVAL_MS)
+    #define ALORA_IMU_TEMP_INTERVAL_MS 10000
+#endif
+
+/** Shortest interval in milliseconds between two saves of a refined temperature model, limits flash wear */
+#if !defined(ALORA_IMU_TEMP_SAVE_INTERVAL_MS)
+    #define ALORA_IMU_TEMP_SAVE_INTERVAL_MS 3600000UL
+#endif
 
 class AloraIMULSM9DS1Adapter: public AloraIMUSensorBase {
 public:
@@ -13,23 +115,131 @@ public:
     virtual ~AloraIMULSM9DS1Adapter();
 
     virtual bool begin(uint8_t accAddress, uint8_t magAddress);
+    virtual void retain();
+    virtual bool resume(uint8_t accAddress, uint8_t magAddress);
+    virtual void update();
+
     virtual float readAccelX();
     virtual float readAccelY();
     virtual float readAccelZ();
+    virtual void readAccel(float& x, float& y, float& z);
 
     virtual float readGyroX();
     virtual float readGyroY();
     virtual float readGyroZ();
+    virtual void readGyro(float& x, float& y, float& z);
 
     virtual float readMagX();
     virtual float readMagY();
     virtual float readMagZ();
+    virtual void readMag(float& x, float& y, float& z);
     virtual float readMagHeading();
+    virtual float readRoll();
+    virtual float readPitch();
+    virtual uint16_t getAccelRange();
+    virtual uint16_t getGyroRange();
+    virtual uint16_t getRangeChangeCount();
+    virtual bool readVibration(AloraVibrationFeatures& features);
+    virtual bool readEarthAcceleration(float& east, float& north, float& up, uint32_t& timestamp);
+
+    void setAutoRange(bool enable);
+    virtual bool setMotionGating(bool enable);
+    virtual bool isMotionIdle();
+
+    bool setOutputRate(float hz, uint8_t sensors = ALORA_IMU_ACCEL | ALORA_IMU_GYRO | ALORA_IMU_MAG);
+    float getOutputRate();
+
+    void attachCapture(AloraIMUCapture* capture);
+    bool startCapture();
+    void stopCapture();
+
+    void attachVibration(AloraVibrationAnalyzer* vibration);
+    bool startVibration();
+    void stopVibration();
+
+    bool startDecimation(float hz);
+    void stopDecimation();
+    float getDecimatedRate();
+    AloraDecimator& getAccelDecimator();
+    AloraDecimator& getGyroDecimator();
+
+    void startCalibration(bool includeMag = true);
+    bool isCalibrating();
+    uint8_t getCalibrationProgress();
+    bool loadCalibration();
+    bool saveCalibration();
+    void setGyroBiasTracking(bool enable);
+    void setTempCompensation(bool enable);
+    float getTemperature();
 
     LSM9DS1* getIMUSensor();
+    AloraAHRS& getAHRS();
+    AloraMagCalibrator& getMagCalibrator();
+    AloraIMUTempCompensation& getTempCompensation();
 
 private:
     LSM9DS1* imuSensor;                     /**< LSM9DS1 object pointer */
+    AloraAHRS ahrs;                         /**< Orientation filter fed by update() */
+    uint32_t lastUpdateMicros;              /**< Time of the last sample fed to the orientation filter */
+    float magBody[3];                       /**< Latest magnetometer sample in accelerometer/gyroscope frame */
+    float accelBody[3];                     /**< Latest compensated accelerometer sample fed to the orientation filter, in g */
+    float gyroBody[3];                      /**< Latest compensated gyroscope sample fed to the orientation filter, in deg/s */
+    uint8_t enabledSensors;                 /**< Powered sensors, ALORA_IMU_ACCEL, ALORA_IMU_GYRO and ALORA_IMU_MAG bits */
+    float outputRate;                       /**< Accelerometer/gyroscope output rate in Hz after decimation */
+    float requestedRate;                    /**< Target rate of the last setOutputRate() */
+    AloraIMUCapture* capture;               /**< Attached capture engine, NULL if none */
+    float captureRestoreRate;               /**< Target rate restored when a capture ends */
+    uint8_t captureRestoreSensors;          /**< Sensors restored when a capture ends */
+    AloraVibrationAnalyzer* vibration;      /**< Attached vibration analyzer, NULL if none */
+    float vibrationRestoreRate;             /**< Target rate restored when vibration analysis stops */
+    uint8_t vibrationRestoreSensors;        /**< Sensors restored when vibration analysis stops */
+    AloraDecimator accelDecimator;          /**< Anti-alias decimator of the accelerometer FIFO stream */
+    AloraDecimator gyroDecimator;           /**< Anti-alias decimator of the gyroscope FIFO stream */
+    bool decimating;                        /**< Whether the FIFO streams through the decimators */
+    float decimationRestoreRate;            /**< Target rate restored when decimation stops */
+    uint8_t decimationRestoreSensors;       /**< Sensors restored when decimation stops */
+    bool motionGating;                      /**< Whether sampling is gated on motion */
+    bool motionIdle;                        /**< Whether motion gating holds the sensor idle */
+    float motionRestoreRate;                /**< Target rate restored on wake */
+    uint8_t motionRestoreSensors;           /**< Sensors restored on wake */
+    uint32_t lastMotionPollMillis;          /**< Time of the last inactivity or wake check */
+    static volatile bool motionFlag;        /**< Set by the INT1 interrupt handler while idle */
+    bool autoRange;                         /**< Whether full scales are stepped by update() */
+    uint16_t accelQuietSamples;             /**< Consecutive accelerometer samples with headroom for a lower range */
+    uint16_t gyroQuietSamples;              /**< Consecutive gyroscope samples with headroom for a lower range */
+    uint16_t rangeChangeCount;              /**< Number of full scale changes, wraps around */
+    uint16_t sensorId;                      /**< LSM9DS1 combined WHO_AM_I, identifies saved calibration */
+    uint8_t calibrationFlags;               /**< Valid calibration parts, ALORA_IMU_CALIBRATION_* bits */
+    bool calibrationRunning;                /**< Whether startCalibration() is waiting for completion */
+    AloraMagCalibrator magCalibrator;       /**< Magnetometer ellipsoid fit and correction */
+    bool magCalibrating;                    /**< Whether samples are collected for the ellipsoid fit */
+    uint16_t magNextSolve;                  /**< Sample count of the next ellipsoid fit attempt */
+    AloraGyroBiasTracker gyroBiasTracker;   /**< Gyroscope bias estimate updated while stationary */
+    bool gyroBiasTracking;                  /**< Whether gyroBiasTracker is fed by update() */
+    AloraIMUTempCompensation tempCompensation; /**< Bias-versus-temperature model */
+    bool tempCompensating;                  /**< Whether the temperature model is learned and applied */
+    float temperature;                      /**< Last die temperature in degrees Celsius */
+    uint32_t lastTempMillis;                /**< Time of the last die temperature read */
+    uint32_t lastTempSaveMillis;            /**< Time of the last save of a refined temperature model */
+    float gyroBase[3];                      /**< Gyroscope bias at the reference temperature in deg/s */
+    float accelBase[3];                     /**< Accelerometer bias at the reference temperature in g */
+    float gyroApplied[3];                   /**< Gyroscope bias applyBiases() last loaded into LSM9DS1 */
+    float accelApplied[3];                  /**< Accelerometer bias applyBiases() last loaded into LSM9DS1 */
+
+    void readMagCorrected(float& x, float& y, float& z);
+    void compensate(float gyro[3], float accel[3]);
+    void applyBiases();
+    void adoptSensorCalibration();
+    void updateRanges();
+    void loadSample(const AloraIMUSample& sample);
+    bool isStreaming();
+    bool isRegisterReadBlocked();
+    bool loadDecimatedSample();
+    bool updateMotionGating();
+    void enterMotionIdle();
+    void leaveMotionIdle();
+    static void onMotionInterrupt();
+    static uint16_t peakRaw(int16_t x, int16_t y, int16_t z);
 };
 
 #endif
@@ -4,6 +4,7 @@
 #define ALORA_IMU_SENSOR_INTERFACE_H
 
 #include <stdint.h>
+#include "AloraVibrationAnalyzer.h"
 
 /**
  * @brief Abstract class for IMU sensor adapter on Alora board.
@@ -93,6 +94,159 @@ public:
      * @return float heading in degree unit
      */
     virtual float readMagHeading() = 0;
+
+    /**
+     * @brief Poll the sensor for new samples and feed them to any internal filter.
+     * Call this as often as possible, ideally at the sensor output data rate.
+     */
+    virtual void update() {}
+
+    /**
+     * @brief Read all accelerometer axes
+     *
+     * @param x X axis value will be stored in this variable
+     * @param y Y axis value will be stored in this variable
+     * @param z Z axis value will be stored in this variable
+     */
+    virtual void readAccel(float& x, float& y, float& z) {
+        x = readAccelX();
+        y = readAccelY();
+        z = readAccelZ();
+    }
+
+    /**
+     * @brief Read all gyroscope axes
+     *
+     * @param x X axis value will be stored in this variable
+     * @param y Y axis value will be stored in this variable
+     * @param z Z axis value will be stored in this variable
+     */
+    virtual void readGyro(float& x, float& y, float& z) {
+        x = readGyroX();
+        y = readGyroY();
+        z = readGyroZ();
+    }
+
+    /**
+     * @brief Read all magnetometer axes
+     *
+     * @param x X axis value will be stored in this variable
+     * @param y Y axis value will be stored in this variable
+     * @param z Z axis value will be stored in this variable
+     */
+    virtual void readMag(float& x, float& y, float& z) {
+        x = readMagX();
+        y = readMagY();
+        z = readMagZ();
+    }
+
+    /**
+     * @brief Read roll angle
+     *
+     * @return float roll in degree unit
+     */
+    virtual float readRoll() {
+        return 0.0;
+    }
+
+    /**
+     * @brief Read pitch angle
+     *
+     * @return float pitch in degree unit
+     */
+    virtual float readPitch() {
+        return 0.0;
+    }
+
+    /**
+     * @brief Get accelerometer full scale range
+     *
+     * @return uint16_t full scale in g, 0 if unknown
+     */
+    virtual uint16_t getAccelRange() {
+        return 0;
+    }
+
+    /**
+     * @brief Get gyroscope full scale range
+     *
+     * @return uint16_t full scale in degree per second unit, 0 if unknown
+     */
+    virtual uint16_t getGyroRange() {
+        return 0;
+    }
+
+    /**
+     * @brief Get number of full scale range changes since begin. Samples read
+     * before and after a change differ in resolution.
+     *
+     * @return uint16_t number of range changes, wraps around
+     */
+    virtual uint16_t getRangeChangeCount() {
+        return 0;
+    }
+
+    /**
+     * @brief Read features of the last vibration spectrum
+     *
+     * @param features vibration features will be stored here
+     * @return true if a spectrum is available
+     */
+    virtual bool readVibration(AloraVibrationFeatures& features) {
+        return false;
+    }
+
+    /**
+     * @brief Read gravity-free acceleration of the latest sample in a local
+     * east, north, up frame referenced to magnetic north
+     *
+     * @param east acceleration towards east in m/s^2 will be stored here
+     * @param north acceleration towards north in m/s^2 will be stored here
+     * @param up upwards acceleration in m/s^2 will be stored here
+     * @param timestamp micros() of the sample will be stored here
+     * @return true if a sample with orientation is available
+     */
+    virtual bool readEarthAcceleration(float& east, float& north, float& up, uint32_t& timestamp) {
+        return false;
+    }
+
+    /**
+     * @brief Enable or disable motion-gated sampling. While the sensor is
+     * still it runs at a low rate and is not polled, motion wakes it.
+     *
+     * @param enable true to gate sampling on motion
+     * @return true if the sensor supports motion gating
+     */
+    virtual bool setMotionGating(bool enable) {
+        return false;
+    }
+
+    /**
+     * @brief Check whether motion gating put the sensor to idle
+     *
+     * @return true if the sensor is idle and its values are not refreshed
+     */
+    virtual bool isMotionIdle() {
+        return false;
+    }
+
+    /**
+     * @brief Keep the sensor configuration over a deep sleep that leaves the
+     * sensor powered, see resume()
+     */
+    virtual void retain() {}
+
+    /**
+     * @brief Take over a sensor that stayed powered over deep sleep with the
+     * configuration kept by retain(), without resetting it
+     *
+     * @param accAddress I2C address of accelerometer
+     * @param magAddress I2C address of magnetometer
+     * @return true if the sensor was taken over, false if begin() is needed
+     */
+    virtual bool resume(uint8_t accAddress, uint8_t magAddress) {
+        return false;
+    }
 };
 
 #endif
@@ -0,0 +1,228 @@
+/** @file */
+
+#include "AloraIMUTempCompensation.h"
+
+AloraIMUTempCompensation::AloraIMUTempCompensation() {
+    reset();
+}
+
+/**
+ * @brief Drop the model and all collected points
+ */
+void AloraIMUTempCompensation::reset() {
+    clearRegression(gyroFit);
+    clearRegression(accelFit);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroSum[i] = 0.0f;
+        accelSum[i] = 0.0f;
+        gyroSlope[i] = 0.0f;
+        accelSlope[i] = 0.0f;
+    }
+
+    sampleCount = 0;
+    reference = 25.0f;
+    modelValid = false;
+}
+
+/**
+ * @brief Set model, for example one restored from persistent storage
+ *
+ * @param reference temperature in degrees Celsius the calibrated biases belong to
+ * @param gyroSlope gyroscope bias slope in deg/s per degree
+ * @param accelSlope accelerometer bias slope in g per degree
+ */
+void AloraIMUTempCompensation::setModel(float reference, const float gyroSlope[3], const float accelSlope[3]) {
+    this->reference = reference;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        this->gyroSlope[i] = gyroSlope[i];
+        this->accelSlope[i] = accelSlope[i];
+    }
+
+    modelValid = true;
+}
+
+/**
+ * @brief Get current model
+ *
+ * @param reference reference temperature will be stored here
+ * @param gyroSlope gyroscope bias slope will be stored here
+ * @param accelSlope accelerometer bias slope will be stored here
+ */
+void AloraIMUTempCompensation::getModel(float& reference, float gyroSlope[3], float accelSlope[3]) {
+    reference = this->reference;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroSlope[i] = this->gyroSlope[i];
+        accelSlope[i] = this->accelSlope[i];
+    }
+}
+
+/**
+ * @brief Check whether slopes were fitted or loaded
+ *
+ * @return true if the model is valid
+ */
+bool AloraIMUTempCompensation::hasModel() {
+    return modelValid;
+}
+
+/**
+ * @brief Set temperature of the currently applied calibration. Slopes stay
+ * valid, only the point of zero offset moves.
+ *
+ * @param temperature temperature in degrees Celsius
+ */
+void AloraIMUTempCompensation::setReference(float temperature) {
+    reference = temperature;
+}
+
+/**
+ * @brief Accumulate a stationary sample for the next point
+ *
+ * @param gx gyroscope X axis in deg/s, without bias removal
+ * @param gy gyroscope Y axis in deg/s, without bias removal
+ * @param gz gyroscope Z axis in deg/s, without bias removal
+ * @param ax accelerometer X axis in g, without bias removal
+ * @param ay accelerometer Y axis in g, without bias removal
+ * @param az accelerometer Z axis in g, without bias removal
+ */
+void AloraIMUTempCompensation::addStillSample(float gx, float gy, float gz, float ax, float ay, float az) {
+    if (sampleCount == UINT16_MAX) {
+        return;
+    }
+
+    gyroSum[0] += gx;
+    gyroSum[1] += gy;
+    gyroSum[2] += gz;
+    accelSum[0] += ax;
+    accelSum[1] += ay;
+    accelSum[2] += az;
+    sampleCount++;
+}
+
+/**
+ * @brief Report a moving sample. Pending samples and the accelerometer
+ * points of the current stationary period are dropped.
+ */
+void AloraIMUTempCompensation::addMotion() {
+    if (sampleCount == 0 && accelFit.count == 0.0) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroSum[i] = 0.0f;
+        accelSum[i] = 0.0f;
+    }
+
+    sampleCount = 0;
+    clearRegression(accelFit);
+}
+
+/**
+ * @brief Close the current point at the given temperature and refit
+ *
+ * @param temperature die temperature in degrees Celsius
+ * @return true if a slope was updated
+ */
+bool AloraIMUTempCompensation::addTemperature(float temperature) {
+    if (sampleCount == 0) {
+        return false;
+    }
+
+    float gyroMean[3];
+    float accelMean[3];
+
+    for (uint8_t i = 0; i < 3; i++) {
+        gyroMean[i] = gyroSum[i] / sampleCount;
+        accelMean[i] = accelSum[i] / sampleCount;
+        gyroSum[i] = 0.0f;
+        accelSum[i] = 0.0f;
+    }
+
+    sampleCount = 0;
+
+    double t = temperature - 25.0;
+    addPoint(gyroFit, t, gyroMean);
+    addPoint(accelFit, t, accelMean);
+
+    bool updated = solveSlope(gyroFit, gyroSlope);
+
+    // an accelerometer slope learned in an earlier stationary period is kept
+    updated = solveSlope(accelFit, accelSlope) || updated;
+
+    if (updated) {
+        modelValid = true;
+    }
+
+    return updated;
+}
+
+/**
+ * @brief Get gyroscope bias change from the reference temperature
+ *
+ * @param temperature die temperature in degrees Celsius
+ * @param offset bias change in deg/s will be stored here
+ */
+void AloraIMUTempCompensation::getGyroOffset(float temperature, float offset[3]) {
+    float delta = temperature - reference;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        offset[i] = gyroSlope[i] * delta;
+    }
+}
+
+/**
+ * @brief Get accelerometer bias change from the reference temperature
+ *
+ * @param temperature die temperature in degrees Celsius
+ * @param offset bias change in g will be stored here
+ */
+void AloraIMUTempCompensation::getAccelOffset(float temperature, float offset[3]) {
+    float delta = temperature - reference;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        offset[i] = accelSlope[i] * delta;
+    }
+}
+
+void AloraIMUTempCompensation::clearRegression(Regression& fit) {
+    fit.count = 0.0;
+    fit.sumT = 0.0;
+    fit.sumTT = 0.0;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        fit.sumY[i] = 0.0;
+        fit.sumTY[i] = 0.0;
+    }
+}
+
+void AloraIMUTempCompensation::addPoint(Regression& fit, double t, const float* y) {
+    fit.count = fit.count * ALORA_IMU_TEMP_FORGET + 1.0;
+    fit.sumT = fit.sumT * ALORA_IMU_TEMP_FORGET + t;
+    fit.sumTT = fit.sumTT * ALORA_IMU_TEMP_FORGET + t * t;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        fit.sumY[i] = fit.sumY[i] * ALORA_IMU_TEMP_FORGET + y[i];
+        fit.sumTY[i] = fit.sumTY[i] * ALORA_IMU_TEMP_FORGET + t * y[i];
+    }
+}
+
+bool AloraIMUTempCompensation::solveSlope(const Regression& fit, float* slope) {
+    if (fit.count < ALORA_IMU_TEMP_MIN_POINTS) {
+        return false;
+    }
+
+    // count * variance of the temperature points
+    double spread = fit.sumTT - fit.sumT * fit.sumT / fit.count;
+    if (spread < fit.count * ALORA_IMU_TEMP_MIN_STDDEV * ALORA_IMU_TEMP_MIN_STDDEV) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        slope[i] = (float) ((fit.sumTY[i] - fit.sumT * fit.sumY[i] / fit.count) / spread);
+    }
+
+    return true;
+}
@@ -0,0 +1,80 @@
+/** @file */
+
+#ifndef ALORA_IMU_TEMP_COMPENSATION_H
+#define ALORA_IMU_TEMP_COMPENSATION_H
+
+#include <stdint.h>
+
+/** Smallest temperature standard deviation in degrees Celsius of the collected points before a slope is fitted */
+#if !defined(ALORA_IMU_TEMP_MIN_STDDEV)
+    #define ALORA_IMU_TEMP_MIN_STDDEV 1.5f
+#endif
+
+/** Smallest number of collected points before a slope is fitted */
+#if !defined(ALORA_IMU_TEMP_MIN_POINTS)
+    #define ALORA_IMU_TEMP_MIN_POINTS 16
+#endif
+
+/** Forgetting factor applied to collected points for every new point, so the fit follows sensor aging */
+#if !defined(ALORA_IMU_TEMP_FORGET)
+    #define ALORA_IMU_TEMP_FORGET 0.9999
+#endif
+
+/**
+ * @brief Linear bias-versus-temperature model of accelerometer and gyroscope.
+ *
+ *     bias(T) = bias(reference) + slope * (T - reference)
+ *
+ * Slopes are learned online by least squares. Between two temperature reads,
+ * stationary samples are averaged into one point, so the fit runs at the
+ * temperature rate only. While stationary the true rate is zero, so gyroscope
+ * points are valid across stationary periods. Gravity changes with the
+ * orientation, so accelerometer points are dropped when the sensor moves and
+ * a slope is only learned within one long stationary period, which is the
+ * case for a fixed outdoor node.
+ */
+class AloraIMUTempCompensation {
+public:
+    AloraIMUTempCompensation();
+
+    void reset();
+    void setModel(float reference, const float gyroSlope[3], const float accelSlope[3]);
+    void getModel(float& reference, float gyroSlope[3], float accelSlope[3]);
+    bool hasModel();
+    void setReference(float temperature);
+
+    void addStillSample(float gx, float gy, float gz, float ax, float ay, float az);
+    void addMotion();
+    bool addTemperature(float temperature);
+
+    void getGyroOffset(float temperature, float offset[3]);
+    void getAccelOffset(float temperature, float offset[3]);
+
+private:
+    /**
+     * @brief Least squares statistics of one sensor, temperature is centered at 25 degrees
+     */
+    struct Regression {
+        double count;
+        double sumT;
+        double sumTT;
+        double sumY[3];
+        double sumTY[3];
+    };
+
+    Regression gyroFit;                     /**< Points of gyroscope rate versus temperature */
+    Regression accelFit;                    /**< Points of accelerometer value versus temperature, current stationary period */
+    float gyroSum[3];                       /**< Stationary gyroscope samples since the last temperature read */
+    float accelSum[3];                      /**< Stationary accelerometer samples since the last temperature read */
+    uint16_t sampleCount;                   /**< Number of samples in gyroSum and accelSum */
+    float reference;                        /**< Temperature the calibrated biases belong to */
+    float gyroSlope[3];                     /**< Gyroscope bias slope in deg/s per degree */
+    float accelSlope[3];                    /**< Accelerometer bias slope in g per degree */
+    bool modelValid;                        /**< Whether slopes were fitted or loaded */
+
+    static void clearRegression(Regression& fit);
+    static void addPoint(Regression& fit, double t, const float* y);
+    static bool solveSlope(const Regression& fit, float* slope);
+};
+
+#endif
@@ -0,0 +1,353 @@
+/** @file */
+
+#include "AloraMagCalibrator.h"
+#include <math.h>
+
+AloraMagCalibrator::AloraMagCalibrator() {
+    reset();
+    clearCorrection();
+}
+
+/**
+ * @brief Discard accumulated samples. The current correction is kept.
+ */
+void AloraMagCalibrator::reset() {
+    for (uint8_t i = 0; i < 45; i++) {
+        normal[i] = 0.0;
+    }
+
+    for (uint8_t i = 0; i < 9; i++) {
+        rhs[i] = 0.0;
+    }
+
+    sampleCount = 0;
+    lastX = 0.0f;
+    lastY = 0.0f;
+    lastZ = 0.0f;
+}
+
+/**
+ * @brief Fold an uncorrected magnetometer sample into the fit. Samples closer
+ * than ALORA_MAG_CALIBRATOR_MIN_DISTANCE to the last accepted one are skipped.
+ *
+ * @param x X axis value in gauss
+ * @param y Y axis value in gauss
+ * @param z Z axis value in gauss
+ * @return true if the sample was accepted
+ */
+bool AloraMagCalibrator::addSample(float x, float y, float z) {
+    float dx = x - lastX;
+    float dy = y - lastY;
+    float dz = z - lastZ;
+
+    if (sampleCount > 0 && dx * dx + dy * dy + dz * dz < ALORA_MAG_CALIBRATOR_MIN_DISTANCE * ALORA_MAG_CALIBRATOR_MIN_DISTANCE) {
+        return false;
+    }
+
+    if (sampleCount == UINT16_MAX) {
+        return false;
+    }
+
+    // quadric x'Ax + 2b'x = 1, unknowns are A00 A11 A22 A01 A02 A12 b0 b1 b2
+    double row[9] = {
+        (double) x * x, (double) y * y, (double) z * z,
+        2.0 * x * y, 2.0 * x * z, 2.0 * y * z,
+        2.0 * x, 2.0 * y, 2.0 * z
+    };
+
+    uint8_t index = 0;
+    for (uint8_t i = 0; i < 9; i++) {
+        for (uint8_t j = i; j < 9; j++) {
+            normal[index++] += row[i] * row[j];
+        }
+
+        rhs[i] += row[i];
+    }
+
+    lastX = x;
+    lastY = y;
+    lastZ = z;
+    sampleCount++;
+
+    return true;
+}
+
+/**
+ * @brief Get number of accepted samples since the last reset
+ *
+ * @return uint16_t number of samples
+ */
+uint16_t AloraMagCalibrator::getSampleCount() {
+    return sampleCount;
+}
+
+/**
+ * @brief Fit an ellipsoid to the accepted samples and update the correction.
+ * The correction is left unchanged when the samples do not describe a
+ * plausible ellipsoid, for example when the board was not rotated enough.
+ *
+ * @return true if the correction was updated
+ */
+bool AloraMagCalibrator::solve() {
+    if (sampleCount < 9) {
+        return false;
+    }
+
+    double a[81];
+    double v[9];
+    uint8_t index = 0;
+
+    for (uint8_t i = 0; i < 9; i++) {
+        for (uint8_t j = i; j < 9; j++) {
+            a[i * 9 + j] = normal[index];
+            a[j * 9 + i] = normal[index];
+            index++;
+        }
+
+        v[i] = rhs[i];
+    }
+
+    if (!solveLinear(a, v, 9)) {
+        return false;
+    }
+
+    double quadric[9] = {
+        v[0], v[3], v[4],
+        v[3], v[1], v[5],
+        v[4], v[5], v[2]
+    };
+
+    // center = -A^-1 b
+    double m[9];
+    double center[3] = { -v[6], -v[7], -v[8] };
+    for (uint8_t i = 0; i < 9; i++) {
+        m[i] = quadric[i];
+    }
+
+    if (!solveLinear(m, center, 3)) {
+        return false;
+    }
+
+    // (x - center)' A (x - center) = 1 + center' A center
+    double k = 1.0;
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            k += center[i] * quadric[i * 3 + j] * center[j];
+        }
+    }
+
+    if (!(k > 0.0)) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < 9; i++) {
+        m[i] = quadric[i] / k;
+    }
+
+    double vectors[9];
+    eigenSymmetric3(m, vectors);
+
+    double minEigen = m[0];
+    double maxEigen = m[0];
+    for (uint8_t i = 1; i < 3; i++) {
+        double eigen = m[i * 4];
+        minEigen = eigen < minEigen ? eigen : minEigen;
+        maxEigen = eigen > maxEigen ? eigen : maxEigen;
+    }
+
+    // all radii must be real, and radii ratio is sqrt of eigenvalue ratio
+    if (!(minEigen > 0.0) || maxEigen > minEigen * ALORA_MAG_CALIBRATOR_MAX_AXIS_RATIO * ALORA_MAG_CALIBRATOR_MAX_AXIS_RATIO) {
+        return false;
+    }
+
+    double radius = 1.0 / cbrt(sqrt(m[0] * m[4] * m[8]));
+    double scale[3] = { sqrt(m[0]) * radius, sqrt(m[4]) * radius, sqrt(m[8]) * radius };
+
+    // softIron = V diag(scale) V'
+    float matrix[9];
+    float hard[3];
+    for (uint8_t i = 0; i < 3; i++) {
+        for (uint8_t j = 0; j < 3; j++) {
+            double sum = 0.0;
+            for (uint8_t e = 0; e < 3; e++) {
+                sum += vectors[i * 3 + e] * scale[e] * vectors[j * 3 + e];
+            }
+
+            matrix[i * 3 + j] = (float) sum;
+        }
+
+        hard[i] = (float) center[i];
+    }
+
+    setCorrection(matrix, hard);
+    fieldStrength = (float) radius;
+
+    return true;
+}
+
+/**
+ * @brief Set correction, for example one restored from persistent storage
+ *
+ * @param softIron soft-iron matrix, row major
+ * @param hardIron hard-iron offset in gauss
+ */
+void AloraMagCalibrator::setCorrection(const float softIron[9], const float hardIron[3]) {
+    for (uint8_t i = 0; i < 9; i++) {
+        this->softIron[i] = softIron[i];
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        this->hardIron[i] = hardIron[i];
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        offset[i] = softIron[i * 3] * hardIron[0] + softIron[i * 3 + 1] * hardIron[1] + softIron[i * 3 + 2] * hardIron[2];
+    }
+
+    fieldStrength = 0.0f;
+}
+
+/**
+ * @brief Get current correction
+ *
+ * @param softIron soft-iron matrix will be stored here, row major
+ * @param hardIron hard-iron offset will be stored here
+ */
+void AloraMagCalibrator::getCorrection(float softIron[9], float hardIron[3]) {
+    for (uint8_t i = 0; i < 9; i++) {
+        softIron[i] = this->softIron[i];
+    }
+
+    for (uint8_t i = 0; i < 3; i++) {
+        hardIron[i] = this->hardIron[i];
+    }
+}
+
+/**
+ * @brief Reset correction to identity
+ */
+void AloraMagCalibrator::clearCorrection() {
+    const float identity[9] = { 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+    const float zero[3] = { 0.0f, 0.0f, 0.0f };
+
+    setCorrection(identity, zero);
+}
+
+/**
+ * @brief Get local field strength measured by the last successful fit
+ *
+ * @return float field strength in gauss, 0 if the correction was not fitted
+ */
+float AloraMagCalibrator::getFieldStrength() {
+    return fieldStrength;
+}
+
+/**
+ * @brief Solve a x = b by Gaussian elimination with partial pivoting
+ *
+ * @param a n x n matrix, row major, destroyed
+ * @param b right hand side, replaced by the solution
+ * @param n system size
+ * @return true if the matrix is not singular
+ */
+bool AloraMagCalibrator::solveLinear(double* a, double* b, uint8_t n) {
+    for (uint8_t col = 0; col < n; col++) {
+        uint8_t pivot = col;
+        for (uint8_t row = col + 1; row < n; row++) {
+            if (fabs(a[row * n + col]) > fabs(a[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+
+        if (fabs(a[pivot * n + col]) < 1e-12) {
+            return false;
+        }
+
+        if (pivot != col) {
+            for (uint8_t j = 0; j < n; j++) {
+                double swap = a[col * n + j];
+                a[col * n + j] = a[pivot * n + j];
+                a[pivot * n + j] = swap;
+            }
+
+            double swap = b[col];
+            b[col] = b[pivot];
+            b[pivot] = swap;
+        }
+
+        for (uint8_t row = col + 1; row < n; row++) {
+            double factor = a[row * n + col] / a[col * n + col];
+            for (uint8_t j = col; j < n; j++) {
+                a[row * n + j] -= factor * a[col * n + j];
+            }
+
+            b[row] -= factor * b[col];
+        }
+    }
+
+    for (int8_t row = n - 1; row >= 0; row--) {
+        double sum = b[row];
+        for (uint8_t j = row + 1; j < n; j++) {
+            sum -= a[row * n + j] * b[j];
+        }
+
+        b[row] = sum / a[row * n + row];
+    }
+
+    return true;
+}
+
+/**
+ * @brief Eigen decomposition of a symmetric 3x3 matrix by cyclic Jacobi rotations
+ *
+ * @param a symmetric matrix, row major, diagonalized in place
+ * @param v eigenvectors will be stored here as columns, row major
+ */
+void AloraMagCalibrator::eigenSymmetric3(double* a, double* v) {
+    for (uint8_t i = 0; i < 9; i++) {
+        v[i] = (i % 4 == 0) ? 1.0 : 0.0;
+    }
+
+    for (uint8_t sweep = 0; sweep < 16; sweep++) {
+        double offDiagonal = fabs(a[1]) + fabs(a[2]) + fabs(a[5]);
+        if (offDiagonal < 1e-15 * (fabs(a[0]) + fabs(a[4]) + fabs(a[8]))) {
+            return;
+        }
+
+        for (uint8_t p = 0; p < 2; p++) {
+            for (uint8_t q = p + 1; q < 3; q++) {
+                double apq = a[p * 3 + q];
+                if (apq == 0.0) {
+                    continue;
+                }
+
+                double theta = (a[q * 4] - a[p * 4]) / (2.0 * apq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                // a = J' a J, with J the rotation in the p-q plane
+                for (uint8_t k = 0; k < 3; k++) {
+                    double akp = a[k * 3 + p];
+                    double akq = a[k * 3 + q];
+                    a[k * 3 + p] = c * akp - s * akq;
+                    a[k * 3 + q] = s * akp + c * akq;
+                }
+
+                for (uint8_t k = 0; k < 3; k++) {
+                    double apk = a[p * 3 + k];
+                    double aqk = a[q * 3 + k];
+                    a[p * 3 + k] = c * apk - s * aqk;
+                    a[q * 3 + k] = s * apk + c * aqk;
+                }
+
+                for (uint8_t k = 0; k < 3; k++) {
+                    double vkp = v[k * 3 + p];
+                    double vkq = v[k * 3 + q];
+                    v[k * 3 + p] = c * vkp - s * vkq;
+                    v[k * 3 + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+/** @file */
+
+#ifndef ALORA_MAG_CALIBRATOR_H
+#define ALORA_MAG_CALIBRATOR_H
+
+#include <stdint.h>
+
+/** Minimum distance in gauss between two accepted samples, keeps a still board from dominating the fit */
+#if !defined(ALORA_MAG_CALIBRATOR_MIN_DISTANCE)
+    #define ALORA_MAG_CALIBRATOR_MIN_DISTANCE 0.02f
+#endif
+
+/** Accepted samples needed before the first fit is attempted */
+#if !defined(ALORA_MAG_CALIBRATOR_SAMPLES)
+    #define ALORA_MAG_CALIBRATOR_SAMPLES 200
+#endif
+
+/** Accepted samples collected between two fit attempts when a fit is rejected */
+#if !defined(ALORA_MAG_CALIBRATOR_RETRY_SAMPLES)
+    #define ALORA_MAG_CALIBRATOR_RETRY_SAMPLES 25
+#endif
+
+/** Largest accepted ratio between the longest and the shortest ellipsoid axis */
+#if !defined(ALORA_MAG_CALIBRATOR_MAX_AXIS_RATIO)
+    #define ALORA_MAG_CALIBRATOR_MAX_AXIS_RATIO 2.0f
+#endif
+
+/**
+ * @brief Online magnetometer calibration by ellipsoid fitting.
+ *
+ * Every accepted sample is folded into the normal equations of the least
+ * squares fit of a general quadric, so memory and per-sample cost do not
+ * depend on the number of samples. solve() turns the fitted ellipsoid into a
+ * hard-iron offset and a symmetric soft-iron matrix that maps the ellipsoid
+ * back onto a sphere with the same mean radius:
+ *
+ *     corrected = softIron * (raw - hardIron)
+ *
+ * apply() evaluates it as one fused matrix-vector product with a precomputed
+ * offset. The correction is identity until a fit succeeds or setCorrection()
+ * is called.
+ */
+class AloraMagCalibrator {
+public:
+    AloraMagCalibrator();
+
+    void reset();
+    bool addSample(float x, float y, float z);
+    uint16_t getSampleCount();
+    bool solve();
+
+    void setCorrection(const float softIron[9], const float hardIron[3]);
+    void getCorrection(float softIron[9], float hardIron[3]);
+    void clearCorrection();
+    float getFieldStrength();
+
+    /**
+     * @brief Correct a magnetometer sample
+     *
+     * @param x X axis value, corrected in place
+     * @param y Y axis value, corrected in place
+     * @param z Z axis value, corrected in place
+     */
+    inline void apply(float& x, float& y, float& z) const {
+        float inX = x;
+        float inY = y;
+        float inZ = z;
+
+        x = softIron[0] * inX + softIron[1] * inY + softIron[2] * inZ - offset[0];
+        y = softIron[3] * inX + softIron[4] * inY + softIron[5] * inZ - offset[1];
+        z = softIron[6] * inX + softIron[7] * inY + softIron[8] * inZ - offset[2];
+    }
+
+private:
+    double normal[45];                      /**< Upper triangle of the 9x9 normal matrix, row by row */
+    double rhs[9];                          /**< Right hand side of the normal equations */
+    uint16_t sampleCount;                   /**< Number of accepted samples */
+    float lastX, lastY, lastZ;              /**< Last accepted sample */
+    float softIron[9];                      /**< Soft-iron correction matrix, row major */
+    float hardIron[3];                      /**< Hard-iron offset in gauss */
+    float offset[3];                        /**< softIron * hardIron, subtracted by apply() */
+    float fieldStrength;                    /**< Mean radius of the fitted ellipsoid in gauss */
+
+    static bool solveLinear(double* a, double* b, uint8_t n);
+    static void eigenSymmetric3(double* a, double* v);
+};
+
+#endif
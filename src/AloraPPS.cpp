@@ -0,0 +1,213 @@
+/** @file */
+
+#include "AloraPPS.h"
+
+#if defined(ESP32)
+    #define ALORA_PPS_ISR_ATTR IRAM_ATTR
+#else
+    #define ALORA_PPS_ISR_ATTR
+#endif
+
+volatile uint32_t AloraPPS::interruptMicros = 0;
+volatile uint32_t AloraPPS::interruptCount = 0;
+
+AloraPPS::AloraPPS() {
+    pin = -1;
+    reset();
+}
+
+AloraPPS::~AloraPPS() {
+    end();
+}
+
+/**
+ * @brief Attach the interrupt handler to the PPS pin
+ *
+ * @param pin GPIO of the PPS output
+ * @return true if the pin is wired
+ */
+bool AloraPPS::begin(int8_t pin) {
+    end();
+
+    if (pin < 0) {
+        return false;
+    }
+
+    this->pin = pin;
+    reset();
+
+    pinMode(pin, INPUT);
+    lastPulse = interruptCount;
+    attachInterrupt(digitalPinToInterrupt(pin), onPulse, RISING);
+
+    return true;
+}
+
+/**
+ * @brief Detach the interrupt handler
+ */
+void AloraPPS::end() {
+    if (pin >= 0) {
+        detachInterrupt(digitalPinToInterrupt(pin));
+        pin = -1;
+    }
+}
+
+/**
+ * @brief Drop all pulses, the model unlocks
+ */
+void AloraPPS::reset() {
+    head = 0;
+    count = 0;
+    offset = 0.0;
+    slope = 0.0;
+    variance = 0.0;
+    meanX = 0.0;
+    sumXX = 0.0;
+    residual = 0.0;
+    lastPulse = interruptCount;
+}
+
+/**
+ * @brief Check for a new pulse
+ *
+ * @param timestamp micros() of the newest pulse will be stored here
+ * @return true if a pulse arrived since the last call
+ */
+bool AloraPPS::poll(uint32_t& timestamp) {
+    noInterrupts();
+    uint32_t pulse = interruptCount;
+    timestamp = interruptMicros;
+    interrupts();
+
+    if (pulse == lastPulse) {
+        return false;
+    }
+
+    lastPulse = pulse;
+
+    return true;
+}
+
+/**
+ * @brief Add a labeled pulse to the drift model. Pulses that are not a whole
+ * number of seconds after the previous one are rejected. A label that
+ * disagrees with the count of seconds, or a gap beyond ALORA_PPS_HOLDOVER_S,
+ * restarts the model.
+ *
+ * @param timestamp micros() of the pulse
+ * @param second UTC second the pulse starts, since 1970
+ * @return true if the pulse was used
+ */
+bool AloraPPS::addPulse(uint32_t timestamp, uint32_t second) {
+    if (count > 0) {
+        uint32_t elapsed = timestamp - pulseMicros[head];
+        uint32_t seconds = (elapsed + 500000UL) / 1000000UL;
+        int32_t jitter = (int32_t) (elapsed - seconds * 1000000UL);
+
+        bool gap = seconds > ALORA_PPS_HOLDOVER_S;
+
+        if (!gap && (seconds == 0 || jitter > ALORA_PPS_MAX_JITTER_US || jitter < -ALORA_PPS_MAX_JITTER_US)) {
+            return false;
+        }
+
+        if (gap || pulseSeconds[head] + seconds != second) {
+            count = 0;
+        }
+    }
+
+    head = count > 0 ? (head + 1) % ALORA_PPS_WINDOW : 0;
+    pulseMicros[head] = timestamp;
+    pulseSeconds[head] = second;
+    if (count < ALORA_PPS_WINDOW) {
+        count++;
+    }
+
+    fit();
+
+    return true;
+}
+
+/**
+ * @brief Check whether the model can convert timestamps
+ *
+ * @return true with two pulses and the last one within ALORA_PPS_HOLDOVER_S
+ */
+bool AloraPPS::isLocked() {
+    return count >= 2 && micros() - pulseMicros[head] < ALORA_PPS_HOLDOVER_S * 1000000UL;
+}
+
+/**
+ * @brief Convert a micros() timestamp to UTC
+ *
+ * @param timestamp micros() to convert
+ * @param time UTC time in microseconds since 1970 will be stored here
+ * @param error error estimate in microseconds will be stored here
+ * @return true if the model is locked
+ */
+bool AloraPPS::toTime(uint32_t timestamp, uint64_t& time, uint32_t& error) {
+    if (!isLocked()) {
+        return false;
+    }
+
+    double x = (int32_t) (timestamp - pulseMicros[head]);
+    double deviation = offset + slope * x;
+
+    time = pulseSeconds[head] * 1000000ULL + (int64_t) (x + deviation + (deviation >= 0.0 ? 0.5 : -0.5));
+
+    // uncertainty of the line at x, plus drift since the newest pulse
+    double spread = (x - meanX) * (x - meanX);
+    double lineVariance = variance + (sumXX > 0.0 ? spread * residual / sumXX : 0.0);
+    double holdover = x > 0.0 ? x * ALORA_PPS_HOLDOVER_PPM * 1e-6 : 0.0;
+
+    error = (uint32_t) (sqrt(lineVariance) + holdover + ALORA_PPS_ACCURACY_US + 0.5);
+
+    return true;
+}
+
+void ALORA_PPS_ISR_ATTR AloraPPS::onPulse() {
+    interruptMicros = micros();
+    interruptCount++;
+}
+
+/**
+ * @brief Least squares line through the pulse deviations from whole seconds,
+ * relative to the newest pulse
+ */
+void AloraPPS::fit() {
+    double x[ALORA_PPS_WINDOW];
+    double y[ALORA_PPS_WINDOW];
+    double sumX = 0.0;
+    double sumY = 0.0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t index = (head + ALORA_PPS_WINDOW - i) % ALORA_PPS_WINDOW;
+        x[i] = (int32_t) (pulseMicros[index] - pulseMicros[head]);
+        y[i] = -1e6 * (double) (pulseSeconds[head] - pulseSeconds[index]) - x[i];
+        sumX += x[i];
+        sumY += y[i];
+    }
+
+    meanX = sumX / count;
+    double meanY = sumY / count;
+    double sumXY = 0.0;
+    sumXX = 0.0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        sumXX += (x[i] - meanX) * (x[i] - meanX);
+        sumXY += (x[i] - meanX) * (y[i] - meanY);
+    }
+
+    slope = sumXX > 0.0 ? sumXY / sumXX : 0.0;
+    offset = meanY - slope * meanX;
+
+    double sumRR = 0.0;
+    for (uint8_t i = 0; i < count; i++) {
+        double r = y[i] - offset - slope * x[i];
+        sumRR += r * r;
+    }
+
+    // with few pulses assume the edge accuracy as residual
+    residual = count > 2 ? sumRR / (count - 2) : (double) ALORA_PPS_ACCURACY_US * ALORA_PPS_ACCURACY_US;
+    variance = residual / count;
+}
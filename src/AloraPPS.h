@@ -0,0 +1,87 @@
+/** @file */
+
+#ifndef ALORA_PPS_H
+#define ALORA_PPS_H
+
+#include <Arduino.h>
+
+/** Pin connected to the GPS pulse per second output, -1 if not wired */
+#if !defined(ALORA_GPS_PPS_PIN)
+    #define ALORA_GPS_PPS_PIN -1
+#endif
+
+/** Number of pulses the drift model is fitted over */
+#if !defined(ALORA_PPS_WINDOW)
+    #define ALORA_PPS_WINDOW 16
+#endif
+
+/** Largest deviation of a pulse from a whole number of seconds in microseconds, others are glitches */
+#if !defined(ALORA_PPS_MAX_JITTER_US)
+    #define ALORA_PPS_MAX_JITTER_US 1000
+#endif
+
+/** Accuracy of the pulse edge plus interrupt latency in microseconds, added to every error estimate */
+#if !defined(ALORA_PPS_ACCURACY_US)
+    #define ALORA_PPS_ACCURACY_US 5
+#endif
+
+/** Frequency stability of micros() in parts per million, grows the error after the last pulse */
+#if !defined(ALORA_PPS_HOLDOVER_PPM)
+    #define ALORA_PPS_HOLDOVER_PPM 2
+#endif
+
+/** Time in seconds after the last pulse the model stays locked */
+#if !defined(ALORA_PPS_HOLDOVER_S)
+    #define ALORA_PPS_HOLDOVER_S 60
+#endif
+
+/**
+ * @brief GPS pulse per second capture and drift model.
+ *
+ * The interrupt handler captures micros() on the rising edge of every pulse.
+ * The caller labels each pulse with its UTC second through addPulse(),
+ * usually from the GPS fix that follows it, as NMEA time refers to the
+ * preceding pulse. A label that disagrees with the pulses before it
+ * restarts the model, so a wrong one drops the lock. A straight line fitted
+ * over the last ALORA_PPS_WINDOW pulses maps micros() to UTC, so the offset
+ * and the frequency error of the CPU crystal are both modeled. The residual
+ * of the fit gives the error estimate of every conversion.
+ *
+ * Pulses are relative to the newest one in 32-bit micros(), so timestamps
+ * converted must lie within about 35 minutes of it.
+ */
+class AloraPPS {
+public:
+    AloraPPS();
+    ~AloraPPS();
+
+    bool begin(int8_t pin = ALORA_GPS_PPS_PIN);
+    void end();
+    void reset();
+    bool poll(uint32_t& timestamp);
+    bool addPulse(uint32_t timestamp, uint32_t second);
+    bool isLocked();
+    bool toTime(uint32_t timestamp, uint64_t& time, uint32_t& error);
+
+private:
+    int8_t pin;                             /**< PPS input pin, -1 if not attached */
+    uint32_t pulseMicros[ALORA_PPS_WINDOW]; /**< micros() of the pulses, ring indexed */
+    uint32_t pulseSeconds[ALORA_PPS_WINDOW]; /**< UTC second of the pulses since 1970 */
+    uint8_t head;                           /**< Ring index of the newest pulse */
+    uint8_t count;                          /**< Number of pulses in the ring */
+    double offset;                          /**< Model offset in us at the newest pulse */
+    double slope;                           /**< Model frequency error, UTC us per micros() us minus 1 */
+    double variance;                        /**< Variance of the offset at the window center in us^2 */
+    double meanX;                           /**< Mean pulse position relative to the newest in us */
+    double sumXX;                           /**< Sum of squared pulse deviations from meanX in us^2 */
+    double residual;                        /**< Variance of the fit residuals in us^2 */
+    uint32_t lastPulse;                     /**< Pulse count seen by the last poll() */
+
+    static volatile uint32_t interruptMicros; /**< micros() captured by the interrupt handler */
+    static volatile uint32_t interruptCount;  /**< Number of pulses seen by the interrupt handler */
+    static void onPulse();
+
+    void fit();
+};
+
+#endif
@@ -7,6 +7,58 @@
 
 #include "AloraSensorKit.h"
 
+#if defined(ESP32)
+    #include <esp_sleep.h>
+    #include <driver/gpio.h>
+    #include <driver/rtc_io.h>
+#endif
+
+#if !defined(RTC_DATA_ATTR)
+    #define RTC_DATA_ATTR
+#endif
+
+/** Resume state magic number, "ALRS" */
+#define ALORA_RESUME_MAGIC 0x53524C41UL
+
+/**
+ * State kept in RTC memory over deep sleep
+ */
+struct AloraResumeState {
+    uint32_t magic;         /**< ALORA_RESUME_MAGIC while deepSleepUntil() is sleeping */
+    uint8_t devices;        /**< ALORA_DEVICE_* bits not found missing since the last cold begin() */
+    bool powered;           /**< Whether the Alora rail stayed on during deep sleep */
+    uint8_t retained;       /**< ALORA_DEVICE_* bits whose driver configuration was kept for the powered resume */
+    uint8_t tslIntegration; /**< TSL2591 integration time before deep sleep */
+    uint8_t tslGain;        /**< TSL2591 gain before deep sleep */
+};
+
+RTC_DATA_ATTR static AloraResumeState resumeState;
+
+/** Devices compiled in, others are never initialized */
+static const uint8_t AVAILABLE_DEVICES = ALORA_DEVICE_RTC
+#if ALORA_USE_BME280_SENSOR
+    | ALORA_DEVICE_BME280
+#endif
+#if ALORA_USE_HDC1080_SENSOR
+    | ALORA_DEVICE_HDC1080
+#endif
+#if ALORA_USE_TSL2591_SENSOR
+    | ALORA_DEVICE_TSL2591
+#endif
+#if ALORA_USE_MAX11609
+    | ALORA_DEVICE_MAX11609
+#endif
+#if ALORA_USE_GPIO_EXPANDER
+    | ALORA_DEVICE_IO_EXPANDER
+#endif
+#if ALORA_USE_AIR_QUALITY_GAS_SENSOR && ALORA_SENSOR_USE_CCS811 == 1
+    | ALORA_DEVICE_CCS811
+#endif
+#if ALORA_USE_IMU_SENSOR
+    | ALORA_DEVICE_IMU
+#endif
+    ;
+
 /**
  * @brief Instantiate Alora board library object
  *
@@ -54,69 +106,304 @@ AloraSensorKit::~AloraSensorKit() {
     if (gps != NULL) {
         delete gps;
     }
+
+    if (gpsPower != NULL) {
+        delete gpsPower;
+    }
+
+    if (pps != NULL) {
+        delete pps;
+    }
+
+    if (gpsFusion != NULL) {
+        delete gpsFusion;
+    }
 }
 
 /**
- * Initialize Alora board and its sensors.
+ * Initialize Alora board and its sensors. Returns as soon as every active
+ * sensor answered on I2C or timed out, see beginAsync().
  */
 void AloraSensorKit::begin() {
+    beginAsync();
+
+    while (!pollBegin()) {
+        delay(1);
+    }
+}
+
+/**
+ * @brief Turn the Alora board on and start initializing the sensors without
+ * blocking. Each sensor is initialized by pollBegin() once it answers on
+ * I2C, a sensor that does not answer within ALORA_INIT_TIMEOUT_MS is
+ * skipped. Sensors left out by setActiveSensors() wait for their first
+ * access. After deepSleepUntil() only the devices found before are probed,
+ * and sensors that stayed powered are taken over without a reset.
+ */
+void AloraSensorKit::beginAsync() {
+    bool resume = false;
+
+#if defined(ESP32)
+    resume = resumeState.magic == ALORA_RESUME_MAGIC && esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_UNDEFINED;
+#endif
+
+    // a reset during initialization falls back to a cold start
+    resumeState.magic = 0;
+
+    if (!resume) {
+        resumeState.devices = ALORA_DEVICE_ALL;
+    }
+
+    initPowered = resume && resumeState.powered;
+
     pinMode(enablePin, OUTPUT);
     turnOn();
 
-    delay(1000);
+#if defined(ESP32)
+    // deep sleep held the enable pin, release it after driving the same level
+    gpio_hold_dis((gpio_num_t) enablePin);
+#endif
+
+    powerOnMs = millis();
+    expanderOnMs = powerOnMs;
+    initStarted = true;
+
+    Wire.begin();
 
     if (gps == NULL) {
         gps = new NMEAGPS();
     }
 
-    #if ALORA_USE_BME280_SENSOR
-    if (bme280 == NULL) {
-        Serial.println("[DEBUG] Initializing BME280");
-        bme280 = new Adafruit_BME280();
+    #if ALORA_USE_AIR_QUALITY_GAS_SENSOR && ALORA_SENSOR_USE_CCS811 != 1
+    pinMode(ALORA_ADC_GAS_HEATER_PIN, OUTPUT);
+    digitalWrite(ALORA_ADC_GAS_HEATER_PIN, HIGH);
+    #endif
+
+    pinMode(ALORA_MAGNETIC_SENSOR_PIN, INPUT);
 
-        if (!bme280->begin()) {
-            Serial.println("[ERROR] Failed to init BME280");
-            delete bme280;
-            bme280 = NULL;
+    requestDevices(activeDevices);
+}
+
+/**
+ * @brief Continue the initialization started by beginAsync(). Call it until
+ * it returns true, run() calls it as well. Every call probes all waiting
+ * sensors, each is skipped ALORA_INIT_TIMEOUT_MS after it was powered.
+ *
+ * @return true if no sensor waits for initialization
+ */
+bool AloraSensorKit::pollBegin() {
+    // every device waits on its own. Lowest bit first, so the RTC sets the clock before the
+    // sensors are read, and IMU and CCS811 wait until the IO expander powered them
+    for (uint8_t device = ALORA_DEVICE_RTC; device != 0; device <<= 1) {
+        bool expanderPowered = device & (ALORA_DEVICE_CCS811 | ALORA_DEVICE_IMU);
+
+        if (!(initPending & device) || (expanderPowered && (initPending & ALORA_DEVICE_IO_EXPANDER))) {
+            continue;
         }
+
+        Wire.beginTransmission(getDeviceAddress(device));
+        if (Wire.endTransmission() != 0) {
+            uint32_t poweredMs = expanderPowered ? expanderOnMs : powerOnMs;
+            if (millis() - poweredMs < ALORA_INIT_TIMEOUT_MS) {
+                continue;
+            }
+
+            ALORA_LOG_ERROR("[ERROR] No answer from I2C address 0x%02X\n", getDeviceAddress(device));
+            resumeState.devices &= ~device;
+        } else if (!initDevice(device)) {
+            resumeState.devices &= ~device;
+        }
+
+        initPending &= ~device;
     }
-    #endif
 
-    #if ALORA_USE_HDC1080_SENSOR
-    if (hdc1080 == NULL) {
-        Serial.println("[DEBUG] Initializing HDC1080");
-        hdc1080 = new ClosedCube_HDC1080();
-        hdc1080->begin(ALORA_HDC1080_ADDRESS);
+    return initPending == 0;
+}
+
+/**
+ * @brief Choose the sensors begin() initializes. The others are initialized
+ * on their first access, when they are added here later or when a getter
+ * like getIMUSensorAdapter() needs them. The RTC is always initialized.
+ *
+ * @param devices ALORA_DEVICE_* bits, ALORA_DEVICE_ALL by default
+ */
+void AloraSensorKit::setActiveSensors(uint8_t devices) {
+    activeDevices = devices;
+
+    if (initStarted) {
+        requestDevices(devices);
     }
-    #endif
+}
 
-    #if ALORA_USE_TSL2591_SENSOR
-    if (tsl2591 == NULL) {
-        Serial.println("[DEBUG] Initializing TSL2591");
-        tsl2591 = new Adafruit_TSL2591(2591);
-        if (!tsl2591->begin()) {
-            Serial.println("[ERROR] Failed to initialize TSL2591");
-            delete tsl2591;
-            tsl2591 = NULL;
-        } else {
-            configureTSL2591Sensor();
-        }
+/**
+ * Queue devices that are not initialized yet for pollBegin().
+ * @param devices ALORA_DEVICE_* bits.
+ */
+void AloraSensorKit::requestDevices(uint8_t devices) {
+    devices |= ALORA_DEVICE_RTC;
+
+    // IMU and CCS811 are powered through the IO expander
+    if (devices & (ALORA_DEVICE_CCS811 | ALORA_DEVICE_IMU)) {
+        devices |= ALORA_DEVICE_IO_EXPANDER;
     }
-    #endif
 
-    #if ALORA_USE_MAX11069
-    if (max11609 == NULL) {
-        Serial.println("[DEBUG] Initializing MAX11609");
-        max11609 = new MAX11609();
-        max11609->begin(AllAboutEE::MAX11609::REF_VDD);
+    uint8_t initialized = (rtc != NULL ? ALORA_DEVICE_RTC : 0)
+        | (bme280 != NULL ? ALORA_DEVICE_BME280 : 0)
+        | (hdc1080 != NULL ? ALORA_DEVICE_HDC1080 : 0)
+        | (tsl2591 != NULL ? ALORA_DEVICE_TSL2591 : 0)
+        | (max11609 != NULL ? ALORA_DEVICE_MAX11609 : 0)
+        | (ioExpander != NULL ? ALORA_DEVICE_IO_EXPANDER : 0)
+        | (ccs811 != NULL ? ALORA_DEVICE_CCS811 : 0)
+        | (imuSensor != NULL ? ALORA_DEVICE_IMU : 0);
+
+    initPending |= devices & AVAILABLE_DEVICES & resumeState.devices & ~initialized;
+}
+
+/**
+ * Initialize devices right away on their first access.
+ * @param devices ALORA_DEVICE_* bits.
+ */
+void AloraSensorKit::requireDevices(uint8_t devices) {
+    if (!initStarted) {
+        return;
     }
-    #endif
 
-    #if ALORA_USE_GPIO_EXPANDER
-    if (ioExpander == NULL) {
-        Serial.println("[DEBUG] Initializing IO Expander");
-        ioExpander = new GpioExpander();
-        if (ioExpander->begin()) {
+    requestDevices(devices);
+
+    while (!pollBegin()) {
+        delay(1);
+    }
+}
+
+/**
+ * Get the I2C address pollBegin() waits on for a device.
+ * @param device one ALORA_DEVICE_* bit.
+ * @return I2C address.
+ */
+uint8_t AloraSensorKit::getDeviceAddress(uint8_t device) {
+    switch (device) {
+        case ALORA_DEVICE_BME280:
+            return ALORA_I2C_ADDRESS_BME280;
+        case ALORA_DEVICE_HDC1080:
+            return ALORA_HDC1080_ADDRESS;
+        case ALORA_DEVICE_TSL2591:
+            return TSL2591_ADDR;
+        case ALORA_DEVICE_MAX11609:
+            return MAX11609::ADDRESS;
+        case ALORA_DEVICE_IO_EXPANDER:
+            return GPIOEXPANDER_ADDRESS;
+        case ALORA_DEVICE_CCS811:
+            return ALORA_I2C_ADDRESS_CCS811;
+        case ALORA_DEVICE_IMU:
+            return ALORA_I2C_ADDRESS_IMU_AG;
+        default:
+            return ALORA_I2C_ADDRESS_RTC;
+    }
+}
+
+/**
+ * Initialize a device that answered on I2C.
+ * @param device one ALORA_DEVICE_* bit.
+ * @return true on success.
+ */
+bool AloraSensorKit::initDevice(uint8_t device) {
+    switch (device) {
+        case ALORA_DEVICE_RTC:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing RTC\n");
+            rtc = new RTC_DS3231();
+            if (!rtc->begin()) {
+                ALORA_LOG_ERROR("[ERROR] Failed initializing RTC\n");
+                delete rtc;
+                rtc = NULL;
+
+                return false;
+            }
+
+            // release the INT line after an alarm wake-up
+            rtc->disableAlarm(1);
+            rtc->clearAlarm(1);
+
+            syncClockToRTC();
+
+            return true;
+
+        #if ALORA_USE_BME280_SENSOR
+        case ALORA_DEVICE_BME280:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing BME280\n");
+            bme280 = new Adafruit_BME280();
+
+            if (!bme280->begin()) {
+                ALORA_LOG_ERROR("[ERROR] Failed to init BME280\n");
+                delete bme280;
+                bme280 = NULL;
+
+                return false;
+            }
+
+            return true;
+        #endif
+
+        #if ALORA_USE_HDC1080_SENSOR
+        case ALORA_DEVICE_HDC1080:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing HDC1080\n");
+            hdc1080 = new ClosedCube_HDC1080();
+            hdc1080->begin(ALORA_HDC1080_ADDRESS);
+
+            return true;
+        #endif
+
+        #if ALORA_USE_TSL2591_SENSOR
+        case ALORA_DEVICE_TSL2591:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing TSL2591\n");
+            tsl2591 = new Adafruit_TSL2591(2591);
+            if (initPowered && (resumeState.retained & ALORA_DEVICE_TSL2591)) {
+                // a powered TSL2591 keeps its integration time and gain
+                tsl2591->resume((tsl2591IntegrationTime_t) resumeState.tslIntegration, (tsl2591Gain_t) resumeState.tslGain);
+
+                return true;
+            }
+
+            if (!tsl2591->begin()) {
+                ALORA_LOG_ERROR("[ERROR] Failed to initialize TSL2591\n");
+                delete tsl2591;
+                tsl2591 = NULL;
+
+                return false;
+            }
+
+            configureTSL2591Sensor();
+
+            return true;
+        #endif
+
+        #if ALORA_USE_MAX11609
+        case ALORA_DEVICE_MAX11609:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing MAX11609\n");
+            max11609 = new MAX11609();
+            max11609->begin(AllAboutEE::MAX11609::REF_VDD);
+
+            return true;
+        #endif
+
+        #if ALORA_USE_GPIO_EXPANDER
+        case ALORA_DEVICE_IO_EXPANDER:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing IO Expander\n");
+            ioExpander = new GpioExpander();
+            if (initPowered) {
+                // begin() resets the outputs, which cuts IMU and CCS811 power
+                ioExpander->resume();
+
+                return true;
+            }
+
+            if (!ioExpander->begin()) {
+                ALORA_LOG_ERROR("[ERROR] Failed to initialize SX1509 IO Expander\n");
+                delete ioExpander;
+                ioExpander = NULL;
+
+                return false;
+            }
+
             ioExpander->pinMode(4, OUTPUT);
             ioExpander->digitalWrite(4, HIGH);
 
@@ -131,62 +418,56 @@ void AloraSensorKit::begin() {
             // wake CCS
             ioExpander->pinMode(0, OUTPUT);
             ioExpander->digitalWrite(0, this->ccs811WakeLogic);
-        } else {
-            Serial.println("[ERROR] Failed to initialize SX1509 IO Expander");
-            delete ioExpander;
-            ioExpander = NULL;
-        }
-    }
-    #endif
 
+            // IMU and CCS811 start powering up now
+            expanderOnMs = millis();
 
-    #if ALORA_USE_AIR_QUALITY_GAS_SENSOR
-    #if ALORA_SENSOR_USE_CCS811 == 1
-        if (ccs811 == NULL) {
-            Serial.println("[DEBUG] Initializing CCS811");
+            return true;
+        #endif
+
+        #if ALORA_USE_AIR_QUALITY_GAS_SENSOR && ALORA_SENSOR_USE_CCS811 == 1
+        case ALORA_DEVICE_CCS811: {
+            ALORA_LOG_DEBUG("[DEBUG] Initializing CCS811\n");
             ccs811 = new CCS811(ALORA_I2C_ADDRESS_CCS811);
 
-            CCS811Core::status returnCode = ccs811->begin();
+            // a powered CCS811 keeps running its algorithm and baseline, begin() would reset it
+            CCS811Core::status returnCode = initPowered ? CCS811Core::SENSOR_SUCCESS : ccs811->begin();
             if (returnCode != CCS811Core::SENSOR_SUCCESS) {
-                Serial.println("[ERROR] CCS811 .begin() returned with an error.");
-                Serial.printf("[ERROR] CCS811 Init return code %d\n",  returnCode);
-
+                ALORA_LOG_ERROR("[ERROR] CCS811 Init return code %d\n", returnCode);
                 delete ccs811;
                 ccs811 = NULL;
-            } else {
-                Serial.printf("[DEBUG] CCS811 Init return code %d\n",  returnCode);
+
+                return false;
             }
+
+            return true;
         }
-    #else
-        pinMode(ALORA_ADC_GAS_HEATER_PIN, OUTPUT);
-        digitalWrite(ALORA_ADC_GAS_HEATER_PIN, HIGH);
-    #endif
-    #endif
+        #endif
 
-    #if ALORA_USE_IMU_SENSOR
-    if (imuSensor == NULL) {
-        Serial.println("[DEBUG] Initializing IMU sensor");
-        imuSensor = new ALORA_IMU_SENSOR();
+        #if ALORA_USE_IMU_SENSOR
+        case ALORA_DEVICE_IMU:
+            ALORA_LOG_DEBUG("[DEBUG] Initializing IMU sensor\n");
+            imuSensor = new ALORA_IMU_SENSOR();
 
-        if (!imuSensor->begin(ALORA_I2C_ADDRESS_IMU_AG, ALORA_I2C_ADDRESS_IMU_M)) {
-            Serial.println("[ERROR] Failed initializing IMU sensor");
-            delete imuSensor;
-            imuSensor = NULL;
-        }
-    }
-    #endif
+            // a powered IMU keeps its configuration, take it over without the reset of begin()
+            if (initPowered && (resumeState.retained & ALORA_DEVICE_IMU) && imuSensor->resume(ALORA_I2C_ADDRESS_IMU_AG, ALORA_I2C_ADDRESS_IMU_M)) {
+                return true;
+            }
 
-    if (rtc == NULL) {
-        Serial.println("[DEBUG] Initializing RTC");
-        rtc = new RTC_DS3231();
-        if (!rtc->begin()) {
-            Serial.println("[ERROR] Failed initializing RTC");
-            delete rtc;
-            rtc = NULL;
-        }
-    }
+            if (!imuSensor->begin(ALORA_I2C_ADDRESS_IMU_AG, ALORA_I2C_ADDRESS_IMU_M)) {
+                ALORA_LOG_ERROR("[ERROR] Failed initializing IMU sensor\n");
+                delete imuSensor;
+                imuSensor = NULL;
 
-    pinMode(ALORA_MAGNETIC_SENSOR_PIN, INPUT);
+                return false;
+            }
+
+            return true;
+        #endif
+
+        default:
+            return false;
+    }
 }
 
 /**
@@ -194,6 +475,30 @@ void AloraSensorKit::begin() {
  * This function is usually called inside loop() function.
  */
 void AloraSensorKit::run() {
+    if (initStarted) {
+        requestDevices(activeDevices);
+        pollBegin();
+    }
+
+    updateClock();
+
+    if (imuSensor != NULL) {
+        imuSensor->update();
+    }
+
+    // position filter, geofence and GPS duty cycle need every fix as soon as it arrives
+    if (gpsFusion != NULL) {
+        feedGPSFusion();
+    }
+
+    if (gpsPower != NULL) {
+        updateGPSPower();
+    }
+
+    if (gpsFusion != NULL || geofence != NULL || gpsPower != NULL) {
+        readGPS(lastSensorData.gpsFix);
+    }
+
     doAllSensing();
 }
 
@@ -258,6 +563,11 @@ void AloraSensorKit::printSensingTo(String& str) {
     char magPayloadStr[64];
     sprintf(magPayloadStr, "[MAG] X = %s\tY = %s\tZ = %s\tHd = %s Deg\r\n", xStr, yStr, zStr, magHeadingStr);
 
+    dtostrf(lastSensorData.roll, 6, 2, xStr);
+    dtostrf(lastSensorData.pitch, 6, 2, yStr);
+    char orientationPayloadStr[64];
+    sprintf(orientationPayloadStr, "[ORIENTATION] Roll = %s Deg\tPitch = %s Deg\r\n", xStr, yStr);
+
     char magnetic[2];
     sprintf(magnetic, "%d", lastSensorData.magnetic);
     char magneticPayloadStr[40];
@@ -269,7 +579,7 @@ void AloraSensorKit::printSensingTo(String& str) {
     sprintf(windPayloadStr, "[WIND SPEED] Speed = %s MPH", windSpeedStr);
 
     str = String(bme280PayloadStr) + String(hdcPayloadStr) + String(gasPayloadStr);
-    str += String(accelPayloadStr) + String(gyroPayloadStr) + String(magPayloadStr);
+    str += String(accelPayloadStr) + String(gyroPayloadStr) + String(magPayloadStr) + String(orientationPayloadStr);
     str += String(lightPayloadStr) + String(magneticPayloadStr) + String(windPayloadStr);
 }
 
@@ -332,9 +642,7 @@ void AloraSensorKit::readAccelerometer(float &ax, float &ay, float &az) {
         return;
     }
 
-    ax = imuSensor->readAccelX();
-    ay = imuSensor->readAccelY();
-    az = imuSensor->readAccelZ();
+    imuSensor->readAccel(ax, ay, az);
 }
 
 /**
@@ -352,9 +660,7 @@ void AloraSensorKit::readGyro(float &gx, float &gy, float &gz) {
         return;
     }
 
-    gx = imuSensor->readGyroX();
-    gy = imuSensor->readGyroY();
-    gz = imuSensor->readGyroZ();
+    imuSensor->readGyro(gx, gy, gz);
 }
 
 
@@ -375,12 +681,60 @@ void AloraSensorKit::readMagnetometer(float &mx, float &my, float &mz, float &mH
         return;
     }
 
-    mx = imuSensor->readMagX();
-    my = imuSensor->readMagY();
-    mz = imuSensor->readMagZ();
+    imuSensor->readMag(mx, my, mz);
     mH = imuSensor->readMagHeading();
 }
 
+/**
+ * Read orientation from the IMU orientation filter.
+ * @param roll roll angle in degrees will be stored in this variable.
+ * @param pitch pitch angle in degrees will be stored in this variable.
+ */
+void AloraSensorKit::readOrientation(float &roll, float &pitch) {
+    if (imuSensor == NULL) {
+        roll = 0.0;
+        pitch = 0.0;
+
+        return;
+    }
+
+    roll = imuSensor->readRoll();
+    pitch = imuSensor->readPitch();
+}
+
+/**
+ * Read full scale ranges of the IMU.
+ * @param accelRange accelerometer full scale in g will be stored in this variable.
+ * @param gyroRange gyroscope full scale in degrees per second will be stored in this variable.
+ * @param changed whether the range changed since the previous call will be stored in this variable.
+ */
+void AloraSensorKit::readIMURange(uint16_t &accelRange, uint16_t &gyroRange, bool &changed) {
+    if (imuSensor == NULL) {
+        accelRange = 0;
+        gyroRange = 0;
+        changed = false;
+
+        return;
+    }
+
+    accelRange = imuSensor->getAccelRange();
+    gyroRange = imuSensor->getGyroRange();
+
+    uint16_t changeCount = imuSensor->getRangeChangeCount();
+    changed = changeCount != lastImuRangeChangeCount;
+    lastImuRangeChangeCount = changeCount;
+}
+
+/**
+ * Read features of the last vibration spectrum computed from IMU FIFO batches.
+ * @param features vibration features will be stored in this variable, all zero if no spectrum is available.
+ */
+void AloraSensorKit::readVibration(AloraVibrationFeatures &features) {
+    if (imuSensor == NULL || !imuSensor->readVibration(features)) {
+        memset(&features, 0, sizeof(features));
+    }
+}
+
 /**
  * Read data from BME280 sensor.
  * @param T temperature reading will be stored in this variable.
@@ -454,6 +808,7 @@ void AloraSensorKit::configureTSL2591Sensor() {
     // tsl.setTiming(TSL2591_INTEGRATIONTIME_500MS);
     // tsl.setTiming(TSL2591_INTEGRATIONTIME_600MS);  // longest integration time (dim light)
 
+    #if ALORA_DEBUG >= 2
     /* Display the gain and integration time for reference sake */
     Serial.println(F("------------------------------------"));
     Serial.print  (F("Gain:         "));
@@ -478,6 +833,7 @@ void AloraSensorKit::configureTSL2591Sensor() {
     Serial.println(F(" ms"));
     Serial.println(F("------------------------------------"));
     Serial.println(F(""));
+    #endif
 }
 
 /**
@@ -534,6 +890,7 @@ void AloraSensorKit::doAllSensing() {
     }
 
     lastSensorQuerryMs = millis();
+    getTimestamp(micros(), lastSensorData.timestamp, lastSensorData.timestampError);
 
     float T1, P, H1;
     readBME280(T1, P, H1);
@@ -556,6 +913,27 @@ void AloraSensorKit::doAllSensing() {
     lastSensorData.gas = gas;
     lastSensorData.co2 = co2;
 
+    // motion gating holds the IMU idle, keep the last motion values
+    if (imuSensor == NULL || !imuSensor->isMotionIdle()) {
+        readIMU();
+    }
+
+    int mag;
+    readMagneticSensor(mag);
+    lastSensorData.magnetic = mag;
+
+    float windspeed;
+    readWindSpeed(windspeed);
+    lastSensorData.windSpeed = windspeed;
+
+    readGPS(lastSensorData.gpsFix);
+}
+
+/**
+ * Read accelerometer, gyroscope, magnetometer, orientation and range of the IMU
+ * into lastSensorData.
+ */
+void AloraSensorKit::readIMU() {
     float X, Y, Z;
     readAccelerometer(X, Y, Z);
     lastSensorData.accelX = X;
@@ -575,22 +953,30 @@ void AloraSensorKit::doAllSensing() {
     lastSensorData.magZ = mZ;
     lastSensorData.magHeading = mH;
 
-    int mag;
-    readMagneticSensor(mag);
-    lastSensorData.magnetic = mag;
+    float roll, pitch;
+    readOrientation(roll, pitch);
+    lastSensorData.roll = roll;
+    lastSensorData.pitch = pitch;
 
-    float windspeed;
-    readWindSpeed(windspeed);
-    lastSensorData.windSpeed = windspeed;
+    readIMURange(lastSensorData.accelRange, lastSensorData.gyroRange, lastSensorData.imuRangeChanged);
+    readVibration(lastSensorData.vibration);
 
-    readGPS(lastSensorData.gpsFix);
+    uint32_t error;
+    if (lastSensorData.vibration.timestamp == 0 || !getTimestamp(lastSensorData.vibration.timestamp, lastSensorData.vibrationTimestamp, error)) {
+        lastSensorData.vibrationTimestamp = 0;
+    }
 }
 
 /**
- * Get current time from RTC.
+ * Get current time from the software clock, without a bus transaction. Falls
+ * back to the RTC while the clock is not set.
  * @return DateTime object of current time.
  */
 DateTime AloraSensorKit::getDateTime() {
+    if (softClock.isSet()) {
+        return DateTime((uint32_t) (softClock.now() / 1000000ULL));
+    }
+
     if (rtc == NULL) {
         return DateTime();
     }
@@ -598,6 +984,268 @@ DateTime AloraSensorKit::getDateTime() {
     return rtc->now();
 }
 
+/**
+ * @brief Get UTC time with microsecond resolution from the software clock
+ *
+ * @param timestamp micros() to convert, for example of an IMU sample, 0 for now
+ * @return uint64_t microseconds since 1970, 0 if neither RTC nor GPS set the clock
+ */
+uint64_t AloraSensorKit::getTimestamp(uint32_t timestamp) {
+    return timestamp != 0 ? softClock.toTime(timestamp) : softClock.now();
+}
+
+/**
+ * @brief Get UTC time of a micros() timestamp with its error estimate. The
+ * PPS drift model is used while it is locked, the software clock otherwise.
+ *
+ * @param timestamp micros() to convert, at most about 35 minutes old
+ * @param time microseconds since 1970 will be stored here, 0 if the clock is not set
+ * @param error error estimate in microseconds will be stored here
+ * @return true if the time is valid
+ */
+bool AloraSensorKit::getTimestamp(uint32_t timestamp, uint64_t& time, uint32_t& error) {
+    if (pps != NULL && pps->toTime(timestamp, time, error)) {
+        return true;
+    }
+
+    time = softClock.toTime(timestamp);
+    error = softClock.getError(timestamp);
+
+    return softClock.isSet();
+}
+
+/**
+ * @brief Discipline timestamps with the GPS pulse per second on
+ * ALORA_GPS_PPS_PIN. Every pulse is labeled with the time of the GPS fix
+ * that follows it and feeds the drift model, which steers the software
+ * clock, so timestamps across boards agree within a few microseconds.
+ *
+ * @param enable true to use the PPS input
+ * @return true if PPS is enabled, false if disabled or ALORA_GPS_PPS_PIN is not set
+ */
+bool AloraSensorKit::enablePPS(bool enable) {
+    if (enable && pps == NULL) {
+        pps = new AloraPPS();
+        ppsPulsePending = false;
+
+        if (!pps->begin(ALORA_GPS_PPS_PIN)) {
+            delete pps;
+            pps = NULL;
+        }
+    } else if (!enable && pps != NULL) {
+        delete pps;
+        pps = NULL;
+    }
+
+    return pps != NULL;
+}
+
+/**
+ * @brief Turn the Alora rail off and deep-sleep until a deadline. The DS3231
+ * alarm on the interrupt pin wakes the board on time. The ESP32 timer is the
+ * fallback, and it is also the only source without the pin. Its RC clock is
+ * off by a few percent, so timer wake-ups drift. On ESP32 the board restarts
+ * through setup() after wake-up, so begin() runs again.
+ *
+ * With keepPowered the rail stays on and only the GPS is switched off. The
+ * sensors keep drawing their idle current, but begin() takes them over
+ * without the power-up delay and CCS811 keeps its warm-up and baseline. The
+ * IMU and TSL2591 configuration is kept in RTC memory, so they are attached
+ * without a reset or register rewrite.
+ *
+ * @param deadline UTC seconds since 1970, for example from AloraSleepScheduler::getNextDeadline()
+ * @param interruptPin RTC GPIO connected to the DS3231 INT/SQW output, -1 for timer wake-up only
+ * @param keepPowered true to leave the Alora rail on during deep sleep
+ * @return false if the clock is not set or the deadline is closer than ALORA_SLEEP_MIN_S.
+ * Other targets wait awake with the rail off and return true
+ */
+bool AloraSensorKit::deepSleepUntil(uint32_t deadline, int8_t interruptPin, bool keepPowered) {
+    uint64_t now = getTimestamp();
+
+    if (now == 0 || deadline * 1000000ULL < now + ALORA_SLEEP_MIN_S * 1000000ULL) {
+        return false;
+    }
+
+    uint64_t sleepMicros = deadline * 1000000ULL - now;
+    bool alarm = interruptPin >= 0 && setRTCAlarm(deadline);
+
+#if !defined(ESP32)
+    // restored after the wait, ESP32 restarts through setup() instead
+    bool gpsWasOn = gpsOn;
+#endif
+
+    if (keepPowered) {
+        setGPSPower(false);
+    } else {
+        turnOff();
+    }
+
+#if defined(ESP32)
+    resumeState.magic = ALORA_RESUME_MAGIC;
+    resumeState.powered = keepPowered;
+
+    // drivers set up before the sleep are taken over without a reset
+    resumeState.retained = 0;
+
+    if (keepPowered && imuSensor != NULL) {
+        imuSensor->retain();
+        resumeState.retained |= ALORA_DEVICE_IMU;
+    }
+
+    if (keepPowered && tsl2591 != NULL) {
+        resumeState.tslIntegration = tsl2591->getTiming();
+        resumeState.tslGain = tsl2591->getGain();
+        resumeState.retained |= ALORA_DEVICE_TSL2591;
+    }
+
+    gpio_hold_en((gpio_num_t) enablePin);
+    gpio_deep_sleep_hold_en();
+
+    if (alarm) {
+        // the INT pull-up is on the rail, which is off now
+        rtc_gpio_pullup_en((gpio_num_t) interruptPin);
+        rtc_gpio_pulldown_dis((gpio_num_t) interruptPin);
+        esp_sleep_enable_ext0_wakeup((gpio_num_t) interruptPin, 0);
+
+        // backup only, leave room for the RC clock running fast
+        sleepMicros += sleepMicros / 8 + ALORA_SLEEP_MIN_S * 1000000ULL;
+    }
+
+    esp_sleep_enable_timer_wakeup(sleepMicros);
+    esp_deep_sleep_start();
+#else
+    (void) alarm;
+    delay(sleepMicros / 1000);
+
+    if (keepPowered) {
+        setGPSPower(gpsWasOn);
+    } else {
+        turnOn();
+    }
+#endif
+
+    return true;
+}
+
+/**
+ * Program DS3231 alarm 1 for a deadline and keep its INT output working on
+ * the backup battery.
+ * @param deadline UTC seconds since 1970.
+ * @return true if the alarm is set.
+ */
+bool AloraSensorKit::setRTCAlarm(uint32_t deadline) {
+    if (rtc == NULL || rtc->lostPower()) {
+        return false;
+    }
+
+    rtc->clearAlarm(1);
+    rtc->writeSqwPinMode(DS3231_OFF);
+    if (!rtc->setAlarm1(DateTime(deadline), DS3231_A1_Date)) {
+        return false;
+    }
+
+    // BBSQW in the control register, RTClib does not expose it
+    Wire.beginTransmission(ALORA_I2C_ADDRESS_RTC);
+    Wire.write(0x0E);
+    Wire.endTransmission();
+    Wire.requestFrom(ALORA_I2C_ADDRESS_RTC, 1);
+    uint8_t control = Wire.read();
+
+    Wire.beginTransmission(ALORA_I2C_ADDRESS_RTC);
+    Wire.write(0x0E);
+    Wire.write(control | 0x40);
+
+    return Wire.endTransmission() == 0;
+}
+
+/**
+ * Check for a new PPS pulse. The pulse waits for the following fix, whose
+ * time labels it. A pulse no fix labeled before the next one arrived is
+ * counted on from the drift model while it is locked.
+ */
+void AloraSensorKit::updatePPS() {
+    uint32_t timestamp;
+
+    if (!pps->poll(timestamp)) {
+        return;
+    }
+
+    uint64_t time;
+    uint32_t error;
+
+    if (ppsPulsePending && pps->toTime(ppsPulseMicros, time, error)) {
+        addPPSPulse(ppsPulseMicros, (time + 500000ULL) / 1000000ULL);
+    }
+
+    ppsPulseMicros = timestamp;
+    ppsPulsePending = true;
+}
+
+/**
+ * Feed a labeled PPS pulse to the drift model and the software clock.
+ * @param timestamp micros() of the pulse.
+ * @param second UTC second the pulse starts, since 1970.
+ */
+void AloraSensorKit::addPPSPulse(uint32_t timestamp, uint32_t second) {
+    ppsPulsePending = false;
+
+    if (pps->addPulse(timestamp, second) && pps->isLocked()) {
+        softClock.correct(second * 1000000ULL, timestamp);
+        lastClockGPSMs = millis();
+        hasClockGPS = true;
+    }
+}
+
+/**
+ * Set the software clock from the RTC. The RTC counts whole seconds, so only
+ * errors beyond half a second are corrected.
+ */
+void AloraSensorKit::syncClockToRTC() {
+    lastClockRTCMs = millis();
+
+    if (rtc == NULL || rtc->lostPower()) {
+        return;
+    }
+
+    // the RTC second started somewhere in the last second, assume the middle
+    softClock.correct(rtc->now().unixtime() * 1000000ULL + 500000, micros(), 500000);
+}
+
+/**
+ * Check the software clock against the RTC periodically. While GPS time
+ * disciplines the clock, the RTC is set from the clock instead, so it keeps
+ * GPS time for the next boot.
+ */
+void AloraSensorKit::updateClock() {
+    softClock.now();
+
+    if (pps != NULL) {
+        updatePPS();
+    }
+
+    if (millis() - lastClockRTCMs < ALORA_CLOCK_RTC_INTERVAL_S * 1000UL) {
+        return;
+    }
+
+    if (!hasClockGPS || millis() - lastClockGPSMs >= ALORA_CLOCK_RTC_INTERVAL_S * 1000UL) {
+        syncClockToRTC();
+        return;
+    }
+
+    lastClockRTCMs = millis();
+
+    if (rtc == NULL) {
+        return;
+    }
+
+    uint32_t seconds = (softClock.now() + 500000) / 1000000ULL;
+    int32_t difference = (int32_t) (rtc->now().unixtime() - seconds);
+
+    if (difference != 0) {
+        rtc->adjust(DateTime(seconds));
+    }
+}
+
 /**
  * Get latest sensor data from Alora board.
  * @return object of SensorValues struct
@@ -612,6 +1260,8 @@ SensorValues& AloraSensorKit::getLastSensorData() {
  * @return read value
  */
 uint16_t AloraSensorKit::readADC(uint8_t channel) {
+    requireDevices(ALORA_DEVICE_MAX11609);
+
     if (max11609 == NULL) {
         return 0;
     }
@@ -620,29 +1270,389 @@ uint16_t AloraSensorKit::readADC(uint8_t channel) {
 }
 
 /**
- * Initialize GPS
+ * Initialize GPS. The last saved fix and the RTC time are sent to the receiver
+ * as soon as it talks, which turns the cold start into a warm one.
  */
 void AloraSensorKit::initGPS(Stream* gpsStream) {
     this->gpsStream = gpsStream;
+    requireDevices(ALORA_DEVICE_IO_EXPANDER);
+
     if (ioExpander != NULL) {
         ioExpander->pinMode(ALORA_GPS_ENABLE_PIN, OUTPUT);
-        ioExpander->pinMode(ALORA_GPS_ENABLE_PIN, HIGH);
     }
+
+    hasGPSAidingFix = AloraGPSAidingStore::load(gpsAidingFix);
+
+    if (ioExpander == NULL) {
+        // without the expander the receiver is powered with the board
+        gpsOn = true;
+        gpsAidingPending = true;
+    }
+
+    setGPSPower(true);
 }
 
 /**
- * Read GPS location data
+ * Switch the GPS receiver through its enable pin on the GPIO expander.
+ * Every power-up sends aiding data again. A receiver set up by
+ * configureGPS() starts at its power-up baud rate with every sentence on, so
+ * the UART goes back to that rate and the configuration is sent again once
+ * the receiver talks. Without the expander nothing is switched and the power
+ * state is left as it is.
+ * @param on true to power the receiver.
  */
-void AloraSensorKit::readGPS(gps_fix& fix) {
-    if (gpsStream == NULL || gps == NULL) {
+void AloraSensorKit::setGPSPower(bool on) {
+    // nothing to switch, the receiver keeps its state
+    if (ioExpander == NULL) {
         return;
     }
 
+    ioExpander->digitalWrite(ALORA_GPS_ENABLE_PIN, on ? HIGH : LOW);
+
+    if (on && !gpsOn) {
+        gpsAidingPending = true;
+
+        if (gpsConfigSerial != NULL) {
+            gpsConfigSerial->updateBaudRate(gpsPowerUpBaud);
+            gpsConfigPending = true;
+        }
+    }
+
+    gpsOn = on;
+}
+
+/**
+ * Advance the GPS duty cycle and switch the receiver when it asks for it.
+ */
+void AloraSensorKit::updateGPSPower() {
+    // without motion gating the IMU never reports idle, the board counts as moving
+    bool moving = imuSensor == NULL || !imuSensor->isMotionIdle();
+
+    bool on = gpsPower->update(millis(), moving);
+    if (on != gpsOn) {
+        setGPSPower(on);
+    }
+}
+
+/**
+ * @brief Configure the GPS receiver for fast, lean output: only GGA and RMC
+ * sentences, ALORA_GPS_BAUD and a shorter fix interval. The UART is switched
+ * to the new baud rate. Call it after begin() and initGPS(), with the UART
+ * open at the rate the receiver powered up with. The settings are sent
+ * again after every power-up by the GPS power management or deep sleep.
+ *
+ * @param gpsSerial UART of the receiver, replaces the stream given to initGPS()
+ * @param baud new baud rate, 0 keeps the current one
+ * @param fixIntervalMs time between two fixes in milliseconds
+ * @return true if the receiver answered at the new baud rate. On false the UART is back at the old rate
+ */
+bool AloraSensorKit::configureGPS(HardwareSerial* gpsSerial, uint32_t baud, uint16_t fixIntervalMs) {
+    if (gpsSerial == NULL || gps == NULL) {
+        return false;
+    }
+
+    gpsStream = gpsSerial;
+    AloraGPSConfig::setSentences(*gpsSerial, ALORA_GPS_MODULE);
+
+    uint32_t oldBaud = gpsSerial->baudRate();
+
+    // kept for the next power-up
+    if (gpsConfigSerial != gpsSerial) {
+        gpsConfigSerial = gpsSerial;
+        gpsPowerUpBaud = oldBaud;
+    }
+    gpsConfigBaud = baud;
+    gpsConfigIntervalMs = fixIntervalMs;
+    gpsConfigPending = false;
+
+    if (baud != 0 && baud != oldBaud) {
+        AloraGPSConfig::setBaudRate(*gpsSerial, ALORA_GPS_MODULE, baud);
+
+        // the receiver switches after the command left the UART
+        gpsSerial->flush();
+        delay(50);
+        gpsSerial->updateBaudRate(baud);
+
+        if (!waitForGPSSentence(ALORA_GPS_CONFIG_TIMEOUT_MS)) {
+            gpsSerial->updateBaudRate(oldBaud);
+            return false;
+        }
+    }
+
+    AloraGPSConfig::setFixInterval(*gpsSerial, ALORA_GPS_MODULE, fixIntervalMs);
+
+    return true;
+}
+
+/**
+ * Wait until NeoGPS parses a complete interval of sentences from the GPS stream.
+ * @param timeoutMs longest wait in milliseconds.
+ * @return true if sentences arrived in time.
+ */
+bool AloraSensorKit::waitForGPSSentence(uint32_t timeoutMs) {
+    uint32_t start = millis();
+
+    while (millis() - start < timeoutMs) {
+        if (gps->available(*gpsStream)) {
+            lastSensorData.gpsFix = gps->read();
+            gpsSentenceStarted = false;
+            return true;
+        }
+
+        delay(1);
+    }
+
+    return false;
+}
+
+/**
+ * Read GPS location data. A new fix also corrects the GPS and IMU position filter
+ * and updates the geofence.
+ * @param fix latest GPS fix will be stored in this variable.
+ * @return true if a new fix was read.
+ */
+bool AloraSensorKit::readGPS(gps_fix& fix) {
+    if (gpsStream == NULL || gps == NULL) {
+        return false;
+    }
+
+    // time the interval by its first character, parsing the rest takes a while
+    uint32_t pollMicros = micros();
+    if (!gpsSentenceStarted && gpsStream->available() > 0) {
+        gpsSentenceMicros = pollMicros;
+        gpsSentenceDelay = pollMicros - gpsPollMicros;
+        gpsSentenceStarted = true;
+    }
+    gpsPollMicros = pollMicros;
+
+    bool received = false;
     while (gps->available(*gpsStream)) {
         fix = gps->read();
+        received = true;
+    }
+
+    uint32_t timestamp = gpsSentenceStarted ? gpsSentenceMicros : pollMicros;
+    uint32_t waited = gpsSentenceStarted ? gpsSentenceDelay : 0;
+
+    if (received) {
+        gpsSentenceStarted = false;
+    }
+
+    // a pulse that arrived before these sentences belongs to them
+    if (received && pps != NULL) {
+        updatePPS();
+    }
+
+    // receivers report their own guess of the time before the first fix, wait for a real one
+    if (received && fix.valid.date && fix.valid.time && fix.valid.status && fix.status >= gps_fix::STATUS_STD) {
+        const NeoGPS::time_t& dt = fix.dateTime;
+        uint32_t seconds = DateTime(2000 + dt.year, dt.month, dt.date, dt.hours, dt.minutes, dt.seconds).unixtime();
+
+        // NMEA time refers to the pulse preceding the sentences within the second
+        if (ppsPulsePending && fix.dateTime_cs == 0 && timestamp - ppsPulseMicros < 1000000UL) {
+            addPPSPulse(ppsPulseMicros, seconds);
+        }
+
+        // with PPS locked the sentence arrival time is far too coarse to use. Otherwise the
+        // sentences follow the epoch by up to the output latency, plus the poll interval until
+        // they were seen. Assume the middle and correct only beyond that, so the frequency is
+        // not trained on the latency scatter
+        if (pps == NULL || !pps->isLocked()) {
+            uint32_t uncertainty = (ALORA_CLOCK_NMEA_LATENCY_US + waited) / 2;
+            uint64_t epoch = seconds * 1000000ULL + fix.dateTime_cs * 10000UL;
+
+            softClock.correct(epoch + uncertainty, timestamp, uncertainty);
+            lastClockGPSMs = millis();
+            hasClockGPS = true;
+        }
+    }
+
+    if (received && gpsFusion != NULL) {
+        gpsFusion->correct(fix, timestamp);
+    }
+
+    if (received && geofence != NULL) {
+        geofence->update(fix);
+    }
+
+    if (received && gpsPower != NULL && gpsPower->onFix(fix, millis())) {
+        setGPSPower(false);
+    }
+
+    if (received && fix.valid.location) {
+        saveGPSAidingFix(fix);
+    }
+
+    // the receiver is up once it sends sentences
+    if (received && gpsOn && gpsConfigPending) {
+        configureGPS(gpsConfigSerial, gpsConfigBaud, gpsConfigIntervalMs);
+    }
+
+    if (received && gpsAidingPending) {
+        sendGPSAiding();
+    }
+
+    return received;
+}
+
+/**
+ * Send the last saved fix and the RTC time to the GPS receiver.
+ */
+void AloraSensorKit::sendGPSAiding() {
+    gpsAidingPending = false;
+
+    uint32_t utc = getUTCTime();
+    if (utc == 0 && !hasGPSAidingFix) {
+        return;
+    }
+
+    AloraGPSConfig::sendAiding(*gpsStream, ALORA_GPS_MODULE, hasGPSAidingFix ? &gpsAidingFix : NULL, utc);
+}
+
+/**
+ * Save a fix for GPS aiding when it moved or aged enough since the saved one.
+ * This keeps NVS writes rare.
+ * @param fix fix with a valid location.
+ */
+void AloraSensorKit::saveGPSAidingFix(const gps_fix& fix) {
+    uint32_t time = getUTCTime();
+    if (fix.valid.date && fix.valid.time) {
+        const NeoGPS::time_t& dt = fix.dateTime;
+        time = DateTime(2000 + dt.year, dt.month, dt.date, dt.hours, dt.minutes, dt.seconds).unixtime();
+    }
+
+    if (hasGPSAidingFix) {
+        // 10^-7 degree of latitude is about 1.1 cm, longitude is never longer
+        uint32_t latitudeDelta = llabs((int64_t) fix.latitudeL() - gpsAidingFix.latitudeL);
+        uint32_t longitudeDelta = llabs((int64_t) fix.longitudeL() - gpsAidingFix.longitudeL);
+        uint32_t distance = (latitudeDelta > longitudeDelta ? latitudeDelta : longitudeDelta) / 90;
+
+        if (distance < ALORA_GPS_AIDING_SAVE_DISTANCE_M && time - gpsAidingFix.time < ALORA_GPS_AIDING_SAVE_INTERVAL_S) {
+            return;
+        }
+    }
+
+    gpsAidingFix.latitudeL = fix.latitudeL();
+    gpsAidingFix.longitudeL = fix.longitudeL();
+    gpsAidingFix.altitude = fix.valid.altitude ? fix.altitude_cm() : 0;
+    gpsAidingFix.time = time;
+    hasGPSAidingFix = true;
+
+    AloraGPSAidingStore::save(gpsAidingFix);
+}
+
+/**
+ * Get UTC time from the software clock or the RTC. The RTC is expected to run on UTC.
+ * @return seconds since 1970, 0 if the RTC is missing or lost its time.
+ */
+uint32_t AloraSensorKit::getUTCTime() {
+    if (softClock.isSet()) {
+        return softClock.now() / 1000000ULL;
+    }
+
+    if (rtc == NULL || rtc->lostPower()) {
+        return 0;
+    }
+
+    return rtc->now().unixtime();
+}
+
+/**
+ * Feed the latest IMU sample to the GPS and IMU position filter.
+ */
+void AloraSensorKit::feedGPSFusion() {
+    float east, north, up;
+    uint32_t timestamp;
+
+    if (imuSensor == NULL || !imuSensor->readEarthAcceleration(east, north, up, timestamp)) {
+        return;
+    }
+
+    if (timestamp != lastFusionImuMicros) {
+        lastFusionImuMicros = timestamp;
+        gpsFusion->predict(east, north, up, timestamp);
+    }
+}
+
+/**
+ * @brief Enable or disable GPS and IMU position fusion. While enabled, run()
+ * integrates every IMU sample and corrects with every GPS fix, so position is
+ * available between the fixes. Needs the GPS from initGPS() and the IMU with
+ * magnetometer for heading.
+ *
+ * @param enable true to run the position filter
+ */
+void AloraSensorKit::enableGPSFusion(bool enable) {
+    if (enable && gpsFusion == NULL) {
+        // IMU samples drive the filter between fixes
+        requireDevices(ALORA_DEVICE_IMU);
+        gpsFusion = new AloraGPSFusion();
+    } else if (!enable && gpsFusion != NULL) {
+        delete gpsFusion;
+        gpsFusion = NULL;
+    }
+}
+
+/**
+ * @brief Get fused position and velocity with their variances, extrapolated
+ * from the last IMU sample to the query time
+ *
+ * @param position fused position will be stored here
+ * @param timestamp micros() of the query, 0 for now
+ * @return true if position fusion is enabled and received a fix
+ */
+bool AloraSensorKit::getFusedPosition(AloraFusedPosition& position, uint32_t timestamp) {
+    if (gpsFusion == NULL) {
+        return false;
+    }
+
+    return gpsFusion->getPosition(timestamp != 0 ? timestamp : micros(), position);
+}
+
+/**
+ * @brief Duty-cycle the GPS receiver. run() keeps it on until a fix with good
+ * HDOP arrives, then turns it off for an interval that is short while moving
+ * and grows while still. Motion comes from IMU motion gating, enable it with
+ * setMotionGated(), otherwise the shortest interval applies.
+ *
+ * @param enable true to duty-cycle the receiver, false to return it to the
+ * power state it had before
+ */
+void AloraSensorKit::enableGPSPowerManagement(bool enable) {
+    if (enable && gpsPower == NULL) {
+        // motion from the IMU chooses the off interval
+        requireDevices(ALORA_DEVICE_IMU);
+        gpsPower = new AloraGPSPowerManager();
+        gpsPower->reset(millis());
+        gpsPowerRestore = gpsOn;
+        setGPSPower(true);
+    } else if (!enable && gpsPower != NULL) {
+        delete gpsPower;
+        gpsPower = NULL;
+        setGPSPower(gpsPowerRestore);
     }
 }
 
+/**
+ * @brief Check whether the GPS receiver is powered
+ *
+ * @return true if the GPS enable pin is on
+ */
+bool AloraSensorKit::isGPSOn() {
+    return gpsOn;
+}
+
+/**
+ * @brief Evaluate a geofence on every GPS fix. While set, run() reads the GPS
+ * on every call and the enter and exit events of the latest fix are available
+ * from AloraGeofence::getEvent() until the next fix.
+ *
+ * @param geofence built geofence, NULL to stop. The kit does not take ownership
+ */
+void AloraSensorKit::setGeofence(AloraGeofence* geofence) {
+    this->geofence = geofence;
+}
+
 /**
  * Get NMEAGPS object
  * @return NMEAGPS object of the GPS
@@ -657,6 +1667,8 @@ NMEAGPS* AloraSensorKit::getGPSObject() {
  * @return GpioExpander* pointer to GPIO Expander object
  */
 GpioExpander* AloraSensorKit::getIOExpander() {
+    requireDevices(ALORA_DEVICE_IO_EXPANDER);
+
     return this->ioExpander;
 }
 
@@ -666,6 +1678,8 @@ GpioExpander* AloraSensorKit::getIOExpander() {
  * @return ALORA_IMU_SENSOR* pointer to Alora IMU sensor adapter object
  */
 ALORA_IMU_SENSOR* AloraSensorKit::getIMUSensorAdapter() {
+    requireDevices(ALORA_DEVICE_IMU);
+
     return this->imuSensor;
 }
 
@@ -693,3 +1707,21 @@ void AloraSensorKit::turnOff() {
 void AloraSensorKit::setCCS811WakeLogic(uint8_t wakeLogic) {
     this->ccs811WakeLogic = wakeLogic;
 }
+
+/**
+ * @brief Gate IMU sampling on motion. While the board is still the IMU runs
+ * at a low rate, is not polled and the IMU values in SensorValues keep their
+ * last reading. Motion wakes full-rate sampling.
+ *
+ * @param enable true to gate IMU sampling on motion
+ * @return true if the IMU supports motion gating
+ */
+bool AloraSensorKit::setMotionGated(bool enable) {
+    requireDevices(ALORA_DEVICE_IMU);
+
+    if (imuSensor == NULL) {
+        return false;
+    }
+
+    return imuSensor->setMotionGating(enable);
+}
@@ -27,6 +27,13 @@
 using namespace AllAboutEE;
 
 #include "AloraIMULSM9DS1Adapter.h"
+#include "AloraGPSFusion.h"
+#include "AloraGeofence.h"
+#include "AloraGPSConfig.h"
+#include "AloraGPSPowerManager.h"
+#include "AloraClock.h"
+#include "AloraPPS.h"
+#include "AloraSleepScheduler.h"
 
 /** Choose IMU sensor for Alora. Uses LSM9DS1 by default */
 #if !defined(ALORA_IMU_SENSOR)
@@ -78,6 +85,42 @@ using namespace AllAboutEE;
     #define ALORA_USE_TSL2591_SENSOR 1
 #endif
 
+/** Serial messages of the library: 0 none, 1 errors, 2 errors and initialization progress. Compiled out by default */
+#if !defined(ALORA_DEBUG)
+    #define ALORA_DEBUG 0
+#endif
+
+#if ALORA_DEBUG >= 1
+    #define ALORA_LOG_ERROR(...) Serial.printf(__VA_ARGS__)
+#else
+    #define ALORA_LOG_ERROR(...)
+#endif
+
+#if ALORA_DEBUG >= 2
+    #define ALORA_LOG_DEBUG(...) Serial.printf(__VA_ARGS__)
+#else
+    #define ALORA_LOG_DEBUG(...)
+#endif
+
+/** Time in milliseconds after power-up a sensor may take to answer on I2C before it is skipped */
+#if !defined(ALORA_INIT_TIMEOUT_MS)
+    #define ALORA_INIT_TIMEOUT_MS 1000
+#endif
+
+/** Devices for setActiveSensors(). The bit order is the initialization order */
+#define ALORA_DEVICE_RTC            0x01
+#define ALORA_DEVICE_BME280         0x02
+#define ALORA_DEVICE_HDC1080        0x04
+#define ALORA_DEVICE_TSL2591        0x08
+#define ALORA_DEVICE_MAX11609       0x10
+#define ALORA_DEVICE_IO_EXPANDER    0x20
+#define ALORA_DEVICE_CCS811         0x40
+#define ALORA_DEVICE_IMU            0x80
+#define ALORA_DEVICE_ALL            0xFF
+
+/** BME280 I2C address, the Adafruit_BME280 default */
+#define ALORA_I2C_ADDRESS_BME280 0x77
+
 /** HDC1080 I2C address */
 #define ALORA_HDC1080_ADDRESS 0x40
 
@@ -118,6 +161,39 @@ using namespace AllAboutEE;
     #define ALORA_GPS_ENABLE_PIN 12
 #endif
 
+/** Default RTC GPIO connected to the DS3231 INT/SQW output for deepSleepUntil(), -1 wakes by the ESP32 timer only */
+#if !defined(ALORA_RTC_INT_PIN)
+    #define ALORA_RTC_INT_PIN -1
+#endif
+
+/** I2C address of the DS3231 RTC */
+#define ALORA_I2C_ADDRESS_RTC 0x68
+
+/** Shortest deep sleep in seconds, closer deadlines do not pay off the boot time */
+#if !defined(ALORA_SLEEP_MIN_S)
+    #define ALORA_SLEEP_MIN_S 2
+#endif
+
+/** Time in seconds between two RTC checks of the software clock. With recent GPS time the RTC is set instead */
+#if !defined(ALORA_CLOCK_RTC_INTERVAL_S)
+    #define ALORA_CLOCK_RTC_INTERVAL_S 600
+#endif
+
+/** Longest delay in microseconds between a GPS fix epoch and the first character of its NMEA sentences */
+#if !defined(ALORA_CLOCK_NMEA_LATENCY_US)
+    #define ALORA_CLOCK_NMEA_LATENCY_US 300000
+#endif
+
+/** Distance in meters from the saved fix after which a new fix is saved for GPS aiding */
+#if !defined(ALORA_GPS_AIDING_SAVE_DISTANCE_M)
+    #define ALORA_GPS_AIDING_SAVE_DISTANCE_M 1000
+#endif
+
+/** Age in seconds of the saved fix after which a new fix is saved for GPS aiding */
+#if !defined(ALORA_GPS_AIDING_SAVE_INTERVAL_S)
+    #define ALORA_GPS_AIDING_SAVE_INTERVAL_S 3600
+#endif
+
 /**
  * Data read from sensors are stored in this struct
  */
@@ -139,10 +215,19 @@ struct SensorValues {
     float magX;         /**< Magnometer X axis */
     float magY;         /**< Magnometer Y axis */
     float magZ;         /**< Magnometer Z axis */
-    float magHeading;   /**< Heading in degrees */
+    float magHeading;   /**< Tilt-compensated heading in degrees from the IMU orientation filter */
+    float roll;         /**< Roll angle in degrees from the IMU orientation filter */
+    float pitch;        /**< Pitch angle in degrees from the IMU orientation filter */
+    uint16_t accelRange;    /**< Accelerometer full scale in g, 0 if unknown */
+    uint16_t gyroRange;     /**< Gyroscope full scale in degrees per second, 0 if unknown */
+    bool imuRangeChanged;   /**< IMU full scale changed since the previous sensing, resolution differs */
+    AloraVibrationFeatures vibration;   /**< Features of the last vibration spectrum, zero if vibration analysis never ran */
     int magnetic;       /**< Magnetic sensor value */
     float windSpeed;    /**< Speed of the wind in MPH */
     gps_fix gpsFix;     /**< GPS fix information */
+    uint64_t timestamp; /**< UTC time of the sensing in microseconds since 1970, 0 if the clock is not set */
+    uint64_t vibrationTimestamp;    /**< UTC time of the last sample of the vibration spectrum in microseconds since 1970, 0 if unknown */
+    uint32_t timestampError;        /**< Error estimate of the timestamps in microseconds */
 };
 
 
@@ -151,6 +236,7 @@ struct SensorValues {
  *  Main class for reading sensor on Alora board
  *  \example examples/AloraReadAllSensor/AloraReadAllSensor.ino
  *  \example examples/AloraReadGPS/AloraReadGPS.ino
+ *  \example examples/AloraDeepSleep/AloraDeepSleep.ino
  */
 class AloraSensorKit {
 public:
@@ -158,6 +244,9 @@ public:
     ~AloraSensorKit();
 
     void begin();
+    void beginAsync();
+    bool pollBegin();
+    void setActiveSensors(uint8_t devices);
     void run();
     void turnOff();
     void turnOn();
@@ -166,12 +255,23 @@ public:
     void printSensingTo(String& str);
     uint16_t readADC(uint8_t channel);
     DateTime getDateTime();
+    uint64_t getTimestamp(uint32_t timestamp = 0);
+    bool getTimestamp(uint32_t timestamp, uint64_t& time, uint32_t& error);
+    bool enablePPS(bool enable = true);
+    bool deepSleepUntil(uint32_t deadline, int8_t interruptPin = ALORA_RTC_INT_PIN, bool keepPowered = false);
     SensorValues& getLastSensorData();
     void initGPS(Stream* gpsStream);
+    bool configureGPS(HardwareSerial* gpsSerial, uint32_t baud = ALORA_GPS_BAUD, uint16_t fixIntervalMs = ALORA_GPS_FIX_INTERVAL_MS);
     NMEAGPS* getGPSObject();
     GpioExpander* getIOExpander();
     ALORA_IMU_SENSOR* getIMUSensorAdapter();
     void setCCS811WakeLogic(uint8_t wakeLogic = LOW);
+    bool setMotionGated(bool enable);
+    void enableGPSFusion(bool enable = true);
+    bool getFusedPosition(AloraFusedPosition& position, uint32_t timestamp = 0);
+    void setGeofence(AloraGeofence* geofence);
+    void enableGPSPowerManagement(bool enable = true);
+    bool isGPSOn();
 
 private:
     uint8_t enablePin;                                          /**< Alora board enable pin */
@@ -187,12 +287,50 @@ private:
     GpioExpander* ioExpander = NULL;                            /**< Object of GPIO Expander (SX1509) */
     MAX11609* max11609 = NULL;                                  /**< Object of MAX11609 */
     RTC_DS3231* rtc = NULL;                                     /**< Object of RTC sensor */
+    AloraGPSFusion* gpsFusion = NULL;                           /**< GPS and IMU position filter, NULL if disabled */
+    uint32_t lastFusionImuMicros = 0;                           /**< Timestamp of the last IMU sample fed to the position filter */
+    AloraGPSAidingFix gpsAidingFix;                             /**< Last saved GPS fix, injected into the receiver after power-up */
+    bool hasGPSAidingFix = false;                               /**< Whether gpsAidingFix holds a fix */
+    bool gpsAidingPending = false;                              /**< Whether the receiver was powered up and waits for aiding */
+    HardwareSerial* gpsConfigSerial = NULL;                     /**< UART configureGPS() set up, NULL while the receiver runs on its defaults */
+    uint32_t gpsPowerUpBaud = 0;                                /**< Baud rate the receiver talks at after power-up */
+    uint32_t gpsConfigBaud = 0;                                 /**< Baud rate given to configureGPS() */
+    uint16_t gpsConfigIntervalMs = 0;                           /**< Fix interval given to configureGPS() */
+    bool gpsConfigPending = false;                              /**< Whether the receiver was powered up and lost the configureGPS() settings */
+    AloraGPSPowerManager* gpsPower = NULL;                      /**< GPS duty cycle, NULL if the GPS stays on */
+    bool gpsOn = false;                                         /**< Whether the GPS enable pin is on */
+    bool gpsPowerRestore = false;                               /**< GPS power state before power management was enabled */
+    AloraGeofence* geofence = NULL;                             /**< Geofence evaluated on every fix, owned by the caller */
+
+    AloraClock softClock;                                       /**< UTC clock on micros(), disciplined by the RTC and GPS time */
+    uint32_t lastClockRTCMs = 0;                                /**< Time of the last RTC check of the software clock */
+    uint32_t lastClockGPSMs = 0;                                /**< Time of the last GPS correction of the software clock */
+    bool hasClockGPS = false;                                   /**< Whether GPS time corrected the software clock */
+    uint32_t gpsPollMicros = 0;                                 /**< micros() of the previous readGPS() */
+    uint32_t gpsSentenceMicros = 0;                             /**< micros() the first character of the current NMEA interval was seen */
+    uint32_t gpsSentenceDelay = 0;                              /**< Longest time in us the first character waited before it was seen */
+    bool gpsSentenceStarted = false;                            /**< Whether characters of a new NMEA interval arrived */
+    AloraPPS* pps = NULL;                                       /**< GPS pulse per second drift model, NULL if disabled */
+    uint32_t ppsPulseMicros = 0;                                /**< micros() of the newest pulse not yet labeled with its second */
+    bool ppsPulsePending = false;                               /**< Whether ppsPulseMicros waits for the following fix */
 
     SensorValues lastSensorData;                                /**< Object of SensorValues struct. All sensor data are stored in this property */
     uint32_t lastSensorQuerryMs = 0;                            /**< Records the time when the sensor data is read in milliseconds */
+    uint16_t lastImuRangeChangeCount = 0;                       /**< IMU range change count seen by the previous sensing */
 
     uint8_t ccs811WakeLogic;                                    /**< CCS811 air quality sensor wake logic */
 
+    uint8_t activeDevices = ALORA_DEVICE_ALL;                   /**< Devices initialized without waiting for their first access */
+    uint8_t initPending = 0;                                    /**< Devices waiting for pollBegin() */
+    bool initStarted = false;                                   /**< Whether beginAsync() was called */
+    bool initPowered = false;                                   /**< Whether the sensors stayed powered over deep sleep */
+    uint32_t powerOnMs = 0;                                     /**< Time the Alora rail was turned on */
+    uint32_t expanderOnMs = 0;                                  /**< Time the IO expander powered IMU and CCS811 */
+
+    void requestDevices(uint8_t devices);
+    void requireDevices(uint8_t devices);
+    uint8_t getDeviceAddress(uint8_t device);
+    bool initDevice(uint8_t device);
     void doAllSensing();
     void readBME280(float& T, float& P, float& H);
     void readHDC1080(float& T, float& H);
@@ -201,10 +339,26 @@ private:
     void readGas(uint16_t& gas, uint16_t& co2);
     void readAccelerometer(float &ax, float &ay, float &az);
     void readMagnetometer(float &mx, float &my, float &mz, float &mH);
+    void readOrientation(float &roll, float &pitch);
+    void readIMU();
+    void readIMURange(uint16_t &accelRange, uint16_t &gyroRange, bool &changed);
+    void readVibration(AloraVibrationFeatures &features);
     void readGyro(float &gx, float &gy, float &gz);
     void readMagneticSensor(int& mag);
     void readWindSpeed(float& windspeed);
-    void readGPS(gps_fix& fix);
+    bool readGPS(gps_fix& fix);
+    bool waitForGPSSentence(uint32_t timeoutMs);
+    void sendGPSAiding();
+    void setGPSPower(bool on);
+    void updateGPSPower();
+    void saveGPSAidingFix(const gps_fix& fix);
+    uint32_t getUTCTime();
+    void syncClockToRTC();
+    void updateClock();
+    void updatePPS();
+    void addPPSPulse(uint32_t timestamp, uint32_t second);
+    bool setRTCAlarm(uint32_t deadline);
+    void feedGPSFusion();
 };
 
 #endif
@@ -0,0 +1,71 @@
+/** @file */
+
+#include "AloraSleepScheduler.h"
+
+AloraSleepScheduler::AloraSleepScheduler() {
+    clear();
+}
+
+/**
+ * @brief Add a periodic task
+ *
+ * @param period time between two runs in seconds, for example 60 for every minute
+ * @param offset seconds into the period the task runs at, smaller than period
+ * @return int8_t task index for isDue(), -1 if the schedule is full or the period is 0
+ */
+int8_t AloraSleepScheduler::addTask(uint32_t period, uint32_t offset) {
+    if (period == 0 || taskCount >= ALORA_SLEEP_MAX_TASKS) {
+        return -1;
+    }
+
+    periods[taskCount] = period;
+    offsets[taskCount] = offset % period;
+
+    return taskCount++;
+}
+
+/**
+ * @brief Remove all tasks
+ */
+void AloraSleepScheduler::clear() {
+    taskCount = 0;
+}
+
+/**
+ * @brief Check whether a deadline of a task passed within the last
+ * ALORA_SLEEP_DUE_WINDOW_S seconds
+ *
+ * @param task index returned by addTask()
+ * @param now UTC seconds since 1970
+ * @return true if the task should run now
+ */
+bool AloraSleepScheduler::isDue(uint8_t task, uint32_t now) {
+    if (task >= taskCount) {
+        return false;
+    }
+
+    uint32_t sinceDeadline = (now + periods[task] - offsets[task]) % periods[task];
+
+    return sinceDeadline <= ALORA_SLEEP_DUE_WINDOW_S;
+}
+
+/**
+ * @brief Get the earliest deadline after now over all tasks
+ *
+ * @param now UTC seconds since 1970
+ * @return uint32_t UTC seconds of the next deadline, 0 without tasks
+ */
+uint32_t AloraSleepScheduler::getNextDeadline(uint32_t now) {
+    uint32_t next = 0;
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        uint32_t sinceDeadline = (now + periods[i] - offsets[i]) % periods[i];
+        uint32_t deadline = now - sinceDeadline + periods[i];
+
+        if (next == 0 || deadline < next) {
+            next = deadline;
+        }
+    }
+
+    return next;
+}
@@ -0,0 +1,42 @@
+/** @file */
+
+#ifndef ALORA_SLEEP_SCHEDULER_H
+#define ALORA_SLEEP_SCHEDULER_H
+
+#include <stdint.h>
+
+/** Largest number of periodic tasks */
+#if !defined(ALORA_SLEEP_MAX_TASKS)
+    #define ALORA_SLEEP_MAX_TASKS 8
+#endif
+
+/** Time in seconds after a deadline during which its task counts as due, covers wake-up and boot time */
+#if !defined(ALORA_SLEEP_DUE_WINDOW_S)
+    #define ALORA_SLEEP_DUE_WINDOW_S 5
+#endif
+
+/**
+ * @brief Wake schedule of periodic tasks.
+ *
+ * Deadlines are aligned to UTC: a task with period p and offset o is due at
+ * every t with t % p == o. Nothing has to survive deep sleep except the
+ * clock, which the DS3231 keeps. After a wake-up, isDue() tells which tasks
+ * the wake was for, getNextDeadline() gives the time to program the next
+ * alarm for.
+ */
+class AloraSleepScheduler {
+public:
+    AloraSleepScheduler();
+
+    int8_t addTask(uint32_t period, uint32_t offset = 0);
+    void clear();
+    bool isDue(uint8_t task, uint32_t now);
+    uint32_t getNextDeadline(uint32_t now);
+
+private:
+    uint32_t periods[ALORA_SLEEP_MAX_TASKS]; /**< Task periods in seconds */
+    uint32_t offsets[ALORA_SLEEP_MAX_TASKS]; /**< Task offsets in seconds into their period */
+    uint8_t taskCount;                      /**< Number of tasks */
+};
+
+#endif
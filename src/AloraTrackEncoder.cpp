@@ -0,0 +1,96 @@
+/** @file */
+
+#include "AloraTrackEncoder.h"
+
+AloraTrackEncoder::AloraTrackEncoder() {
+    reset();
+}
+
+/**
+ * @brief Start a new block, the next point is coded absolute
+ */
+void AloraTrackEncoder::reset() {
+    memset(&previous, 0, sizeof(previous));
+}
+
+/**
+ * @brief Encode a point
+ *
+ * @param point point to encode
+ * @param data output buffer of at least ALORA_TRACK_ENCODER_MAX_BYTES bytes
+ * @return uint8_t number of bytes written
+ */
+uint8_t AloraTrackEncoder::encode(const AloraTrackPoint& point, uint8_t* data) {
+    uint8_t length = 0;
+
+    // deltas wrap around in two's complement and decode back exactly
+    length += writeVarint((int32_t) ((uint32_t) point.latitudeL - (uint32_t) previous.latitudeL), &data[length]);
+    length += writeVarint((int32_t) ((uint32_t) point.longitudeL - (uint32_t) previous.longitudeL), &data[length]);
+    length += writeVarint((int32_t) ((uint32_t) point.altitude - (uint32_t) previous.altitude), &data[length]);
+    length += writeVarint((int32_t) (point.time - previous.time), &data[length]);
+
+    previous = point;
+
+    return length;
+}
+
+/**
+ * @brief Decode a point
+ *
+ * @param data encoded data
+ * @param length number of bytes available in data
+ * @param point decoded point will be stored here
+ * @return uint8_t number of bytes consumed, 0 if data is truncated or invalid
+ */
+uint8_t AloraTrackEncoder::decode(const uint8_t* data, size_t length, AloraTrackPoint& point) {
+    int32_t delta[4];
+    uint8_t offset = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t size = readVarint(&data[offset], length - offset, delta[i]);
+        if (size == 0) {
+            return 0;
+        }
+
+        offset += size;
+    }
+
+    point.latitudeL = (int32_t) ((uint32_t) previous.latitudeL + (uint32_t) delta[0]);
+    point.longitudeL = (int32_t) ((uint32_t) previous.longitudeL + (uint32_t) delta[1]);
+    point.altitude = (int32_t) ((uint32_t) previous.altitude + (uint32_t) delta[2]);
+    point.time = previous.time + (uint32_t) delta[3];
+
+    previous = point;
+
+    return offset;
+}
+
+uint8_t AloraTrackEncoder::writeVarint(int32_t value, uint8_t* data) {
+    uint32_t zigzag = ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+    uint8_t length = 0;
+
+    while (zigzag >= 0x80) {
+        data[length++] = (uint8_t) (zigzag | 0x80);
+        zigzag >>= 7;
+    }
+
+    data[length++] = (uint8_t) zigzag;
+
+    return length;
+}
+
+uint8_t AloraTrackEncoder::readVarint(const uint8_t* data, size_t length, int32_t& value) {
+    uint32_t zigzag = 0;
+
+    for (uint8_t i = 0; i < 5 && i < length; i++) {
+        zigzag |= (uint32_t) (data[i] & 0x7F) << (7 * i);
+
+        if ((data[i] & 0x80) == 0) {
+            value = (int32_t) (zigzag >> 1) ^ -(int32_t) (zigzag & 1);
+
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
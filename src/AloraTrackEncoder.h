@@ -0,0 +1,38 @@
+/** @file */
+
+#ifndef ALORA_TRACK_ENCODER_H
+#define ALORA_TRACK_ENCODER_H
+
+#include "AloraTrackSimplifier.h"
+
+/** Largest size in bytes of one encoded point */
+#define ALORA_TRACK_ENCODER_MAX_BYTES 20
+
+/**
+ * @brief Delta and varint coding of track points.
+ *
+ * Every field is stored as the difference to the previous point, zigzag
+ * mapped so small negative and positive steps both give small numbers, and
+ * written as a LEB128 varint of 7 bits per byte. The first point after
+ * reset() is coded against zero, which makes it absolute. Points of a
+ * simplified track are typically 6 to 10 bytes instead of 16.
+ *
+ * The same class decodes; use one object per direction and reset() both at
+ * the start of every stored block, so each block decodes on its own.
+ */
+class AloraTrackEncoder {
+public:
+    AloraTrackEncoder();
+
+    void reset();
+    uint8_t encode(const AloraTrackPoint& point, uint8_t* data);
+    uint8_t decode(const uint8_t* data, size_t length, AloraTrackPoint& point);
+
+private:
+    AloraTrackPoint previous;               /**< Reference of the next delta */
+
+    static uint8_t writeVarint(int32_t value, uint8_t* data);
+    static uint8_t readVarint(const uint8_t* data, size_t length, int32_t& value);
+};
+
+#endif
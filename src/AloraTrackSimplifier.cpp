@@ -0,0 +1,143 @@
+/** @file */
+
+#include "AloraTrackSimplifier.h"
+
+/** Meters per 10^-7 degree of latitude, mean over the WGS84 ellipsoid */
+#define ALORA_TRACK_NORTH_SCALE 0.0111132f
+
+AloraTrackSimplifier::AloraTrackSimplifier() {
+    reset();
+}
+
+/**
+ * @brief Start a new track, the next fix is retained
+ */
+void AloraTrackSimplifier::reset() {
+    memset(&anchor, 0, sizeof(anchor));
+    memset(&output, 0, sizeof(output));
+    memset(&last, 0, sizeof(last));
+    windowCount = 0;
+    hasAnchor = false;
+    eastScale = ALORA_TRACK_NORTH_SCALE;
+}
+
+/**
+ * @brief Add a GPS fix to the track. Altitude and time missing from the fix
+ * are taken over from the previous one.
+ *
+ * @param fix fix from NMEAGPS, ignored without a valid location
+ * @return true if a point was retained, read it with getPoint()
+ */
+bool AloraTrackSimplifier::add(const gps_fix& fix) {
+    if (!fix.valid.location) {
+        return false;
+    }
+
+    AloraTrackPoint point = last;
+    point.latitudeL = fix.latitudeL();
+    point.longitudeL = fix.longitudeL();
+
+    if (fix.valid.altitude) {
+        point.altitude = fix.altitude_cm();
+    }
+
+    if (fix.valid.date && fix.valid.time) {
+        point.time = (NeoGPS::clock_t) fix.dateTime;
+    }
+
+    return add(point);
+}
+
+/**
+ * @brief Add a point to the track
+ *
+ * @param point next point, time must not go backwards
+ * @return true if a point was retained, read it with getPoint()
+ */
+bool AloraTrackSimplifier::add(const AloraTrackPoint& point) {
+    bool retained = false;
+
+    last = point;
+
+    if (!hasAnchor) {
+        retain(point);
+        hasAnchor = true;
+
+        return true;
+    }
+
+    if (windowCount > 0) {
+        bool full = windowCount >= ALORA_TRACK_WINDOW;
+        bool late = ALORA_TRACK_MAX_INTERVAL_S > 0 && point.time - anchor.time > ALORA_TRACK_MAX_INTERVAL_S;
+
+        if (full || late || !isWithinTolerance(point)) {
+            retain(window[windowCount - 1]);
+            retained = true;
+        }
+    }
+
+    window[windowCount++] = point;
+
+    return retained;
+}
+
+/**
+ * @brief Retain the newest held back fix, call it at the end of a track
+ *
+ * @return true if a point was retained, read it with getPoint()
+ */
+bool AloraTrackSimplifier::flush() {
+    if (windowCount == 0) {
+        return false;
+    }
+
+    retain(window[windowCount - 1]);
+
+    return true;
+}
+
+/**
+ * @brief Get the point retained by the last add() or flush() that returned true
+ *
+ * @return const AloraTrackPoint& retained point
+ */
+const AloraTrackPoint& AloraTrackSimplifier::getPoint() {
+    return output;
+}
+
+/**
+ * @brief Check whether the segment from the anchor to a new point passes all
+ * held back fixes within the tolerance
+ */
+bool AloraTrackSimplifier::isWithinTolerance(const AloraTrackPoint& point) {
+    const float tolerance = ALORA_TRACK_TOLERANCE_M * ALORA_TRACK_TOLERANCE_M;
+
+    float x = (point.longitudeL - anchor.longitudeL) * eastScale;
+    float y = (point.latitudeL - anchor.latitudeL) * ALORA_TRACK_NORTH_SCALE;
+    float length = x * x + y * y;
+
+    for (uint8_t i = 0; i < windowCount; i++) {
+        float px = (window[i].longitudeL - anchor.longitudeL) * eastScale;
+        float py = (window[i].latitudeL - anchor.latitudeL) * ALORA_TRACK_NORTH_SCALE;
+
+        // distance to the segment, a fix behind either end is measured to that end
+        float t = length > 0.0f ? (px * x + py * y) / length : 0.0f;
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+        float dx = px - t * x;
+        float dy = py - t * y;
+
+        if (dx * dx + dy * dy > tolerance) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void AloraTrackSimplifier::retain(const AloraTrackPoint& point) {
+    anchor = point;
+    output = point;
+    windowCount = 0;
+    eastScale = ALORA_TRACK_NORTH_SCALE * cosf(point.latitudeL * (1e-7f * (float) DEG_TO_RAD));
+}
@@ -0,0 +1,70 @@
+/** @file */
+
+#ifndef ALORA_TRACK_SIMPLIFIER_H
+#define ALORA_TRACK_SIMPLIFIER_H
+
+#include <Arduino.h>
+#include <NMEAGPS.h>
+
+/** Largest distance in meters between the simplified and the original track */
+#if !defined(ALORA_TRACK_TOLERANCE_M)
+    #define ALORA_TRACK_TOLERANCE_M 5.0f
+#endif
+
+/** Largest number of fixes held back between two retained points, bounds memory and time per fix */
+#if !defined(ALORA_TRACK_WINDOW)
+    #define ALORA_TRACK_WINDOW 32
+#endif
+
+/** Longest time in seconds between two retained points, 0 for no limit */
+#if !defined(ALORA_TRACK_MAX_INTERVAL_S)
+    #define ALORA_TRACK_MAX_INTERVAL_S 300
+#endif
+
+/**
+ * @brief One point of a track
+ */
+struct AloraTrackPoint {
+    int32_t latitudeL;                      /**< Latitude in degrees * 10^7, the NeoGPS integer format */
+    int32_t longitudeL;                     /**< Longitude in degrees * 10^7 */
+    int32_t altitude;                       /**< Altitude in cm */
+    uint32_t time;                          /**< Seconds since 2000-01-01, the NeoGPS clock_t */
+};
+
+/**
+ * @brief Streaming track simplifier.
+ *
+ * Implements the opening window variant of Douglas-Peucker: fixes after the
+ * last retained point are held back while the segment from that point to the
+ * newest fix passes within ALORA_TRACK_TOLERANCE_M of all of them. When a fix
+ * breaks the tolerance, the fix before it is retained and starts the next
+ * segment. Straight or slow parts of a track collapse into single segments,
+ * turns keep their corner points.
+ *
+ * Distances use a flat projection around the last retained point, which is
+ * exact to well below the tolerance over the length of one segment.
+ */
+class AloraTrackSimplifier {
+public:
+    AloraTrackSimplifier();
+
+    void reset();
+    bool add(const gps_fix& fix);
+    bool add(const AloraTrackPoint& point);
+    bool flush();
+    const AloraTrackPoint& getPoint();
+
+private:
+    AloraTrackPoint anchor;                 /**< Last retained point, start of the current segment */
+    AloraTrackPoint window[ALORA_TRACK_WINDOW]; /**< Fixes held back since the anchor */
+    uint8_t windowCount;                    /**< Number of held back fixes */
+    bool hasAnchor;                         /**< Whether a point was retained since reset() */
+    float eastScale;                        /**< Meters per 10^-7 degree of longitude at the anchor */
+    AloraTrackPoint output;                 /**< Point retained by the last add() or flush() */
+    AloraTrackPoint last;                   /**< Latest point, fills in altitude and time a fix is missing */
+
+    bool isWithinTolerance(const AloraTrackPoint& point);
+    void retain(const AloraTrackPoint& point);
+};
+
+#endif
@@ -0,0 +1,304 @@
+/** @file */
+
+#include "AloraVibrationAnalyzer.h"
+#include "AloraFFT.h"
+#include "AloraIMUBatch.h"
+
+AloraVibrationAnalyzer::AloraVibrationAnalyzer():
+ imuSensor(NULL),
+ running(false),
+ sampleRate(ALORA_VIBRATION_RATE_HZ),
+ blockScale(0),
+ fill(0),
+ featuresValid(false) {
+    memset(&features, 0, sizeof(features));
+    memset(&latest, 0, sizeof(latest));
+}
+
+/**
+ * @brief Set the sensor to stream from
+ *
+ * @param imuSensor initialized LSM9DS1 object
+ */
+void AloraVibrationAnalyzer::begin(LSM9DS1* imuSensor) {
+    this->imuSensor = imuSensor;
+}
+
+/**
+ * @brief Start streaming the FIFO into the analyzer. The accelerometer/gyroscope
+ * data rate is not changed, set it to ALORA_VIBRATION_RATE_HZ first.
+ *
+ * @param sampleRate accelerometer output rate in Hz after decimation
+ * @return true if streaming started
+ */
+bool AloraVibrationAnalyzer::start(float sampleRate) {
+    if (imuSensor == NULL || sampleRate <= 0.0f) {
+        return false;
+    }
+
+    this->sampleRate = sampleRate;
+    fill = 0;
+
+    imuSensor->enableFIFO(true);
+    imuSensor->setFIFO(FIFO_CONT, 0x1F);
+
+    running = true;
+
+    return true;
+}
+
+/**
+ * @brief Drain the FIFO and compute a spectrum when the block is full. The
+ * FIFO holds 32 samples, call at least every 32 sample periods.
+ *
+ * @return uint8_t number of new samples
+ */
+uint8_t AloraVibrationAnalyzer::update() {
+    if (!running) {
+        return 0;
+    }
+
+    int16_t gyroRaw[3 * 32];
+    int16_t accelRaw[3 * 32];
+    uint8_t count = imuSensor->readFIFO(gyroRaw, accelRaw, 32);
+
+    // the newest sample in the FIFO is at most one period old
+    uint32_t timestamp = micros();
+
+    if (count == 0) {
+        return 0;
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        latest.gyro[axis] = gyroRaw[3 * (count - 1) + axis];
+        latest.accel[axis] = accelRaw[3 * (count - 1) + axis];
+    }
+
+    addSamples(accelRaw, count, timestamp);
+
+    return count;
+}
+
+/**
+ * @brief Stop streaming. The last features stay available.
+ */
+void AloraVibrationAnalyzer::stop() {
+    if (running) {
+        imuSensor->setFIFO(FIFO_OFF, 0x00);
+        imuSensor->enableFIFO(false);
+    }
+
+    running = false;
+    fill = 0;
+}
+
+/**
+ * @brief Check whether the FIFO streams into the analyzer
+ *
+ * @return true if running
+ */
+bool AloraVibrationAnalyzer::isRunning() {
+    return running;
+}
+
+/**
+ * @brief Add raw accelerometer samples to the block
+ *
+ * @param accelRaw interleaved raw triples, 3 * count values, the layout of readFIFO()
+ * @param count number of triples
+ * @param timestamp micros() of the last triple, 0 if unknown
+ * @return true if at least one spectrum was computed
+ */
+bool AloraVibrationAnalyzer::addSamples(const int16_t* accelRaw, uint16_t count, uint32_t timestamp) {
+    uint16_t scale = imuSensor != NULL ? imuSensor->settings.accel.scale : 0;
+    bool analyzed = false;
+
+    // one block must share one resolution
+    if (scale != blockScale) {
+        blockScale = scale;
+        fill = 0;
+    }
+
+    uint16_t i = 0;
+    while (i < count) {
+        uint16_t length = count - i < ALORA_VIBRATION_FFT_SIZE - fill ? count - i : ALORA_VIBRATION_FFT_SIZE - fill;
+        AloraIMUBatch::deinterleave(&accelRaw[3 * i], length, NULL, &samples[0][fill], &samples[1][fill], &samples[2][fill]);
+        fill += length;
+        i += length;
+
+        if (fill == ALORA_VIBRATION_FFT_SIZE) {
+            analyze();
+            features.timestamp = timestamp != 0 ? timestamp - (uint32_t) ((count - i) * 1e6f / sampleRate) : 0;
+            fill = 0;
+            analyzed = true;
+        }
+    }
+
+    return analyzed;
+}
+
+/**
+ * @brief Check whether a spectrum was computed
+ *
+ * @return true if getFeatures() holds valid values
+ */
+bool AloraVibrationAnalyzer::hasFeatures() {
+    return featuresValid;
+}
+
+/**
+ * @brief Get features of the last spectrum
+ *
+ * @return const AloraVibrationFeatures& features
+ */
+const AloraVibrationFeatures& AloraVibrationAnalyzer::getFeatures() {
+    return features;
+}
+
+/**
+ * @brief Get the newest sample drained from the FIFO
+ *
+ * @return const AloraIMUSample& latest raw sample
+ */
+const AloraIMUSample& AloraVibrationAnalyzer::getLatestSample() {
+    return latest;
+}
+
+/**
+ * @brief Get the lower edge of a band. A band ends where the next one starts,
+ * the highest band ends at the Nyquist frequency.
+ *
+ * @param band band index, 0 is the lowest
+ * @return float lower edge in Hz
+ */
+float AloraVibrationAnalyzer::getBandStart(uint8_t band) {
+    return bandFirstBin(band) * sampleRate / ALORA_VIBRATION_FFT_SIZE;
+}
+
+void AloraVibrationAnalyzer::analyze() {
+    for (uint16_t k = 0; k < BINS; k++) {
+        power[k] = 0.0f;
+    }
+
+    float meanSquare = 0.0f;
+    for (uint8_t axis = 0; axis < 3; axis++) {
+        meanSquare += addAxisSpectrum(samples[axis]);
+    }
+
+    float resolution = (blockScale != 0 ? blockScale : 2) / 32768.0f;
+
+    uint16_t peak = 1;
+    for (uint16_t k = 2; k < BINS; k++) {
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+
+    // parabolic interpolation of the magnitude around the peak bin
+    float offset = 0.0f;
+    if (peak + 1 < BINS) {
+        float left = sqrtf(power[peak - 1]);
+        float center = sqrtf(power[peak]);
+        float right = sqrtf(power[peak + 1]);
+        float curvature = left - 2.0f * center + right;
+
+        if (curvature < 0.0f) {
+            offset = 0.5f * (left - right) / curvature;
+        }
+    }
+
+    // the Hann window halves the line and the one-sided spectrum halves it again
+    features.peakFrequency = (peak + offset) * sampleRate / ALORA_VIBRATION_FFT_SIZE;
+    features.peakAmplitude = 4.0f * sqrtf(power[peak]) * resolution;
+
+    // one-sided bins count twice, 8 / 3 undoes the window power gain
+    float energyScale = 16.0f / 3.0f * resolution * resolution;
+    for (uint8_t band = 0; band < ALORA_VIBRATION_BANDS; band++) {
+        uint16_t last = band + 1 < ALORA_VIBRATION_BANDS ? bandFirstBin(band + 1) : BINS;
+        float sum = 0.0f;
+
+        for (uint16_t k = bandFirstBin(band); k < last; k++) {
+            sum += power[k];
+        }
+
+        features.bandEnergy[band] = sum * energyScale;
+    }
+
+    features.rms = sqrtf(meanSquare) * resolution;
+    features.sequence++;
+    featuresValid = true;
+}
+
+/**
+ * @brief Transform one axis and add its power spectrum
+ *
+ * @param axis raw samples of the axis, ALORA_VIBRATION_FFT_SIZE values
+ * @return float mean square of the axis in LSB^2 with the mean removed
+ */
+float AloraVibrationAnalyzer::addAxisSpectrum(const int16_t* axis) {
+    int32_t sum = 0;
+    for (uint16_t n = 0; n < ALORA_VIBRATION_FFT_SIZE; n++) {
+        sum += axis[n];
+    }
+
+    int32_t mean = sum / ALORA_VIBRATION_FFT_SIZE;
+    int64_t sumSquares = 0;
+    int32_t peak = 0;
+
+    for (uint16_t n = 0; n < ALORA_VIBRATION_FFT_SIZE; n++) {
+        int32_t value = axis[n] - mean;
+        sumSquares += (int64_t) value * value;
+
+        if (value > peak) {
+            peak = value;
+        } else if (-value > peak) {
+            peak = -value;
+        }
+    }
+
+    if (peak == 0) {
+        return 0.0f;
+    }
+
+    // normalize to at most 16384, the magnitude limit of the scaled FFT
+    uint8_t shift = 0;
+    while ((peak << (shift + 1)) <= 16384) {
+        shift++;
+    }
+
+    uint8_t down = 0;
+    while ((peak >> down) > 16384) {
+        down++;
+    }
+
+    for (uint16_t n = 0; n < ALORA_VIBRATION_FFT_SIZE; n++) {
+        real[n] = (int16_t) (((axis[n] - mean) * (1 << shift)) >> down);
+        imag[n] = 0;
+    }
+
+    AloraFFT::window(real, ALORA_VIBRATION_FFT_SIZE);
+    AloraFFT::transform(real, imag, ALORA_VIBRATION_FFT_SIZE);
+
+    float gain = ldexpf(1.0f, 2 * (down - shift));
+    for (uint16_t k = 1; k < BINS; k++) {
+        int32_t re = real[k];
+        int32_t im = imag[k];
+        power[k] += (float) (re * re + im * im) * gain;
+    }
+
+    return (float) sumSquares / ALORA_VIBRATION_FFT_SIZE;
+}
+
+/**
+ * @brief First FFT bin of an octave band, the lowest band starts at bin 1
+ *
+ * @param band band index, 0 is the lowest
+ * @return uint16_t bin index
+ */
+uint16_t AloraVibrationAnalyzer::bandFirstBin(uint8_t band) {
+    if (band == 0) {
+        return 1;
+    }
+
+    return BINS >> (ALORA_VIBRATION_BANDS - band);
+}
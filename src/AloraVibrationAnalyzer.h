@@ -0,0 +1,89 @@
+/** @file */
+
+#ifndef ALORA_VIBRATION_ANALYZER_H
+#define ALORA_VIBRATION_ANALYZER_H
+
+#include <Arduino.h>
+#include "SparkFunLSM9DS1.h"
+#include "AloraIMUCapture.h"
+
+/** Number of samples per spectrum, power of two from 256 to 1024 */
+#if !defined(ALORA_VIBRATION_FFT_SIZE)
+    #define ALORA_VIBRATION_FFT_SIZE 256
+#endif
+
+/** Number of octave bands in AloraVibrationFeatures::bandEnergy, the highest band ends at the Nyquist frequency */
+#if !defined(ALORA_VIBRATION_BANDS)
+    #define ALORA_VIBRATION_BANDS 4
+#endif
+
+/** Accelerometer/gyroscope data rate in Hz while vibration analysis streams the FIFO */
+#if !defined(ALORA_VIBRATION_RATE_HZ)
+    #define ALORA_VIBRATION_RATE_HZ 952
+#endif
+
+/**
+ * @brief Compact vibration features of one spectrum. Values combine the three
+ * accelerometer axes, so they do not depend on the mounting orientation.
+ */
+struct AloraVibrationFeatures {
+    float rms;                              /**< RMS acceleration in g with gravity and offsets removed */
+    float peakFrequency;                    /**< Frequency of the strongest spectral line in Hz */
+    float peakAmplitude;                    /**< Amplitude of the strongest spectral line in g */
+    float bandEnergy[ALORA_VIBRATION_BANDS]; /**< Mean square acceleration in g^2 per octave band, lowest band first */
+    uint16_t sequence;                      /**< Incremented with every spectrum, wraps around */
+    uint32_t timestamp;                     /**< micros() of the last sample of the block, 0 if unknown */
+};
+
+/**
+ * @brief Accelerometer vibration spectrum computed on the device.
+ *
+ * While running, the LSM9DS1 FIFO streams in continuous mode and update()
+ * drains it in batches of up to 32 samples. Every ALORA_VIBRATION_FFT_SIZE
+ * samples the mean of each axis is removed, a Hann window applied and a Q15
+ * FFT run per axis, and the power spectra of the axes are summed into the
+ * features. Samples of already drained batches can also be fed directly with
+ * addSamples().
+ *
+ * Each axis is normalized to the full Q15 range before the transform, so
+ * small vibrations keep their resolution even at a large accelerometer full
+ * scale. A full scale change discards the partial block.
+ */
+class AloraVibrationAnalyzer {
+public:
+    AloraVibrationAnalyzer();
+
+    void begin(LSM9DS1* imuSensor);
+    bool start(float sampleRate);
+    uint8_t update();
+    void stop();
+    bool isRunning();
+
+    bool addSamples(const int16_t* accelRaw, uint16_t count, uint32_t timestamp = 0);
+    bool hasFeatures();
+    const AloraVibrationFeatures& getFeatures();
+    const AloraIMUSample& getLatestSample();
+    float getBandStart(uint8_t band);
+
+private:
+    static const uint16_t BINS = ALORA_VIBRATION_FFT_SIZE / 2;
+
+    LSM9DS1* imuSensor;                     /**< LSM9DS1 object pointer */
+    bool running;                           /**< Whether the FIFO streams into the analyzer */
+    float sampleRate;                       /**< Sample rate of the accelerometer data in Hz */
+    uint16_t blockScale;                    /**< Accelerometer full scale in g of the samples in the block */
+    int16_t samples[3][ALORA_VIBRATION_FFT_SIZE]; /**< Block of raw samples per axis */
+    uint16_t fill;                          /**< Number of samples in the block */
+    int16_t real[ALORA_VIBRATION_FFT_SIZE]; /**< FFT real part */
+    int16_t imag[ALORA_VIBRATION_FFT_SIZE]; /**< FFT imaginary part */
+    float power[BINS];                      /**< Power spectrum summed over the axes, in LSB^2 */
+    AloraVibrationFeatures features;        /**< Features of the last spectrum */
+    bool featuresValid;                     /**< Whether a spectrum was computed */
+    AloraIMUSample latest;                  /**< Newest raw sample drained from the FIFO */
+
+    void analyze();
+    float addAxisSpectrum(const int16_t* axis);
+    static uint16_t bandFirstBin(uint8_t band);
+};
+
+#endif
@@ -25,6 +25,12 @@ byte GpioExpander::begin(byte address, byte resetPin) {
     return res;
 }
 
+// Take over an SX1509 that stayed powered, without the reset done by begin()
+// so its outputs keep their level
+void GpioExpander::resume() {
+    clock(INTERNAL_CLOCK_2MHZ, 4);
+}
+
 void GpioExpander::turnOnLED() {
 	SX1509::digitalWrite(GPIOEXPANDER_LED_PIN, LOW);
 }
@@ -40,6 +40,7 @@ public:
 
     //byte begin();
     byte begin(byte address = GPIOEXPANDER_ADDRESS, byte resetPin = 0xFF);
+    void resume();
     void turnOnLED();
     void turnOffLED();
     void blinkLED(unsigned long tOn, unsigned long tOff, byte onIntensity = 255, byte offIntensity = 0);
@@ -215,6 +215,8 @@ struct accelSettings
 	int8_t  bandwidth;
 	uint8_t highResEnable;
 	uint8_t highResBandwidth;
+	uint8_t decimation;
+	uint8_t HPFInterruptEnable;
 };
 
 struct magSettings
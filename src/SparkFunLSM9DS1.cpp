@@ -24,6 +24,7 @@ Distributed as-is; no warranty is given.
 #include "SparkFunLSM9DS1.h"
 #include "LSM9DS1_Registers.h"
 #include "LSM9DS1_Types.h"
+#include "AloraIMUBatch.h"
 #include <Wire.h> // Wire library is used for I2C
 #include <SPI.h>  // SPI library is used for...SPI.
 
@@ -113,6 +114,13 @@ void LSM9DS1::init(interface_mode interface, uint8_t xgAddr, uint8_t mAddr)
 	// 0 = ODR/50    2 = ODR/9
 	// 1 = ODR/100   3 = ODR/400
 	settings.accel.highResBandwidth = 0;
+	// accel decimation of output registers and FIFO can be 0-3
+	// 0 = none      2 = 4 samples
+	// 1 = 2 samples 3 = 8 samples
+	settings.accel.decimation = 0;
+	// Feed the accel interrupt generator through the high-pass filter, so
+	// thresholds apply to changes in acceleration instead of gravity.
+	settings.accel.HPFInterruptEnable = false;
 
 	settings.mag.enabled = true;
 	// mag scale can be 4, 8, 12, or 16
@@ -147,10 +155,33 @@ void LSM9DS1::init(interface_mode interface, uint8_t xgAddr, uint8_t mAddr)
 		mBiasRaw[i] = 0;
 	}
 	_autoCalc = false;
+	_calibrating = false;
+	_magCalibrating = false;
+	_calSamples = 0;
+	_magCalSamples = 0;
 }
 
 
 uint16_t LSM9DS1::begin()
+{
+	uint16_t whoAmICombined = attach();
+	if (whoAmICombined == 0)
+		return 0;
+	
+	// Gyro initialization stuff:
+	initGyro();	// This will "turn on" the gyro. Setting up interrupts, etc.
+	
+	// Accelerometer initialization stuff:
+	initAccel(); // "Turn on" all axes of the accel. Set up interrupts, etc.
+	
+	// Magnetometer initialization stuff:
+	initMag(); // "Turn on" all axes of the mag. Set up interrupts, etc.
+
+	// Once everything is initialized, return the WHO_AM_I registers we read:
+	return whoAmICombined;
+}
+
+uint16_t LSM9DS1::attach()
 {
 	//! Todo: don't use _xgAddress or _mAddress, duplicating memory
 	_xgAddress = settings.device.agAddress;
@@ -178,19 +209,21 @@ uint16_t LSM9DS1::begin()
 	if (whoAmICombined != ((WHO_AM_I_AG_RSP << 8) | WHO_AM_I_M_RSP))
 		return 0;
 	
-	// Gyro initialization stuff:
-	initGyro();	// This will "turn on" the gyro. Setting up interrupts, etc.
-	
-	// Accelerometer initialization stuff:
-	initAccel(); // "Turn on" all axes of the accel. Set up interrupts, etc.
-	
-	// Magnetometer initialization stuff:
-	initMag(); // "Turn on" all axes of the mag. Set up interrupts, etc.
-
-	// Once everything is initialized, return the WHO_AM_I registers we read:
 	return whoAmICombined;
 }
 
+void LSM9DS1::applySettings()
+{
+	constrainScales();
+	calcgRes();
+	calcmRes();
+	calcaRes();
+	
+	initGyro();
+	initAccel();
+	initMag();
+}
+
 void LSM9DS1::initGyro()
 {
 	uint8_t tempRegValue = 0;
@@ -274,6 +307,7 @@ void LSM9DS1::initAccel()
 	//	Zen_XL - Z-axis output enabled
 	//	Yen_XL - Y-axis output enabled
 	//	Xen_XL - X-axis output enabled
+	tempRegValue = (settings.accel.decimation & 0x3) << 6;
 	if (settings.accel.enableZ) tempRegValue |= (1<<5);
 	if (settings.accel.enableY) tempRegValue |= (1<<4);
 	if (settings.accel.enableX) tempRegValue |= (1<<3);
@@ -324,6 +358,10 @@ void LSM9DS1::initAccel()
 		tempRegValue |= (1<<7); // Set HR bit
 		tempRegValue |= (settings.accel.highResBandwidth & 0x3) << 5;
 	}
+	if (settings.accel.HPFInterruptEnable)
+	{
+		tempRegValue |= (1<<0); // Set HPIS1 bit
+	}
 	xgWriteByte(CTRL_REG7_XL, tempRegValue);
 }
 
@@ -335,75 +373,189 @@ void LSM9DS1::initAccel()
 // remove errors due to imprecise or varying initial placement. Calibration of sensor data in this manner
 // is good practice.
 void LSM9DS1::calibrate(bool autoCalc)
-{  
-	uint8_t data[6] = {0, 0, 0, 0, 0, 0};
-	uint8_t samples = 0;
-	int ii;
-	int32_t aBiasRawTemp[3] = {0, 0, 0};
-	int32_t gBiasRawTemp[3] = {0, 0, 0};
+{
+	beginCalibration(autoCalc);
+	while (isCalibrating())
+		updateCalibration();
+}
+
+void LSM9DS1::calibrateMag(bool loadIn)
+{
+	beginMagCalibration(loadIn);
+	while (isMagCalibrating())
+		updateCalibration();
+}
+
+void LSM9DS1::beginCalibration(bool autoCalc)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		_gBiasSum[i] = 0;
+		_aBiasSum[i] = 0;
+	}
+	_calSamples = 0;
+	_calAutoCalc = autoCalc;
+	_calibrating = true;
 	
-	// Turn on FIFO and set threshold to 32 samples
+	// Turn on FIFO and let it fill up to 32 samples, it is drained
+	// in bursts by updateCalibration()
 	enableFIFO(true);
 	setFIFO(FIFO_THS, 0x1F);
-	while (samples < 0x1F)
+}
+
+void LSM9DS1::beginMagCalibration(bool loadIn)
+{
+	_magCalSamples = 0;
+	_magLoadIn = loadIn;
+	_magCalibrating = true;
+	
+	// Clear a previously loaded offset so min/max are found on raw readings
+	if (loadIn)
+	{
+		for (uint8_t j = 0; j < 3; j++)
+			magOffset(j, 0);
+	}
+}
+
+bool LSM9DS1::updateCalibration()
+{
+	if (_calibrating)
+		updateAGCalibration();
+	if (_magCalibrating)
+		updateMagCalibration();
+	
+	return _calibrating || _magCalibrating;
+}
+
+void LSM9DS1::updateAGCalibration()
+{
+	int16_t gyroRaw[3 * LSM9DS1_CALIBRATION_SAMPLES];
+	int16_t accelRaw[3 * LSM9DS1_CALIBRATION_SAMPLES];
+	uint8_t samples = readFIFO(gyroRaw, accelRaw, LSM9DS1_CALIBRATION_SAMPLES - _calSamples);
+	int ii;
+	
+	for (ii = 0; ii < samples; ii++)
 	{
-		samples = (xgReadByte(FIFO_SRC) & 0x3F); // Read number of stored samples
+		_gBiasSum[0] += gyroRaw[3 * ii];
+		_gBiasSum[1] += gyroRaw[3 * ii + 1];
+		_gBiasSum[2] += gyroRaw[3 * ii + 2];
+		_aBiasSum[0] += accelRaw[3 * ii];
+		_aBiasSum[1] += accelRaw[3 * ii + 1];
+		_aBiasSum[2] += accelRaw[3 * ii + 2] - (int16_t)(1./aRes); // Assumes sensor facing up!
 	}
-	for(ii = 0; ii < samples ; ii++) 
-	{	// Read the gyro data stored in the FIFO
-		readGyro();
-		gBiasRawTemp[0] += gx;
-		gBiasRawTemp[1] += gy;
-		gBiasRawTemp[2] += gz;
-		readAccel();
-		aBiasRawTemp[0] += ax;
-		aBiasRawTemp[1] += ay;
-		aBiasRawTemp[2] += az - (int16_t)(1./aRes); // Assumes sensor facing up!
-	}  
+	_calSamples += samples;
+	
+	if (_calSamples < LSM9DS1_CALIBRATION_SAMPLES)
+		return;
+	
 	for (ii = 0; ii < 3; ii++)
 	{
-		gBiasRaw[ii] = gBiasRawTemp[ii] / samples;
+		gBiasRaw[ii] = _gBiasSum[ii] / _calSamples;
 		gBias[ii] = calcGyro(gBiasRaw[ii]);
-		aBiasRaw[ii] = aBiasRawTemp[ii] / samples;
+		aBiasRaw[ii] = _aBiasSum[ii] / _calSamples;
 		aBias[ii] = calcAccel(aBiasRaw[ii]);
 	}
 	
 	enableFIFO(false);
 	setFIFO(FIFO_OFF, 0x00);
 	
-	if (autoCalc) _autoCalc = true;
+	if (_calAutoCalc) _autoCalc = true;
+	_calibrating = false;
 }
 
-void LSM9DS1::calibrateMag(bool loadIn)
+void LSM9DS1::updateMagCalibration()
 {
-	int i, j;
-	int16_t magMin[3] = {0, 0, 0};
-	int16_t magMax[3] = {0, 0, 0}; // The road warrior
+	if (!magAvailable())
+		return;
 	
-	for (i=0; i<128; i++)
+	readMag();
+	int16_t magTemp[3] = {mx, my, mz};
+	int j;
+	for (j = 0; j < 3; j++)
 	{
-		while (!magAvailable())
-			;
-		readMag();
-		int16_t magTemp[3] = {0, 0, 0};
-		magTemp[0] = mx;		
-		magTemp[1] = my;
-		magTemp[2] = mz;
-		for (j = 0; j < 3; j++)
-		{
-			if (magTemp[j] > magMax[j]) magMax[j] = magTemp[j];
-			if (magTemp[j] < magMin[j]) magMin[j] = magTemp[j];
-		}
+		if ((_magCalSamples == 0) || (magTemp[j] > _magMax[j])) _magMax[j] = magTemp[j];
+		if ((_magCalSamples == 0) || (magTemp[j] < _magMin[j])) _magMin[j] = magTemp[j];
 	}
+	_magCalSamples++;
+	
+	if (_magCalSamples < LSM9DS1_MAG_CALIBRATION_SAMPLES)
+		return;
+	
 	for (j = 0; j < 3; j++)
 	{
-		mBiasRaw[j] = (magMax[j] + magMin[j]) / 2;
+		mBiasRaw[j] = ((int32_t)_magMax[j] + _magMin[j]) / 2;
 		mBias[j] = calcMag(mBiasRaw[j]);
+		if (_magLoadIn)
+			magOffset(j, mBiasRaw[j]);
+	}
+	_magCalibrating = false;
+}
+
+bool LSM9DS1::isCalibrating()
+{
+	return _calibrating;
+}
+
+bool LSM9DS1::isMagCalibrating()
+{
+	return _magCalibrating;
+}
+
+uint8_t LSM9DS1::calibrationProgress()
+{
+	if (!_calibrating)
+		return 100;
+	return (uint16_t)_calSamples * 100 / LSM9DS1_CALIBRATION_SAMPLES;
+}
+
+uint8_t LSM9DS1::magCalibrationProgress()
+{
+	if (!_magCalibrating)
+		return 100;
+	return (uint16_t)_magCalSamples * 100 / LSM9DS1_MAG_CALIBRATION_SAMPLES;
+}
+
+void LSM9DS1::setAutoCalc(bool enable)
+{
+	_autoCalc = enable;
+}
+
+bool LSM9DS1::getAutoCalc()
+{
+	return _autoCalc;
+}
+
+void LSM9DS1::setCalibration(const float gyroBias[3], const float accelBias[3])
+{
+	for (int ii = 0; ii < 3; ii++)
+	{
+		aBias[ii] = accelBias[ii];
+		aBiasRaw[ii] = (int16_t)(accelBias[ii] / aRes + (accelBias[ii] < 0 ? -0.5f : 0.5f));
+	}
+	setGyroBias(gyroBias);
+}
+
+void LSM9DS1::setGyroBias(const float gyroBias[3])
+{
+	for (int ii = 0; ii < 3; ii++)
+	{
+		gBias[ii] = gyroBias[ii];
+		gBiasRaw[ii] = (int16_t)(gyroBias[ii] / gRes + (gyroBias[ii] < 0 ? -0.5f : 0.5f));
+	}
+	_autoCalc = true;
+}
+
+void LSM9DS1::setMagCalibration(const float magBias[3], bool loadIn)
+{
+	for (int j = 0; j < 3; j++)
+	{
+		mBias[j] = magBias[j];
+		mBiasRaw[j] = (int16_t)(magBias[j] / mRes + (magBias[j] < 0 ? -0.5f : 0.5f));
 		if (loadIn)
 			magOffset(j, mBiasRaw[j]);
 	}
-	
 }
+
 void LSM9DS1::magOffset(uint8_t axis, int16_t offset)
 {
 	if (axis > 2)
@@ -628,6 +780,28 @@ float LSM9DS1::calcMag(int16_t mag)
 	return mRes * mag;
 }
 
+float LSM9DS1::calcTemp(int16_t temp)
+{
+	return 25.0f + temp / 16.0f;
+}
+
+void LSM9DS1::calcGyroBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z)
+{
+	// Raw blocks come straight from the FIFO, so bias has not been removed yet
+	AloraIMUBatch::convert(raw, count, _autoCalc ? gBiasRaw : NULL, gRes, x, y, z);
+}
+
+void LSM9DS1::calcAccelBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z)
+{
+	AloraIMUBatch::convert(raw, count, _autoCalc ? aBiasRaw : NULL, aRes, x, y, z);
+}
+
+void LSM9DS1::calcMagBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z)
+{
+	// Magnetometer offset is applied by the sensor itself (see magOffset())
+	AloraIMUBatch::convert(raw, count, NULL, mRes, x, y, z);
+}
+
 void LSM9DS1::setGyroScale(uint16_t gScl)
 {
 	// Read current value of CTRL_REG1_G:
@@ -1003,6 +1177,32 @@ uint8_t LSM9DS1::getFIFOSamples()
 	return (xgReadByte(FIFO_SRC) & 0x3F);
 }
 
+uint8_t LSM9DS1::readFIFO(int16_t * gyroRaw, int16_t * accelRaw, uint8_t maxSamples)
+{
+	uint8_t samples = getFIFOSamples();
+	if (samples > maxSamples)
+		samples = maxSamples;
+	
+	uint8_t temp[6];
+	for (uint8_t i = 0; i < samples; i++)
+	{
+		// Reading both gyro and accel output registers pops one FIFO slot
+		if (xgReadBytes(OUT_X_L_G, temp, 6) != 6)
+			return i;
+		gyroRaw[3 * i] = (temp[1] << 8) | temp[0];
+		gyroRaw[3 * i + 1] = (temp[3] << 8) | temp[2];
+		gyroRaw[3 * i + 2] = (temp[5] << 8) | temp[4];
+		
+		if (xgReadBytes(OUT_X_L_XL, temp, 6) != 6)
+			return i;
+		accelRaw[3 * i] = (temp[1] << 8) | temp[0];
+		accelRaw[3 * i + 1] = (temp[3] << 8) | temp[2];
+		accelRaw[3 * i + 2] = (temp[5] << 8) | temp[4];
+	}
+	
+	return samples;
+}
+
 void LSM9DS1::constrainScales()
 {
 	if ((settings.gyro.scale != 245) && (settings.gyro.scale != 500) && 
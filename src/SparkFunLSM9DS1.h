@@ -35,6 +35,11 @@ Distributed as-is; no warranty is given.
 #define LSM9DS1_AG_ADDR(sa0)	((sa0) == 0 ? 0x6A : 0x6B)
 #define LSM9DS1_M_ADDR(sa1)		((sa1) == 0 ? 0x1C : 0x1E)
 
+// Number of samples averaged by the accel/gyro calibration (one full FIFO)
+#define LSM9DS1_CALIBRATION_SAMPLES		32
+// Number of samples used by the magnetometer min/max calibration
+#define LSM9DS1_MAG_CALIBRATION_SAMPLES	128
+
 enum lsm9ds1_axis {
 	X_AXIS,
 	Y_AXIS,
@@ -77,10 +82,79 @@ public:
 	// in the IMUSettings struct will take effect after calling this function.
 	uint16_t begin();
 	
+	// attach() -- Take over a sensor that stayed powered, for example over
+	// deep sleep. The settings struct must hold the configuration the sensor
+	// was set up with, only resolutions are calculated and WHO_AM_I is read.
+	// No register is written.
+	// Output: the WHO_AM_I registers like begin(), 0 if the sensor does not answer.
+	uint16_t attach();
+	
+	// applySettings() -- Write the settings struct to the sensor again, for
+	// example after changing sample rates, scales or power modes at runtime.
+	// Resolutions are recalculated, bias values are kept.
+	void applySettings();
+	
 	void calibrate(bool autoCalc = true);
 	void calibrateMag(bool loadIn = true);
 	void magOffset(uint8_t axis, int16_t offset);
 	
+	// beginCalibration() -- Start a non-blocking accel/gyro calibration.
+	// The FIFO is enabled and drained by updateCalibration(). The sensor must
+	// lie flat and still, facing up, until isCalibrating() returns false.
+	// While it runs, do not call readGyro()/readAccel(), they would pop FIFO
+	// samples.
+	// Input:
+	//	- autoCalc = subtract the resulting bias from subsequent readings.
+	void beginCalibration(bool autoCalc = true);
+	
+	// beginMagCalibration() -- Start a non-blocking magnetometer calibration.
+	// Rotate the sensor through all orientations until isMagCalibrating()
+	// returns false.
+	// Input:
+	//	- loadIn = write the resulting offset to the magnetometer offset registers.
+	void beginMagCalibration(bool loadIn = true);
+	
+	// updateCalibration() -- Advance running calibrations with the samples
+	// available right now. Never waits for new data.
+	// Output: true while any calibration is still running.
+	bool updateCalibration();
+	
+	// isCalibrating() / isMagCalibrating() -- Whether a calibration started
+	// by beginCalibration() / beginMagCalibration() is still running.
+	bool isCalibrating();
+	bool isMagCalibrating();
+	
+	// calibrationProgress() / magCalibrationProgress() -- Progress of the
+	// calibration in percent. 100 when idle.
+	uint8_t calibrationProgress();
+	uint8_t magCalibrationProgress();
+	
+	// setAutoCalc() -- Enable or disable subtraction of gBiasRaw and aBiasRaw
+	// from readGyro() and readAccel() results.
+	void setAutoCalc(bool enable);
+	bool getAutoCalc();
+	
+	// setCalibration() -- Restore accel/gyro biases saved from a previous
+	// calibration. gBiasRaw and aBiasRaw are recomputed for the current
+	// scale, and autoCalc is enabled.
+	// Input:
+	//	- gyroBias = gyroscope bias in DPS for the x, y and z axis.
+	//	- accelBias = accelerometer bias in g's for the x, y and z axis.
+	void setCalibration(const float gyroBias[3], const float accelBias[3]);
+	
+	// setGyroBias() -- Replace the gyroscope bias only, for example with an
+	// estimate tracked while the sensor is still. autoCalc is enabled.
+	// Input:
+	//	- gyroBias = gyroscope bias in DPS for the x, y and z axis.
+	void setGyroBias(const float gyroBias[3]);
+	
+	// setMagCalibration() -- Restore a magnetometer bias saved from a
+	// previous calibration. mBiasRaw is recomputed for the current scale.
+	// Input:
+	//	- magBias = magnetometer bias in Gs for the x, y and z axis.
+	//	- loadIn = write the offset to the magnetometer offset registers.
+	void setMagCalibration(const float magBias[3], bool loadIn = true);
+	
 	// accelAvailable() -- Polls the accelerometer status register to check
 	// if new data is available.
 	// Output:	1 - New data available
@@ -178,6 +252,35 @@ public:
 	//	- mag = A signed 16-bit raw reading from the magnetometer.
 	float calcMag(int16_t mag);
 	
+	// calcTemp() -- Convert from RAW signed 16-bit value to degrees Celsius
+	// The die temperature output is 16 LSB per degree with 0 at 25 degrees.
+	// Input:
+	//	- temp = A signed 16-bit raw reading from the temperature sensor.
+	float calcTemp(int16_t temp);
+	
+	// calcGyroBatch() -- Convert a block of raw gyroscope readings to DPS
+	// Input:
+	//	- raw = Interleaved x, y, z raw readings, 3 * count values.
+	//	- count = Number of x, y, z triples.
+	//	- x, y, z = Output buffers, count values each.
+	// If calibrate() enabled autoCalc, gBiasRaw is subtracted in the same pass.
+	void calcGyroBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z);
+	
+	// calcAccelBatch() -- Convert a block of raw accelerometer readings to g's
+	// Input:
+	//	- raw = Interleaved x, y, z raw readings, 3 * count values.
+	//	- count = Number of x, y, z triples.
+	//	- x, y, z = Output buffers, count values each.
+	// If calibrate() enabled autoCalc, aBiasRaw is subtracted in the same pass.
+	void calcAccelBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z);
+	
+	// calcMagBatch() -- Convert a block of raw magnetometer readings to Gs
+	// Input:
+	//	- raw = Interleaved x, y, z raw readings, 3 * count values.
+	//	- count = Number of x, y, z triples.
+	//	- x, y, z = Output buffers, count values each.
+	void calcMagBatch(const int16_t * raw, uint16_t count, float * x, float * y, float * z);
+	
 	// setGyroScale() -- Set the full-scale range of the gyroscope.
 	// This function can be called to set the scale of the gyroscope to 
 	// 245, 500, or 200 degrees per second.
@@ -328,6 +431,16 @@ public:
 	
 	// getFIFOSamples() - Get number of FIFO samples
 	uint8_t getFIFOSamples();
+	
+	// readFIFO() - Drain gyro and accel samples stored in the FIFO.
+	// The number of stored samples is read once, then every sample is read
+	// with one gyro and one accel burst. Readings are raw, bias is not removed.
+	// Input:
+	//	- gyroRaw = Output buffer for interleaved gyro x, y, z, 3 * maxSamples values.
+	//	- accelRaw = Output buffer for interleaved accel x, y, z, 3 * maxSamples values.
+	//	- maxSamples = Maximum number of samples to read.
+	// Output: Number of samples read.
+	uint8_t readFIFO(int16_t * gyroRaw, int16_t * accelRaw, uint8_t maxSamples);
 		
 
 protected:	
@@ -344,6 +457,17 @@ protected:
 	// accelerometer and gyroscope bias calculated in calibrate().
 	bool _autoCalc;
 	
+	// State of the calibrations advanced by updateCalibration()
+	bool _calibrating, _calAutoCalc;
+	bool _magCalibrating, _magLoadIn;
+	uint8_t _calSamples, _magCalSamples;
+	int32_t _gBiasSum[3], _aBiasSum[3];
+	int16_t _magMin[3], _magMax[3];
+	
+	// Advance each calibration state machine
+	void updateAGCalibration();
+	void updateMagCalibration();
+	
 	// init() -- Sets up gyro, accel, and mag settings to default.
 	// - interface - Sets the interface mode (IMU_MODE_I2C or IMU_MODE_SPI)
 	// - xgAddr - Sets either the I2C address of the accel/gyro or SPI chip 